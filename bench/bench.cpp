@@ -0,0 +1,918 @@
+// This is copyrighted software. More information is at the end of this file.
+/*
+ * Benchmark suite for the decoders, the resamplers and the mixer. Prints the results as JSON to
+ * stdout so they can be stored and compared between builds. Progress goes to stderr.
+ *
+ * Usage: bench [--quick] [--content-dir DIR] [--keep-content]
+ *
+ * The test content is generated on every run. WAV and FLAC files are written with FileSink. MP3,
+ * Ogg Vorbis and Opus files need an external encoder, either ffmpeg or lame, oggenc and opusenc.
+ * Formats without an encoder are listed under "skipped". MIDI and module decoders are not measured,
+ * since there's no way to synthesize content for them.
+ *
+ * - Decoders: every decoder that was built into the library decodes every file it can open, from
+ *   memory, for at least a second. Reported as decoded frames per second and as a multiple of
+ *   realtime.
+ * - Resamplers: every resampler and quality level converts a 44.1kHz and a 96kHz sine tone to
+ *   48kHz. Throughput is reported like for decoders. Quality is the ratio between the fitted sine
+ *   and everything else in the output (distortion, aliasing and noise), together with the gain
+ *   error of the fitted sine.
+ * - Resampler staging: the fastest Speex quality converts an 8kHz and a 192kHz tone, played from
+ *   memory, to 48kHz in requests of 32 to 1024 frames, with a chunk size much larger than that.
+ *   This measures how the resampler's own buffering holds up when callers ask for little at a time.
+ *   Reported as output frames per second.
+ * - Mixer: 1 to 256 looping WAV streams are rendered with renderMix(), once at the output rate and
+ *   once at 44.1kHz through the Speex resampler, with one mixing thread and with one per CPU.
+ *   Reported as time per block and as the fraction of the block's duration that time represents.
+ */
+#include "Aulib/DecoderDrflac.h"
+#include "Aulib/DecoderDrmp3.h"
+#include "Aulib/DecoderDrwav.h"
+#include "Aulib/FileSink.h"
+#include "Aulib/ResamplerSdl.h"
+#include "Aulib/ResamplerSpeex.h"
+#include "Aulib/Stream.h"
+#include "aulib.h"
+#include "aulib_config.h"
+#include "aulib_version.h"
+#include <SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#if USE_DEC_FLAC
+    #include "Aulib/DecoderFlac.h"
+#endif
+#if USE_DEC_MPG123
+    #include "Aulib/DecoderMpg123.h"
+#endif
+#if USE_DEC_LIBOPUSFILE
+    #include "Aulib/DecoderOpus.h"
+#endif
+#if USE_DEC_SNDFILE
+    #include "Aulib/DecoderSndfile.h"
+#endif
+#if USE_DEC_LIBVORBIS
+    #include "Aulib/DecoderVorbis.h"
+#endif
+#if USE_RESAMP_SOXR
+    #include "Aulib/ResamplerSox.h"
+#endif
+#if USE_RESAMP_SRC
+    #include "Aulib/ResamplerSrc.h"
+#endif
+
+using Clock = std::chrono::steady_clock;
+using Seconds = std::chrono::duration<double>;
+
+constexpr double PI = 3.14159265358979323846;
+constexpr int CONTENT_RATE = 44100;
+constexpr int OUTPUT_RATE = 48000;
+constexpr int CHANNELS = 2;
+constexpr int BLOCK_FRAMES = 1024;
+constexpr int QUALITY_WARMUP_FRAMES = 8192;
+constexpr int QUALITY_FRAMES = 32768;
+constexpr float TONE_AMPLITUDE = 0.5f;
+constexpr int STAGING_CHUNK_FRAMES = 4096;
+
+#ifdef _WIN32
+constexpr const char* QUIET = " >NUL 2>&1";
+#else
+constexpr const char* QUIET = " >/dev/null 2>&1";
+#endif
+
+struct Options final
+{
+    bool quick = false;
+    bool keepContent = false;
+    std::string contentDir = ".";
+
+    // Minimum time to spend on each measurement.
+    auto minTime() const -> Seconds
+    {
+        return Seconds(quick ? 0.25 : 1.0);
+    }
+
+    auto contentSeconds() const -> int
+    {
+        return quick ? 3 : 10;
+    }
+};
+
+struct ContentFile final
+{
+    std::string format;
+    std::string path;
+    std::vector<char> data;
+};
+
+struct Skipped final
+{
+    std::string what;
+    std::string reason;
+};
+
+struct DecoderResult final
+{
+    std::string decoder;
+    std::string format;
+    double framesPerSecond;
+    double realtimeFactor;
+};
+
+struct ResamplerResult final
+{
+    std::string resampler;
+    int srcRate;
+    double framesPerSecond;
+    double realtimeFactor;
+    double snr1k;
+    double gain1k;
+    double snr15k;
+    double gain15k;
+};
+
+struct StagingResult final
+{
+    int srcRate;
+    int requestFrames;
+    double framesPerSecond;
+};
+
+struct MixerResult final
+{
+    std::string source;
+    int threads;
+    int streams;
+    double meanBlockUs;
+    double maxBlockUs;
+    double meanLoad;
+    double usPerStream;
+};
+
+struct DecoderEntry final
+{
+    const char* name;
+    std::function<std::unique_ptr<Aulib::Decoder>()> make;
+};
+
+struct ResamplerEntry final
+{
+    std::string name;
+    std::function<std::unique_ptr<Aulib::Resampler>()> make;
+};
+
+// Generates an endless sine tone, the same on every channel.
+class ToneDecoder final: public Aulib::Decoder
+{
+public:
+    ToneDecoder(const int rate, const double freq)
+        : fRate(rate)
+        , fFreq(freq)
+    {}
+
+    auto open(SDL_RWops* /*rwops*/) -> bool override
+    {
+        setIsOpen(true);
+        return true;
+    }
+
+    auto getChannels() const -> int override
+    {
+        return CHANNELS;
+    }
+
+    auto getRate() const -> int override
+    {
+        return fRate;
+    }
+
+    auto rewind() -> bool override
+    {
+        fPos = 0;
+        return true;
+    }
+
+    auto duration() const -> std::chrono::microseconds override
+    {
+        return {};
+    }
+
+    auto seekToTime(std::chrono::microseconds /*pos*/) -> bool override
+    {
+        return false;
+    }
+
+protected:
+    auto doDecoding(float buf[], const int len, bool& /*callAgain*/) -> int override
+    {
+        const int frames = len / CHANNELS;
+        for (int i = 0; i < frames; ++i) {
+            const auto sample = static_cast<float>(
+                TONE_AMPLITUDE * std::sin(2.0 * PI * fFreq * static_cast<double>(fPos++) / fRate));
+            for (int chan = 0; chan < CHANNELS; ++chan) {
+                buf[i * CHANNELS + chan] = sample;
+            }
+        }
+        return frames * CHANNELS;
+    }
+
+private:
+    int fRate;
+    double fFreq;
+    Sint64 fPos = 0;
+};
+
+// Plays the same tone as ToneDecoder from a table of one second. Cheap enough that it doesn't hide
+// the cost of what's measured.
+class TableDecoder final: public Aulib::Decoder
+{
+public:
+    TableDecoder(const int rate, const double freq)
+        : fRate(rate)
+        , fTable(static_cast<size_t>(rate) * CHANNELS)
+    {
+        for (int i = 0; i < rate; ++i) {
+            const auto sample =
+                static_cast<float>(TONE_AMPLITUDE * std::sin(2.0 * PI * freq * i / rate));
+            std::fill_n(fTable.begin() + i * CHANNELS, CHANNELS, sample);
+        }
+    }
+
+    auto open(SDL_RWops* /*rwops*/) -> bool override
+    {
+        setIsOpen(true);
+        return true;
+    }
+
+    auto getChannels() const -> int override
+    {
+        return CHANNELS;
+    }
+
+    auto getRate() const -> int override
+    {
+        return fRate;
+    }
+
+    auto rewind() -> bool override
+    {
+        fPos = 0;
+        return true;
+    }
+
+    auto duration() const -> std::chrono::microseconds override
+    {
+        return {};
+    }
+
+    auto seekToTime(std::chrono::microseconds /*pos*/) -> bool override
+    {
+        return false;
+    }
+
+protected:
+    auto doDecoding(float buf[], const int len, bool& /*callAgain*/) -> int override
+    {
+        const int tableLen = static_cast<int>(fTable.size());
+        for (int done = 0; done < len;) {
+            const int count = std::min(len - done, tableLen - fPos);
+            std::copy_n(fTable.begin() + fPos, count, buf + done);
+            done += count;
+            fPos = (fPos + count) % tableLen;
+        }
+        return len;
+    }
+
+private:
+    int fRate;
+    std::vector<float> fTable;
+    int fPos = 0;
+};
+
+static auto parseOptions(const int argc, char* argv[], Options& opts) -> bool
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--quick") {
+            opts.quick = true;
+        } else if (arg == "--keep-content") {
+            opts.keepContent = true;
+        } else if (arg == "--content-dir" and i + 1 < argc) {
+            opts.contentDir = argv[++i];
+        } else {
+            std::fprintf(stderr, "Usage: %s [--quick] [--content-dir DIR] [--keep-content]\n",
+                         argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static auto fileSize(const std::string& path) -> long
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? static_cast<long>(file.tellg()) : 0;
+}
+
+static auto readFile(const std::string& path) -> std::vector<char>
+{
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+// Runs a shell command with its output suppressed. Only succeeds if the command created 'output'.
+static auto runEncoder(const std::string& command, const std::string& output) -> bool
+{
+    std::remove(output.c_str());
+    return std::system((command + QUIET).c_str()) == 0 and fileSize(output) > 0;
+}
+
+// A few sines with slow amplitude modulation and a bit of noise, so that lossy encoders have to
+// do some actual work.
+static void writeSignal(Aulib::FileSink& sink, const int rate, const int seconds)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+    std::vector<float> buf(BLOCK_FRAMES * CHANNELS);
+    const Sint64 totalFrames = static_cast<Sint64>(rate) * seconds;
+
+    for (Sint64 pos = 0; pos < totalFrames; pos += BLOCK_FRAMES) {
+        const int frames = static_cast<int>(std::min<Sint64>(BLOCK_FRAMES, totalFrames - pos));
+        for (int i = 0; i < frames; ++i) {
+            const double t = static_cast<double>(pos + i) / rate;
+            const double am = 0.6 + 0.4 * std::sin(2.0 * PI * 0.5 * t);
+            for (int chan = 0; chan < CHANNELS; ++chan) {
+                const double phase = chan * 0.25;
+                const double value = 0.3 * std::sin(2.0 * PI * 220.0 * t + phase)
+                                     + 0.15 * std::sin(2.0 * PI * 1375.0 * t + phase)
+                                     + 0.08 * std::sin(2.0 * PI * 5500.0 * t + phase);
+                buf[i * CHANNELS + chan] = static_cast<float>(am * value) + noise(rng);
+            }
+        }
+        sink.write(buf.data(), frames);
+    }
+}
+
+static auto writeWithSink(const Aulib::FileSink::FileFormat format, const std::string& path,
+                          const int seconds) -> bool
+{
+    Aulib::FileSink sink(format);
+    if (not sink.open(path)) {
+        return false;
+    }
+    writeSignal(sink, Aulib::sampleRate(), seconds);
+    return sink.close();
+}
+
+static auto generateContent(const Options& opts, std::vector<ContentFile>& files,
+                            std::vector<Skipped>& skipped) -> bool
+{
+    const auto path = [&](const char* name) { return opts.contentDir + "/aulib-bench-" + name; };
+    const std::string wavS16 = path("s16.wav");
+    const std::string wavFloat = path("float.wav");
+    const std::string flac = path("24.flac");
+    const std::string mp3 = path("192k.mp3");
+    const std::string ogg = path("q5.ogg");
+    const std::string opus = path("128k.opus");
+    const std::string quoted = "\"" + wavS16 + "\"";
+
+    std::fprintf(stderr, "Generating %d second test files in %s\n", opts.contentSeconds(),
+                 opts.contentDir.c_str());
+
+    if (not Aulib::initWithoutOutput(CONTENT_RATE, CHANNELS)) {
+        std::fprintf(stderr, "Failed to initialize: %s\n", SDL_GetError());
+        return false;
+    }
+    const bool ok = writeWithSink(Aulib::FileSink::FileFormat::WavS16, wavS16,
+                                  opts.contentSeconds())
+                    and writeWithSink(Aulib::FileSink::FileFormat::WavFloat, wavFloat,
+                                      opts.contentSeconds());
+    if (not ok) {
+        std::fprintf(stderr, "Failed to write WAV files: %s\n", SDL_GetError());
+        Aulib::quit();
+        return false;
+    }
+    files.push_back({"wav_s16", wavS16, {}});
+    files.push_back({"wav_float", wavFloat, {}});
+
+    if (writeWithSink(Aulib::FileSink::FileFormat::Flac, flac, opts.contentSeconds())
+        or runEncoder("ffmpeg -v error -y -i " + quoted + " -c:a flac \"" + flac + "\"", flac)
+        or runEncoder("flac --silent -f -o \"" + flac + "\" " + quoted, flac))
+    {
+        files.push_back({"flac", flac, {}});
+    } else {
+        skipped.push_back({"flac", "no FLAC encoder"});
+    }
+    Aulib::quit();
+
+    if (runEncoder("ffmpeg -v error -y -i " + quoted + " -c:a libmp3lame -b:a 192k \"" + mp3
+                       + "\"",
+                   mp3)
+        or runEncoder("lame --quiet -b 192 " + quoted + " \"" + mp3 + "\"", mp3))
+    {
+        files.push_back({"mp3", mp3, {}});
+    } else {
+        skipped.push_back({"mp3", "neither ffmpeg nor lame found"});
+    }
+
+    if (runEncoder("ffmpeg -v error -y -i " + quoted + " -c:a libvorbis -q:a 5 \"" + ogg + "\"",
+                   ogg)
+        or runEncoder("oggenc -Q -q 5 -o \"" + ogg + "\" " + quoted, ogg))
+    {
+        files.push_back({"ogg_vorbis", ogg, {}});
+    } else {
+        skipped.push_back({"ogg_vorbis", "neither ffmpeg nor oggenc found"});
+    }
+
+    if (runEncoder("ffmpeg -v error -y -i " + quoted + " -c:a libopus -b:a 128k \"" + opus
+                       + "\"",
+                   opus)
+        or runEncoder("opusenc --quiet --bitrate 128 " + quoted + " \"" + opus + "\"", opus))
+    {
+        files.push_back({"opus", opus, {}});
+    } else {
+        skipped.push_back({"opus", "neither ffmpeg nor opusenc found"});
+    }
+
+    for (auto& file : files) {
+        file.data = readFile(file.path);
+    }
+    return true;
+}
+
+static auto decoderEntries() -> std::vector<DecoderEntry>
+{
+    std::vector<DecoderEntry> entries{
+        {"DecoderDrwav", [] { return std::make_unique<Aulib::DecoderDrwav>(); }},
+        {"DecoderDrflac", [] { return std::make_unique<Aulib::DecoderDrflac>(); }},
+        {"DecoderDrmp3", [] { return std::make_unique<Aulib::DecoderDrmp3>(); }},
+    };
+#if USE_DEC_SNDFILE
+    entries.push_back({"DecoderSndfile", [] { return std::make_unique<Aulib::DecoderSndfile>(); }});
+#endif
+#if USE_DEC_FLAC
+    entries.push_back({"DecoderFlac", [] { return std::make_unique<Aulib::DecoderFlac>(); }});
+#endif
+#if USE_DEC_MPG123
+    entries.push_back({"DecoderMpg123", [] { return std::make_unique<Aulib::DecoderMpg123>(); }});
+#endif
+#if USE_DEC_LIBVORBIS
+    entries.push_back({"DecoderVorbis", [] { return std::make_unique<Aulib::DecoderVorbis>(); }});
+#endif
+#if USE_DEC_LIBOPUSFILE
+    entries.push_back({"DecoderOpus", [] { return std::make_unique<Aulib::DecoderOpus>(); }});
+#endif
+    return entries;
+}
+
+static auto resamplerEntries() -> std::vector<ResamplerEntry>
+{
+    std::vector<ResamplerEntry> entries;
+    for (int quality : {0, 3, 5, 8, 10}) {
+        entries.push_back({"ResamplerSpeex/" + std::to_string(quality),
+                           [quality] { return std::make_unique<Aulib::ResamplerSpeex>(quality); }});
+    }
+#if SDL_VERSION_ATLEAST(2, 0, 7)
+    entries.push_back({"ResamplerSdl", [] { return std::make_unique<Aulib::ResamplerSdl>(); }});
+#endif
+#if USE_RESAMP_SRC
+    using SrcQuality = Aulib::ResamplerSrc::Quality;
+    const std::pair<const char*, SrcQuality> srcQualities[]{
+        {"Linear", SrcQuality::Linear},
+        {"ZeroOrderHold", SrcQuality::ZeroOrderHold},
+        {"SincFastest", SrcQuality::SincFastest},
+        {"SincMedium", SrcQuality::SincMedium},
+        {"SincBest", SrcQuality::SincBest},
+    };
+    for (const auto& quality : srcQualities) {
+        entries.push_back(
+            {std::string("ResamplerSrc/") + quality.first,
+             [q = quality.second] { return std::make_unique<Aulib::ResamplerSrc>(q); }});
+    }
+#endif
+#if USE_RESAMP_SOXR
+    using SoxQuality = Aulib::ResamplerSox::Quality;
+    const std::pair<const char*, SoxQuality> soxQualities[]{
+        {"Quick", SoxQuality::Quick},   {"Low", SoxQuality::Low},
+        {"Medium", SoxQuality::Medium}, {"High", SoxQuality::High},
+        {"VeryHigh", SoxQuality::VeryHigh},
+    };
+    for (const auto& quality : soxQualities) {
+        entries.push_back(
+            {std::string("ResamplerSox/") + quality.first,
+             [q = quality.second] { return std::make_unique<Aulib::ResamplerSox>(q); }});
+    }
+#endif
+    return entries;
+}
+
+// Decodes the whole file once. Returns the amount of frames, or -1 if the decoder can't open it.
+static auto decodeOnce(const DecoderEntry& entry, const ContentFile& file, std::vector<float>& buf)
+    -> Sint64
+{
+    auto* rwops = SDL_RWFromConstMem(file.data.data(), static_cast<int>(file.data.size()));
+    auto decoder = entry.make();
+    if (rwops == nullptr or not decoder->open(rwops)) {
+        if (rwops != nullptr) {
+            SDL_RWclose(rwops);
+        }
+        return -1;
+    }
+
+    const int channels = decoder->getChannels();
+    const int len = static_cast<int>(buf.size()) / channels * channels;
+    Sint64 frames = 0;
+    bool callAgain = false;
+    int decoded;
+    while ((decoded = decoder->decode(buf.data(), len, callAgain)) > 0 or callAgain) {
+        frames += decoded / channels;
+    }
+    decoder.reset();
+    SDL_RWclose(rwops);
+    return frames;
+}
+
+static auto benchDecoders(const Options& opts, const std::vector<ContentFile>& files)
+    -> std::vector<DecoderResult>
+{
+    std::vector<DecoderResult> results;
+    std::vector<float> buf(BLOCK_FRAMES * 8);
+
+    for (const auto& entry : decoderEntries()) {
+        for (const auto& file : files) {
+            if (decodeOnce(entry, file, buf) <= 0) {
+                continue;
+            }
+            std::fprintf(stderr, "Decoding %s with %s\n", file.format.c_str(), entry.name);
+
+            Sint64 frames = 0;
+            const auto start = Clock::now();
+            Seconds elapsed{};
+            do {
+                frames += decodeOnce(entry, file, buf);
+                elapsed = Clock::now() - start;
+            } while (elapsed < opts.minTime());
+
+            const double framesPerSecond = frames / elapsed.count();
+            results.push_back(
+                {entry.name, file.format, framesPerSecond, framesPerSecond / CONTENT_RATE});
+        }
+    }
+    return results;
+}
+
+static auto makeResampler(const ResamplerEntry& entry, const int srcRate, const double freq)
+    -> std::unique_ptr<Aulib::Resampler>
+{
+    auto decoder = std::make_shared<ToneDecoder>(srcRate, freq);
+    decoder->open(nullptr);
+    auto resampler = entry.make();
+    resampler->setDecoder(decoder);
+    resampler->setSpec(OUTPUT_RATE, CHANNELS, BLOCK_FRAMES);
+    return resampler;
+}
+
+// Least-squares fit of a sine of the given frequency (plus DC) to the first channel. Stores the
+// gain of the fitted sine relative to the tone amplitude and the ratio between the fitted sine and
+// the residual, both in dB.
+static void fitSine(const std::vector<float>& buf, const double freq, double& gainDb,
+                    double& snrDb)
+{
+    const int frames = static_cast<int>(buf.size()) / CHANNELS;
+    // Normal equations for x ≈ a·sin + b·cos + c.
+    double ss = 0, sc = 0, s1 = 0, cc = 0, c1 = 0, n = frames;
+    double xs = 0, xc = 0, x1 = 0;
+    for (int i = 0; i < frames; ++i) {
+        const double w = 2.0 * PI * freq * i / OUTPUT_RATE;
+        const double s = std::sin(w);
+        const double c = std::cos(w);
+        const double x = buf[i * CHANNELS];
+        ss += s * s;
+        sc += s * c;
+        s1 += s;
+        cc += c * c;
+        c1 += c;
+        xs += x * s;
+        xc += x * c;
+        x1 += x;
+    }
+    const auto det3 = [](double a, double b, double c, double d, double e, double f, double g,
+                         double h, double k) {
+        return a * (e * k - f * h) - b * (d * k - f * g) + c * (d * h - e * g);
+    };
+    const double det = det3(ss, sc, s1, sc, cc, c1, s1, c1, n);
+    const double a = det3(xs, sc, s1, xc, cc, c1, x1, c1, n) / det;
+    const double b = det3(ss, xs, s1, sc, xc, c1, s1, x1, n) / det;
+    const double dc = det3(ss, sc, xs, sc, cc, xc, s1, c1, x1) / det;
+
+    double signal = 0;
+    double residual = 0;
+    for (int i = 0; i < frames; ++i) {
+        const double w = 2.0 * PI * freq * i / OUTPUT_RATE;
+        const double fit = a * std::sin(w) + b * std::cos(w) + dc;
+        const double err = buf[i * CHANNELS] - fit;
+        signal += (fit - dc) * (fit - dc);
+        residual += err * err;
+    }
+    gainDb = 20.0 * std::log10(std::sqrt(a * a + b * b) / TONE_AMPLITUDE);
+    snrDb = 10.0 * std::log10(signal / std::max(residual, 1e-30));
+}
+
+// Fills the whole buffer. Fails if the resampler stops producing output.
+static auto fill(Aulib::Resampler& resampler, std::vector<float>& buf) -> bool
+{
+    const int len = static_cast<int>(buf.size());
+    for (int pos = 0; pos < len;) {
+        const int resampled = resampler.resample(buf.data() + pos, len - pos);
+        if (resampled <= 0) {
+            return false;
+        }
+        pos += resampled;
+    }
+    return true;
+}
+
+static auto measureQuality(const ResamplerEntry& entry, const int srcRate, const double freq,
+                           double& gainDb, double& snrDb) -> bool
+{
+    auto resampler = makeResampler(entry, srcRate, freq);
+    std::vector<float> warmup(QUALITY_WARMUP_FRAMES * CHANNELS);
+    std::vector<float> buf(QUALITY_FRAMES * CHANNELS);
+    if (not fill(*resampler, warmup) or not fill(*resampler, buf)) {
+        return false;
+    }
+    fitSine(buf, freq, gainDb, snrDb);
+    return true;
+}
+
+static auto benchResamplers(const Options& opts, std::vector<Skipped>& skipped)
+    -> std::vector<ResamplerResult>
+{
+    std::vector<ResamplerResult> results;
+    std::vector<float> buf(BLOCK_FRAMES * CHANNELS);
+
+    for (const auto& entry : resamplerEntries()) {
+        for (int srcRate : {44100, 96000}) {
+            std::fprintf(stderr, "Resampling %d to %d with %s\n", srcRate, OUTPUT_RATE,
+                         entry.name.c_str());
+            ResamplerResult result{};
+            result.resampler = entry.name;
+            result.srcRate = srcRate;
+
+            auto resampler = makeResampler(entry, srcRate, 1000.0);
+            if (not fill(*resampler, buf)) {
+                skipped.push_back({entry.name, "produced no output"});
+                break;
+            }
+            Sint64 samples = 0;
+            const auto start = Clock::now();
+            Seconds elapsed{};
+            do {
+                for (int i = 0; i < 16; ++i) {
+                    samples += resampler->resample(buf.data(), static_cast<int>(buf.size()));
+                }
+                elapsed = Clock::now() - start;
+            } while (elapsed < opts.minTime());
+            result.framesPerSecond = samples / CHANNELS / elapsed.count();
+            result.realtimeFactor = result.framesPerSecond / OUTPUT_RATE;
+
+            if (measureQuality(entry, srcRate, 1000.0, result.gain1k, result.snr1k)
+                and measureQuality(entry, srcRate, 15000.0, result.gain15k, result.snr15k))
+            {
+                results.push_back(result);
+            }
+        }
+    }
+    return results;
+}
+
+static auto benchStaging(const Options& opts) -> std::vector<StagingResult>
+{
+    std::vector<StagingResult> results;
+
+    for (int srcRate : {8000, 192000}) {
+        for (int request : {32, 128, 1024}) {
+            std::fprintf(stderr, "Resampling %d to %d in requests of %d frames\n", srcRate,
+                         OUTPUT_RATE, request);
+            auto decoder = std::make_shared<TableDecoder>(srcRate, 1000.0);
+            decoder->open(nullptr);
+            Aulib::ResamplerSpeex resampler(0);
+            resampler.setDecoder(decoder);
+            resampler.setSpec(OUTPUT_RATE, CHANNELS, STAGING_CHUNK_FRAMES);
+            std::vector<float> buf(request * CHANNELS);
+
+            Sint64 samples = 0;
+            const auto start = Clock::now();
+            Seconds elapsed{};
+            do {
+                for (int i = 0; i < 256; ++i) {
+                    samples += resampler.resample(buf.data(), static_cast<int>(buf.size()));
+                }
+                elapsed = Clock::now() - start;
+            } while (elapsed < opts.minTime());
+            results.push_back({srcRate, request, samples / CHANNELS / elapsed.count()});
+        }
+    }
+    return results;
+}
+
+static auto benchMixer(const Options& opts, const ContentFile& native,
+                       const ContentFile& resampled) -> std::vector<MixerResult>
+{
+    std::vector<MixerResult> results;
+    std::vector<float> buf(BLOCK_FRAMES * CHANNELS);
+    const double blockUs = 1e6 * BLOCK_FRAMES / OUTPUT_RATE;
+    std::vector<int> threadCounts{1};
+    if (SDL_GetCPUCount() > 1) {
+        threadCounts.push_back(SDL_GetCPUCount());
+    }
+
+    for (const auto* file : {&native, &resampled}) {
+        const bool resample = file == &resampled;
+        for (int threads : threadCounts) {
+            Aulib::setMixThreadCount(threads);
+            for (int count : {1, 4, 16, 64, 256}) {
+                std::fprintf(stderr, "Mixing %d %s streams with %d threads\n", count,
+                             resample ? "resampled" : "native", threads);
+
+                std::vector<std::unique_ptr<Aulib::Stream>> streams;
+                for (int i = 0; i < count; ++i) {
+                    auto* rwops = SDL_RWFromConstMem(file->data.data(),
+                                                     static_cast<int>(file->data.size()));
+                    auto resampler = resample ? std::make_unique<Aulib::ResamplerSpeex>()
+                                              : std::unique_ptr<Aulib::ResamplerSpeex>();
+                    streams.push_back(std::make_unique<Aulib::Stream>(
+                        rwops, std::make_unique<Aulib::DecoderDrwav>(), std::move(resampler),
+                        true));
+                    streams.back()->play(0);
+                }
+                for (int i = 0; i < 8; ++i) {
+                    Aulib::renderMix(buf.data(), BLOCK_FRAMES);
+                }
+
+                int blocks = 0;
+                Seconds total{};
+                Seconds worst{};
+                do {
+                    const auto start = Clock::now();
+                    Aulib::renderMix(buf.data(), BLOCK_FRAMES);
+                    const Seconds elapsed = Clock::now() - start;
+                    total += elapsed;
+                    worst = std::max(worst, elapsed);
+                    ++blocks;
+                } while (total < opts.minTime() or blocks < 16);
+
+                const double meanUs = 1e6 * total.count() / blocks;
+                results.push_back({resample ? "wav_44100_speex" : "wav_48000", threads, count,
+                                   meanUs, 1e6 * worst.count(), meanUs / blockUs,
+                                   meanUs / count});
+            }
+        }
+    }
+    Aulib::setMixThreadCount(1);
+    return results;
+}
+
+static void printJson(const Options& opts, const std::vector<Skipped>& skipped,
+                      const std::vector<DecoderResult>& decoders,
+                      const std::vector<ResamplerResult>& resamplers,
+                      const std::vector<StagingResult>& staging,
+                      const std::vector<MixerResult>& mixer)
+{
+    const auto sep = [](const size_t i, const size_t size) { return i + 1 < size ? "," : ""; };
+
+    std::printf("{\n");
+    std::printf("  \"version\": \"%s\",\n", AULIB_VERSION_STR);
+    std::printf("  \"quick\": %s,\n", opts.quick ? "true" : "false");
+    std::printf("  \"cpus\": %d,\n", SDL_GetCPUCount());
+    std::printf("  \"block_frames\": %d,\n", BLOCK_FRAMES);
+    std::printf("  \"output_rate\": %d,\n", OUTPUT_RATE);
+
+    std::printf("  \"skipped\": [\n");
+    for (size_t i = 0; i < skipped.size(); ++i) {
+        std::printf("    {\"what\": \"%s\", \"reason\": \"%s\"}%s\n", skipped[i].what.c_str(),
+                    skipped[i].reason.c_str(), sep(i, skipped.size()));
+    }
+    std::printf("  ],\n");
+
+    std::printf("  \"decoders\": [\n");
+    for (size_t i = 0; i < decoders.size(); ++i) {
+        const auto& r = decoders[i];
+        std::printf("    {\"decoder\": \"%s\", \"format\": \"%s\", \"frames_per_sec\": %.0f, "
+                    "\"realtime\": %.1f}%s\n",
+                    r.decoder.c_str(), r.format.c_str(), r.framesPerSecond, r.realtimeFactor,
+                    sep(i, decoders.size()));
+    }
+    std::printf("  ],\n");
+
+    std::printf("  \"resamplers\": [\n");
+    for (size_t i = 0; i < resamplers.size(); ++i) {
+        const auto& r = resamplers[i];
+        std::printf("    {\"resampler\": \"%s\", \"src_rate\": %d, \"frames_per_sec\": %.0f, "
+                    "\"realtime\": %.1f, \"snr_db_1k\": %.1f, \"gain_db_1k\": %.3f, "
+                    "\"snr_db_15k\": %.1f, \"gain_db_15k\": %.3f}%s\n",
+                    r.resampler.c_str(), r.srcRate, r.framesPerSecond, r.realtimeFactor, r.snr1k,
+                    r.gain1k, r.snr15k, r.gain15k, sep(i, resamplers.size()));
+    }
+    std::printf("  ],\n");
+
+    std::printf("  \"resampler_staging\": [\n");
+    for (size_t i = 0; i < staging.size(); ++i) {
+        const auto& r = staging[i];
+        std::printf("    {\"src_rate\": %d, \"request_frames\": %d, \"chunk_frames\": %d, "
+                    "\"frames_per_sec\": %.0f}%s\n",
+                    r.srcRate, r.requestFrames, STAGING_CHUNK_FRAMES, r.framesPerSecond,
+                    sep(i, staging.size()));
+    }
+    std::printf("  ],\n");
+
+    std::printf("  \"mixer\": [\n");
+    for (size_t i = 0; i < mixer.size(); ++i) {
+        const auto& r = mixer[i];
+        std::printf("    {\"source\": \"%s\", \"threads\": %d, \"streams\": %d, "
+                    "\"block_us_mean\": %.1f, \"block_us_max\": %.1f, \"load\": %.4f, "
+                    "\"us_per_stream\": %.2f}%s\n",
+                    r.source.c_str(), r.threads, r.streams, r.meanBlockUs, r.maxBlockUs,
+                    r.meanLoad, r.usPerStream, sep(i, mixer.size()));
+    }
+    std::printf("  ]\n");
+    std::printf("}\n");
+}
+
+auto main(int argc, char* argv[]) -> int
+{
+    Options opts;
+    if (not parseOptions(argc, argv, opts)) {
+        return 2;
+    }
+
+    std::vector<ContentFile> files;
+    std::vector<Skipped> skipped;
+    if (not generateContent(opts, files, skipped)) {
+        return 1;
+    }
+
+    // The mixer benchmark also needs a file at the output rate, which FileSink can only write
+    // while the library runs at that rate.
+    if (not Aulib::initWithoutOutput(OUTPUT_RATE, CHANNELS)) {
+        std::fprintf(stderr, "Failed to initialize: %s\n", SDL_GetError());
+        return 1;
+    }
+    ContentFile native{"wav_s16_48000", opts.contentDir + "/aulib-bench-s16-48000.wav", {}};
+    if (not writeWithSink(Aulib::FileSink::FileFormat::WavS16, native.path,
+                          opts.contentSeconds()))
+    {
+        std::fprintf(stderr, "Failed to write %s: %s\n", native.path.c_str(), SDL_GetError());
+        Aulib::quit();
+        return 1;
+    }
+    native.data = readFile(native.path);
+
+    const auto decoders = benchDecoders(opts, files);
+    const auto resamplers = benchResamplers(opts, skipped);
+    const auto staging = benchStaging(opts);
+    const auto mixer = benchMixer(opts, native, files.front());
+    Aulib::quit();
+
+    printJson(opts, skipped, decoders, resamplers, staging, mixer);
+
+    if (not opts.keepContent) {
+        for (const auto& file : files) {
+            std::remove(file.path.c_str());
+        }
+        std::remove(native.path.c_str());
+    }
+    return 0;
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,162 @@
+// This is copyrighted software. More information is at the end of this file.
+/*
+ * Micro-benchmark for the mixing kernels. Mixes a few hundred voices into a single buffer, once
+ * using the scalar loops the mixer used before the kernels existed, and once for each set of
+ * kernels the CPU supports.
+ */
+#include "Buffer.h"
+#include "mixkernels.h"
+#include <SDL_cpuinfo.h>
+#include <SDL_version.h>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+constexpr int VOICES = 256;
+constexpr int FRAMES = 1024;
+constexpr int ROUNDS = 200;
+
+struct Case final
+{
+    const char* name;
+    int channels;
+    Aulib::MixGain gain;
+    bool panned;
+    Aulib::MixGains gains;
+};
+
+// The per-stream accumulation loops of the original mixer.
+static void mixBaseline(Buffer<float>& dst, const Buffer<float>& src, const int channels,
+                        const float volumeLeft, const float volumeRight)
+{
+    const int len = dst.size();
+    if (channels > 1 and (volumeLeft != 1.f or volumeRight != 1.f)) {
+        for (int i = 0; i < len; i += 2) {
+            dst[i] += src[i] * volumeLeft;
+            dst[i + 1] += src[i + 1] * volumeRight;
+        }
+    } else if (volumeLeft != 1.f) {
+        for (int i = 0; i < len; ++i) {
+            dst[i] += src[i] * volumeLeft;
+        }
+    } else {
+        for (int i = 0; i < len; ++i) {
+            dst[i] += src[i];
+        }
+    }
+}
+
+template <typename F>
+static auto measure(F&& func) -> double
+{
+    using Clock = std::chrono::steady_clock;
+
+    func(); // Warm up.
+    const auto start = Clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        func();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+    return elapsed.count() / ROUNDS / VOICES;
+}
+
+static auto cpuSupports(const Aulib::MixIsa isa) -> bool
+{
+    switch (isa) {
+    case Aulib::MixIsa::Scalar:
+        return true;
+    case Aulib::MixIsa::Sse2:
+        return SDL_HasSSE2();
+#if SDL_VERSION_ATLEAST(2, 0, 4)
+    case Aulib::MixIsa::Avx2:
+        return SDL_HasAVX2();
+#endif
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+    case Aulib::MixIsa::Neon:
+        return SDL_HasNEON();
+#endif
+    default:
+        return false;
+    }
+}
+
+auto main() -> int
+{
+    const std::vector<Case> cases{
+        {"mono, constant", 1, Aulib::MixGain::Constant, false, {0.7f, 0.7f, 0.f, 0.f, 1.f, 0.f}},
+        {"stereo, unity", 2, Aulib::MixGain::Unity, false, {1.f, 1.f, 0.f, 0.f, 1.f, 0.f}},
+        {"stereo, constant", 2, Aulib::MixGain::Constant, false,
+         {0.7f, 0.7f, 0.f, 0.f, 1.f, 0.f}},
+        {"stereo, constant, panned", 2, Aulib::MixGain::Constant, true,
+         {0.7f, 0.3f, 0.f, 0.f, 1.f, 0.f}},
+        {"stereo, ramp, panned", 2, Aulib::MixGain::Ramp, true,
+         {0.7f, 0.3f, -1e-4f, 1e-4f, 1.f, 0.f}},
+        {"stereo, fade, panned", 2, Aulib::MixGain::Fade, true,
+         {0.7f, 0.3f, -1e-4f, 1e-4f, 0.5f, 1e-4f}},
+    };
+    const Aulib::MixIsa isas[]{Aulib::MixIsa::Scalar, Aulib::MixIsa::Sse2, Aulib::MixIsa::Avx2,
+                               Aulib::MixIsa::Neon};
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+    std::printf("%d voices, %d frames per block. Time per voice and block, in ns.\n\n", VOICES,
+                FRAMES);
+
+    for (const auto& c : cases) {
+        const int len = FRAMES * c.channels;
+        Buffer<float> mix(len);
+        std::vector<std::unique_ptr<Buffer<float>>> voices;
+        for (int v = 0; v < VOICES; ++v) {
+            voices.push_back(std::make_unique<Buffer<float>>(len));
+            for (auto& sample : *voices.back()) {
+                sample = dist(rng);
+            }
+        }
+
+        // The original mixer had no ramps; it used the gain of the first frame for the whole block.
+        const double baseline = measure([&] {
+            for (const auto& voice : voices) {
+                mixBaseline(mix, *voice, c.channels, c.gains.left,
+                            c.panned ? c.gains.right : c.gains.left);
+            }
+        });
+        std::printf("%-26s baseline %8.1f\n", c.name, baseline);
+
+        for (const auto isa : isas) {
+            const Aulib::MixFunc kernel = Aulib::mixKernelFor(isa, c.channels, c.gain, c.panned);
+            if (not kernel or not cpuSupports(isa)) {
+                continue;
+            }
+            const double t = measure([&] {
+                for (const auto& voice : voices) {
+                    kernel(mix.get(), voice->get(), FRAMES, c.gains);
+                }
+            });
+            std::printf("%-26s %-8s %8.1f  (%.2fx)\n", "", Aulib::mixIsaName(isa), t, baseline / t);
+        }
+    }
+    return 0;
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
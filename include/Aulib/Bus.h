@@ -0,0 +1,114 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_export.h"
+#include <memory>
+
+namespace Aulib {
+
+class Processor;
+
+/*!
+ * \brief A submix bus that groups streams together.
+ *
+ * Streams routed to a bus with Stream::setBus() are summed together. The bus then runs its
+ * processors once on the sum, applies its own volume and mute state and passes the result on to
+ * its output, which is either another bus or the master output. Effects that apply to a whole
+ * group of streams therefore cost the same regardless of how many streams are in the group.
+ *
+ * Buses are processed in the audio callback thread after all streams have been mixed. Buses keep
+ * running even if no stream is routed to them, so processors with a tail (like reverb) can ring
+ * out.
+ *
+ * All functions lock the SDL audio device, except for the volume and mute functions.
+ */
+class AULIB_EXPORT Bus
+{
+public:
+    /*!
+     * \brief Creates a bus that outputs to the master output.
+     */
+    Bus();
+
+    /*!
+     * \brief Destroys the bus.
+     *
+     * Streams and buses that were routed to this bus are routed to the master output.
+     */
+    ~Bus();
+
+    Bus(const Bus&) = delete;
+    auto operator=(const Bus&) -> Bus& = delete;
+
+    /*!
+     * \brief Routes the output of this bus to another bus.
+     *
+     * \param output
+     *  Bus to output to. Null means the master output.
+     *
+     * \return
+     *  \retval true The output was changed.
+     *  \retval false The output would create a cycle. Nothing was changed.
+     */
+    auto setOutput(Bus* output) -> bool;
+
+    /*!
+     * \brief Returns the bus this bus outputs to, or null for the master output.
+     */
+    auto output() const -> Bus*;
+
+    /*!
+     * \brief Sets the volume of the bus.
+     *
+     * \param volume
+     *  0 means total silence, 1 means original volume. Values above 1 amplify, negative values
+     *  are treated as 0.
+     */
+    void setVolume(float volume);
+
+    auto volume() const -> float;
+
+    void mute();
+    void unmute();
+    auto isMuted() const -> bool;
+
+    /*!
+     * \brief Adds a processor to the end of the processor chain of this bus.
+     *
+     * If the processor has already been added, it is not added again.
+     */
+    void addProcessor(std::shared_ptr<Processor> processor);
+
+    void removeProcessor(Processor* processor);
+
+    void clearProcessors();
+
+private:
+    friend class Stream;
+    friend struct Bus_priv;
+
+    const std::unique_ptr<struct Bus_priv> d;
+};
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
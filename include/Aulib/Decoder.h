@@ -13,6 +13,8 @@ struct SDL_RWops;
 
 namespace Aulib {
 
+struct ProbedDecoder;
+
 /*!
  * \brief Abstract base class for audio decoders.
  */
@@ -41,10 +43,15 @@ public:
 #endif
 
     /*!
-     * \brief Find and return an instance of the first decoder that can open the specified file.
+     * \brief Find and return an instance of a decoder that can open the specified file.
+     *
+     * The format is recognized from the first few bytes of the file, and only the decoders that
+     * support it are tried. If the content is not recognized, the file name extension is used
+     * instead. When several decoders support the same format, the first one that can open the
+     * file is used.
      *
-     * All decoders known by SDL_Audiolib will be tried. If you want to try your own decoders or
-     * limit the list of tried decoders, then use the templated version of this function instead.
+     * If you want to try your own decoders or limit the list of tried decoders, then use the
+     * templated version of this function instead.
      *
      * \return A suitable decoder or nullptr if none of the decoders can open the file.
      */
@@ -52,9 +59,87 @@ public:
     //! \overload
     static auto decoderFor(SDL_RWops* rwops) -> std::unique_ptr<Decoder>;
 
+    /*!
+     * \brief Like \ref decoderFor(SDL_RWops*), with a file name to fall back on.
+     *
+     * \param nameHint
+     *  The name of the file 'rwops' reads from, or just its extension. Only used if the format
+     *  can't be recognized from the contents.
+     */
+    static auto decoderFor(SDL_RWops* rwops, const std::string& nameHint)
+        -> std::unique_ptr<Decoder>;
+
+    /*!
+     * \brief Find a decoder for the specified file and return it already opened.
+     *
+     * Works like \ref decoderFor(), but instead of a new decoder that still needs to open the
+     * file, this returns the decoder that recognized it together with the SDL_RWops it reads from.
+     * Pass the result to a \ref Stream so the file doesn't need to be parsed a second time.
+     *
+     * \return The opened decoder. If no decoder could open the file, its decoder is null.
+     */
+    static auto probe(const std::string& filename) -> ProbedDecoder;
+
+    /*!
+     * \brief Find a decoder for the given SDL_RWops and return it already opened.
+     *
+     * \param rwops
+     *  Where to read from. The returned decoder keeps reading from it.
+     *
+     * \param closeRw
+     *  Specifies whether 'rwops' should be closed when the result is destroyed, or when the stream
+     *  it's passed to is destroyed. This includes the case where no decoder was found.
+     *
+     * \param nameHint
+     *  See \ref decoderFor(SDL_RWops*, const std::string&).
+     */
+    static auto probe(SDL_RWops* rwops, bool closeRw, const std::string& nameHint = {})
+        -> ProbedDecoder;
+
     auto isOpen() const -> bool;
     auto decode(float buf[], int len, bool& callAgain) -> int;
 
+    /*!
+     * \brief Sets the amount of channels decode() produces.
+     *
+     * By default, this follows \ref Aulib::channelCount(). Streams set this to the channel count of
+     * the source when the device has more channels, so that the source is decoded, resampled and
+     * processed with as few channels as possible and only converted to the device's layout while
+     * mixing. Sources with more channels than this are downmixed.
+     *
+     * \param channels
+     *  1 to 8. 0 restores the default. Channels are in the order SDL uses for the same count.
+     */
+    void setOutputChannels(int channels);
+
+    //! \brief Amount of channels decode() produces.
+    auto outputChannels() const -> int;
+
+    /*!
+     * \brief Like decode(), but stores each channel in its own buffer.
+     *
+     * \param bufs
+     *  One buffer per output channel (\ref outputChannels()), each with room for 'frames' samples.
+     *
+     * \return The amount of frames that were stored in each buffer.
+     */
+    auto decodePlanar(float* const bufs[], int frames, bool& callAgain) -> int;
+
+    /*!
+     * \brief Whether the decoder produces separate channel buffers on its own.
+     *
+     * If it doesn't, \ref decodePlanar() decodes interleaved audio and splits it up afterwards.
+     * Resamplers that can work on separate channels only do so for decoders that support it.
+     */
+    virtual auto supportsPlanar() const -> bool;
+
+    /*!
+     * \brief Opens the given SDL_RWops for decoding.
+     *
+     * If 'rwops' was created with SDL_RWFromMem() or SDL_RWFromConstMem(), decoders may read
+     * straight from that memory instead of copying it, so it needs to stay valid for as long as the
+     * decoder is open.
+     */
     virtual auto open(SDL_RWops* rwops) -> bool = 0;
     virtual auto getChannels() const -> int = 0;
     virtual auto getRate() const -> int = 0;
@@ -66,10 +151,41 @@ protected:
     void setIsOpen(bool f);
     virtual auto doDecoding(float buf[], int len, bool& callAgain) -> int = 0;
 
+    /*!
+     * \brief Planar version of doDecoding().
+     *
+     * Only called if supportsPlanar() returns true. 'bufs' holds one buffer per channel of the
+     * decoded audio, as reported by getChannels(), in the order SDL uses for that many channels.
+     * Must return the amount of frames stored.
+     */
+    virtual auto doDecodingPlanar(float* const bufs[], int frames, bool& callAgain) -> int;
+
 private:
     const std::unique_ptr<struct Decoder_priv> d;
 };
 
+/*!
+ * \brief An opened decoder and the SDL_RWops it reads from, as returned by \ref Decoder::probe().
+ */
+struct AULIB_EXPORT ProbedDecoder final
+{
+    ProbedDecoder() = default;
+    ProbedDecoder(ProbedDecoder&& other) noexcept;
+    auto operator=(ProbedDecoder&& other) noexcept -> ProbedDecoder&;
+    //! Closes 'rwops' if 'closeRw' is set.
+    ~ProbedDecoder();
+
+    //! True if a decoder was found.
+    explicit operator bool() const noexcept
+    {
+        return decoder != nullptr;
+    }
+
+    std::unique_ptr<Decoder> decoder;
+    SDL_RWops* rwops = nullptr;
+    bool closeRw = false;
+};
+
 #if __cplusplus >= 201603
 template <class... Decoders>
 inline auto Decoder::decoderFor(const std::string& filename) -> std::unique_ptr<Decoder>
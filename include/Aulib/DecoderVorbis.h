@@ -20,9 +20,11 @@ public:
     auto rewind() -> bool override;
     auto duration() const -> std::chrono::microseconds override;
     auto seekToTime(std::chrono::microseconds pos) -> bool override;
+    auto supportsPlanar() const -> bool override;
 
 protected:
     auto doDecoding(float buf[], int len, bool& callAgain) -> int override;
+    auto doDecodingPlanar(float* const bufs[], int frames, bool& callAgain) -> int override;
 
 private:
     const std::unique_ptr<struct DecoderVorbis_priv> d;
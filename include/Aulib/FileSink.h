@@ -0,0 +1,126 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_export.h"
+#include <SDL_stdinc.h>
+#include <chrono>
+#include <memory>
+#include <string>
+
+struct SDL_RWops;
+
+namespace Aulib {
+
+/*!
+ * \brief Writes audio to a WAV or FLAC file while it's being produced.
+ *
+ * This is mainly meant for rendering the mix to a file, together with \ref initWithoutOutput().
+ * The file uses the sample rate and channel count the library was initialized with. The file is
+ * written incrementally, so memory use does not depend on the length of the audio.
+ *
+ * \code
+ * Aulib::initWithoutOutput(48000, 2);
+ * // Create and play streams...
+ * Aulib::FileSink sink(Aulib::FileSink::FileFormat::Flac);
+ * sink.open("out.flac");
+ * sink.render(std::chrono::minutes(10));
+ * sink.close();
+ * \endcode
+ */
+class AULIB_EXPORT FileSink
+{
+public:
+    enum class FileFormat
+    {
+        //! WAV with 16-bit integer samples.
+        WavS16,
+        //! WAV with 32-bit float samples.
+        WavFloat,
+        //! 24-bit FLAC. Only available if the library was built with libFLAC support.
+        Flac,
+    };
+
+    explicit FileSink(FileFormat format = FileFormat::WavS16);
+    ~FileSink();
+
+    FileSink(const FileSink&) = delete;
+    auto operator=(const FileSink&) -> FileSink& = delete;
+
+    /*!
+     * \brief Creates the given file and starts a new recording in it.
+     *
+     * If the sink was already open, it is closed first.
+     */
+    auto open(const std::string& filename) -> bool;
+
+    /*!
+     * \brief Starts a new recording in the given SDL_RWops.
+     *
+     * If 'rwops' isn't seekable, WAV headers can't be updated with the final size when closing and
+     * will keep saying that the length is unknown.
+     *
+     * \param rwops
+     *  Where to write to. Must not be null.
+     *
+     * \param closeRw
+     *  Specifies whether 'rwops' should be closed when the sink is closed.
+     */
+    auto open(SDL_RWops* rwops, bool closeRw) -> bool;
+
+    auto isOpen() const -> bool;
+
+    /*!
+     * \brief Writes interleaved float samples.
+     *
+     * Samples outside the [-1, 1] range are clipped.
+     *
+     * \param buf
+     *  Samples to write, frames * \ref channelCount() of them.
+     *
+     * \param frames
+     *  Amount of frames in 'buf'.
+     */
+    auto write(const float buf[], int frames) -> bool;
+
+    /*!
+     * \brief Renders the given duration of the mix with \ref renderMix() and writes it.
+     */
+    auto render(std::chrono::microseconds duration) -> bool;
+
+    /*!
+     * \brief Finishes the file.
+     *
+     * This happens automatically on destruction, but errors can only be detected by calling this
+     * function manually.
+     */
+    auto close() -> bool;
+
+    //! Amount of frames written since the sink was opened.
+    auto framesWritten() const -> Uint64;
+
+private:
+    const std::unique_ptr<struct FileSink_priv> d;
+};
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
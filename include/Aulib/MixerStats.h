@@ -0,0 +1,138 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_export.h"
+#include <SDL_stdinc.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Aulib {
+
+/*!
+ * \brief Timing measurements of the audio callback.
+ *
+ * The measurements are only taken when the library was built with ENABLE_MIXER_STATS (the
+ * default.) Otherwise, \ref enabled is false and everything else is zero. Rendering with \ref
+ * renderMix() is not measured, since it has no deadline to meet.
+ *
+ * All durations are cumulative since initialization or the last call to \ref resetMixerStats().
+ */
+struct MixerStats final
+{
+    /*!
+     * \brief A range of callback durations and how many callbacks fell into it.
+     */
+    struct Bucket final
+    {
+        std::chrono::microseconds lowerBound;
+        std::chrono::microseconds upperBound;
+        Uint64 count;
+    };
+
+    bool enabled = false;
+
+    //! Amount of audio callbacks that were measured.
+    Uint64 callbacks = 0;
+
+    //! Callbacks that took longer than the audio they produced lasts. Each one risks a dropout.
+    Uint64 overruns = 0;
+
+    //! Callbacks that started more than half a period later than expected. The device most likely
+    //! ran dry before them.
+    Uint64 lateCallbacks = 0;
+
+    //! Duration of the audio produced by the most recent callback. This is the time budget of
+    //! each callback.
+    std::chrono::nanoseconds period{};
+
+    std::chrono::nanoseconds lastDuration{};
+    std::chrono::nanoseconds meanDuration{};
+    std::chrono::nanoseconds maxDuration{};
+
+    //! Percentiles of the callback duration. These are estimated from the histogram, so they're
+    //! only accurate to about a quarter of a power of two.
+    std::chrono::nanoseconds p50{};
+    std::chrono::nanoseconds p90{};
+    std::chrono::nanoseconds p99{};
+    std::chrono::nanoseconds p999{};
+
+    //! Callback duration divided by period. 1 means the callback used up all of its budget.
+    float lastLoad = 0.f;
+    float meanLoad = 0.f;
+    float peakLoad = 0.f;
+
+    //! Non-empty buckets of the callback duration histogram, in ascending order. Each power of two
+    //! is split into four buckets.
+    std::vector<Bucket> histogram;
+};
+
+/*!
+ * \brief Time a stream spent in each stage of the mixer.
+ *
+ * Includes the time spent in decode-ahead threads. Mixing into the output is not included.
+ */
+struct StreamStats final
+{
+    std::chrono::nanoseconds decodeTime{};
+    //! Does not include the time the resampler spent waiting for the decoder.
+    std::chrono::nanoseconds resampleTime{};
+    std::chrono::nanoseconds processorTime{};
+};
+
+/*!
+ * \brief Total decoding time of all streams using a decoder type.
+ */
+struct DecoderStats final
+{
+    //! Class name of the decoder, like "Aulib::DecoderVorbis".
+    std::string name;
+    std::chrono::nanoseconds decodeTime{};
+    //! Amount of calls to Decoder::decode().
+    Uint64 calls = 0;
+};
+
+/*!
+ * \brief Returns the current audio callback measurements.
+ *
+ * This does not lock anything and can be called from any thread at any time, including from inside
+ * a processor. The values are read one by one while the audio callback might be updating them, so
+ * they can be off by one callback relative to each other.
+ */
+AULIB_EXPORT auto mixerStats() -> MixerStats;
+
+/*!
+ * \brief Returns the total decoding time per decoder type.
+ *
+ * Only decoders that are used by streams are measured. Like \ref mixerStats(), this does not lock
+ * anything.
+ */
+AULIB_EXPORT auto decoderStats() -> std::vector<DecoderStats>;
+
+/*!
+ * \brief Sets all measurements back to zero, including those of streams and decoder types.
+ */
+AULIB_EXPORT void resetMixerStats();
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
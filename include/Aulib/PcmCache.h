@@ -0,0 +1,144 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_export.h"
+#include <Aulib/Decoder.h>
+#include <Aulib/Resampler.h>
+#include <SDL_stdinc.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SDL_RWops;
+
+namespace Aulib {
+
+/*!
+ * \brief Fully decoded audio, already converted to the output sample rate and channel count.
+ *
+ * Sounds with less channels than the device are an exception: they keep their own channels, since
+ * the mixer converts them to the device's layout while playing them.
+ *
+ * The samples never change after the buffer has been created, so any amount of streams can play
+ * the same buffer at the same time.
+ */
+struct PcmBuffer final
+{
+    //! Interleaved samples.
+    std::vector<float> samples;
+    int rate = 0;
+    int channels = 0;
+
+    auto frames() const noexcept -> int
+    {
+        return channels > 0 ? static_cast<int>(samples.size()) / channels : 0;
+    }
+};
+
+/*!
+ * \brief Process-wide cache of decoded sounds.
+ *
+ * Meant for short sounds that are played often, like sound effects. Each sound is decoded and
+ * resampled once, the first time it's requested, and the result is shared by every \ref Stream
+ * created from it. Playing a cached sound only costs the mixing.
+ *
+ * \code
+ * auto footstep = Aulib::PcmCache::get("footstep.wav");
+ * Aulib::Stream stream(footstep);
+ * stream.play();
+ * \endcode
+ *
+ * The cache holds at most \ref budget() bytes of samples. When a new sound doesn't fit, the least
+ * recently requested sounds are dropped from the cache. Streams that are still using a dropped
+ * sound keep it alive until they're destroyed.
+ *
+ * Sounds are stored in the format the library was initialized with, so the cache is cleared by
+ * \ref Aulib::quit(). All functions are thread-safe. Decoding happens in the calling thread
+ * without holding any lock.
+ */
+class AULIB_EXPORT PcmCache final
+{
+public:
+    PcmCache() = delete;
+
+    /*!
+     * \brief Returns the decoded contents of the given file, decoding it first if needed.
+     *
+     * The file name is the cache key. The decoder is picked with \ref Decoder::decoderFor() and
+     * the Speex resampler is used if the file's sample rate differs from the output rate.
+     *
+     * \return
+     *  The cached sound, or null if the file could not be decoded. Use SDL_GetError() to get the
+     *  error.
+     */
+    static auto get(const std::string& filename) -> std::shared_ptr<const PcmBuffer>;
+
+    /*!
+     * \brief Returns the sound cached under 'key', decoding it from the given SDL_RWops if needed.
+     *
+     * \param key
+     *  Identifies the source. Requesting the same key again returns the cached sound without
+     *  touching 'rwops', 'decoder' or 'resampler'.
+     *
+     * \param rwops
+     *  Where to decode from. Must not be null.
+     *
+     * \param decoder
+     *  Decoder to use. If null, one is picked with \ref Decoder::decoderFor().
+     *
+     * \param resampler
+     *  Resampler to use. If null, the Speex resampler is used when needed.
+     *
+     * \param closeRw
+     *  Specifies whether 'rwops' should be closed when this function returns.
+     */
+    static auto get(const std::string& key, SDL_RWops* rwops, std::unique_ptr<Decoder> decoder,
+                    std::unique_ptr<Resampler> resampler, bool closeRw)
+        -> std::shared_ptr<const PcmBuffer>;
+
+    //! Returns the sound cached under 'key' without decoding anything. Null if it's not cached.
+    static auto find(const std::string& key) -> std::shared_ptr<const PcmBuffer>;
+
+    //! Drops the sound cached under 'key'.
+    static void remove(const std::string& key);
+
+    //! Drops all cached sounds.
+    static void clear();
+
+    /*!
+     * \brief Sets the maximum amount of memory used for samples, in bytes.
+     *
+     * Sounds are dropped right away if they don't fit anymore. A single sound larger than the
+     * budget is still returned by \ref get(), but isn't cached. The default is 64MiB.
+     */
+    static void setBudget(std::size_t bytes);
+
+    static auto budget() -> std::size_t;
+
+    //! Memory currently used by cached samples, in bytes.
+    static auto usedBytes() -> std::size_t;
+};
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -53,6 +53,9 @@ public:
     auto currentChunkSize() const -> int;
 
     /*! \brief Fills an output buffer with resampled audio samples.
+     *
+     * When the decoder's rate already matches the wanted rate, the decoder writes straight into
+     * 'dst' and doResampling() is not called.
      *
      * \param dst Output buffer.
      *
@@ -130,6 +133,30 @@ protected:
      */
     virtual void doDiscardPendingSamples() = 0;
 
+    /*! \brief Whether this resampler implements doResamplingPlanar().
+     *
+     * The default implementation returns false.
+     */
+    virtual auto supportsPlanar() const -> bool;
+
+    /*! \brief Whether the audio is currently passed to doResamplingPlanar() instead of
+     * doResampling().
+     *
+     * This is decided before each call to adjustForOutputSpec(). Planar resampling is used when
+     * both this resampler and the decoder support it, so that neither side needs to interleave or
+     * split up the channels.
+     */
+    auto isPlanar() const -> bool;
+
+    /*! \brief Planar version of doResampling().
+     *
+     * Only called if isPlanar() returns true. 'src' and 'dst' hold one buffer per channel.
+     * 'dstFrames' and 'srcFrames' work like 'dstLen' and 'srcLen' in doResampling(), but count
+     * frames instead of samples.
+     */
+    virtual void doResamplingPlanar(float* const dst[], const float* const src[], int& dstFrames,
+                                    int& srcFrames);
+
 private:
     friend Resampler_priv;
     const std::unique_ptr<Resampler_priv> d;
@@ -43,6 +43,9 @@ protected:
     void doResampling(float dst[], const float src[], int& dstLen, int& srcLen) override;
     auto adjustForOutputSpec(int dstRate, int srcRate, int channels) -> int override;
     void doDiscardPendingSamples() override;
+    auto supportsPlanar() const -> bool override;
+    void doResamplingPlanar(float* const dst[], const float* const src[], int& dstFrames,
+                            int& srcFrames) override;
 
 private:
     const std::unique_ptr<ResamplerSox_priv> d;
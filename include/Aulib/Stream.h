@@ -2,6 +2,7 @@
 #pragma once
 
 #include "aulib_export.h"
+#include <Aulib/MixerStats.h>
 #include <SDL_stdinc.h>
 #include <SDL_version.h>
 #include <aulib.h>
@@ -18,6 +19,9 @@ namespace Aulib {
 class Decoder;
 class Resampler;
 class Processor;
+class Bus;
+struct PcmBuffer;
+struct ProbedDecoder;
 
 /*!
  * \brief A \ref Stream handles playback for audio produced by a Decoder.
@@ -26,6 +30,13 @@ class Processor;
  * unlock it when they return. Therefore, it is safe to manipulate a Stream that is currently
  * playing without having to manually lock the SDL audio device.
  *
+ * The exceptions are the volume, stereo position and mute functions, as well as isPlaying() and
+ * isPaused(). These never lock the audio device, so they can be called often without stalling
+ * audio output. Volume, stereo position and mute changes are queued and take effect at the start of
+ * the next block of audio that is mixed. Their getters return the value that was last set, even
+ * if it hasn't taken effect yet. Use beginBatch() and endBatch() to make several changes take
+ * effect in the same block.
+ *
  * This class is re-entrant but not thread-safe. You can call functions of this class from different
  * threads only if those calls operate on different objects. If you need to control the same Stream
  * object from multiple threads, you need to synchronize access to that object. This includes Stream
@@ -78,6 +89,35 @@ public:
     //! \overload
     explicit Stream(SDL_RWops* rwops, std::unique_ptr<Decoder> decoder, bool closeRw);
 
+    /*!
+     * \brief Constructs an audio stream from a decoder that was opened by \ref Decoder::probe().
+     *
+     * The decoder is not opened again. The stream takes over the SDL_RWops, and closes it when
+     * it's destroyed if the probe result says so.
+     *
+     * \param probed
+     *  The opened decoder. Must contain a decoder.
+     *
+     * \param resampler
+     *  Resampler to use for converting the sample rate of the audio we get from the decoder. If
+     *  this is null, then no resampling will be performed.
+     */
+    explicit Stream(ProbedDecoder probed, std::unique_ptr<Resampler> resampler);
+
+    //! \overload
+    explicit Stream(ProbedDecoder probed);
+
+    /*!
+     * \brief Constructs an audio stream that plays an already decoded sound.
+     *
+     * The samples are not copied. Any amount of streams can play the same buffer at the same time.
+     * See \ref PcmCache.
+     *
+     * \param pcm
+     *  The sound to play. Must not be null.
+     */
+    explicit Stream(std::shared_ptr<const PcmBuffer> pcm);
+
     virtual ~Stream();
 
     Stream(const Stream&) = delete;
@@ -170,6 +210,9 @@ public:
      * example, when setting the position of a stereo stream all the way to the right, the left
      * channel will be completely inaudible. It will not be mixed into the right channel.
      *
+     * With more than two output channels, this applies to all speakers on each side. Center and LFE
+     * channels get the average of the left and right attenuation.
+     *
      * \param position
      *  Must be between -1.0 (all the way to the left) and 1.0 (all the way to the right) with 0
      *  being the center position.
@@ -198,6 +241,22 @@ public:
      */
     virtual auto isMuted() const -> bool;
 
+    /*!
+     * \brief Start a batch of stream changes.
+     *
+     * Volume, stereo position and mute changes that the calling thread makes to any stream are held
+     * back until the matching endBatch() call. They then all take effect in the same block of
+     * audio. Batches can be nested, in which case the outermost endBatch() applies the changes.
+     *
+     * Other threads are not affected. Their changes are applied as usual.
+     */
+    static void beginBatch();
+
+    /*!
+     * \brief End a batch of stream changes started with beginBatch().
+     */
+    static void endBatch();
+
     /*!
      * \brief Get current playback state.
      *
@@ -252,6 +311,37 @@ public:
      */
     virtual auto seekToTime(std::chrono::microseconds pos) -> bool;
 
+    /*!
+     * \brief Decode audio ahead of time in a background thread.
+     *
+     * By default, the stream is decoded and resampled inside the SDL audio callback. Decoders that
+     * occasionally need a lot of time for a single call (MP3 frames, FLAC seeks, software synths)
+     * can then make the callback miss its deadline, resulting in audio drop-outs. With decode-ahead
+     * enabled, this work is done by a shared pool of decode threads instead, which keep a buffer of
+     * ready to play audio for the stream. See \ref Aulib::setDecodeThreadCount().
+     *
+     * The change takes effect the next time playback is started.
+     *
+     * \param frames
+     *  Size of the buffer in frames (samples per channel.) Larger buffers are more tolerant of slow
+     *  decoders, but make seeking and rewinding more expensive. Values smaller than twice the
+     *  device's frame size will be adjusted. 0 disables decode-ahead.
+     */
+    void setDecodeAhead(int frames);
+
+    /*!
+     * \brief Returns the decode-ahead buffer size in frames, or 0 if decode-ahead is disabled.
+     */
+    auto decodeAhead() const -> int;
+
+    /*!
+     * \brief Returns how many times the decode-ahead buffer ran out of audio during playback.
+     *
+     * Each time this happens, the missing part of the output is filled with silence. If this keeps
+     * increasing, the decode-ahead buffer is too small or there are not enough decode threads.
+     */
+    auto underrunCount() const -> int;
+
     /*!
      * \brief Set a callback for when the stream finishes playback.
      *
@@ -310,6 +400,50 @@ public:
      */
     void clearProcessors();
 
+    /*!
+     * \brief Sets the priority of the stream.
+     *
+     * When the amount of real voices is limited with \ref setMaxRealVoices(), the streams with the
+     * highest priority are preferred. Among streams of equal priority, the loudest ones win. The
+     * default priority is 0.
+     */
+    void setPriority(int priority);
+
+    auto priority() const -> int;
+
+    /*!
+     * \brief Returns whether the stream is currently playing as a virtual voice.
+     *
+     * A virtual stream is playing, but is neither decoded nor mixed. Its playback position keeps
+     * advancing, and it continues from the right position once it becomes real again. Streams are
+     * virtual while they are inaudible (muted, zero volume or routed to a muted bus), or when they
+     * lose against other streams because of the real voice limit.
+     *
+     * Only streams whose decoder reports a duration can become virtual. Streams using decode-ahead
+     * never do, and count against the real voice limit like any other stream that can't.
+     */
+    auto isVirtual() const -> bool;
+
+    /*!
+     * \brief Routes the output of the stream to a bus.
+     *
+     * \param bus
+     *  Bus to route to. Null means the master output, which is the default.
+     */
+    void setBus(Bus* bus);
+
+    /*!
+     * \brief Returns the bus the stream is routed to, or null for the master output.
+     */
+    auto bus() const -> Bus*;
+
+    /*!
+     * \brief Returns how much time the mixer spent on this stream.
+     *
+     * Does not lock the audio device. See \ref mixerStats().
+     */
+    auto mixStats() const -> StreamStats;
+
 protected:
     /*!
      * \brief Invokes the finish-playback callback, if there is one.
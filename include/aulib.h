@@ -4,6 +4,7 @@
 #include "aulib_global.h"
 #include <SDL_audio.h>
 #include <SDL_version.h>
+#include <functional>
 #include <string>
 
 #if !SDL_VERSION_ATLEAST(2, 0, 0)
@@ -35,9 +36,10 @@ using AudioFormat = Uint16;
  *  format.
  *
  * \param channels
- *  Amount of output channels to use. Can either be 1 (mono) or 2 (stereo.) Lower or higher values
+ *  Amount of output channels to use, from 1 (mono) to 8 (7.1 surround.) Lower or higher values
  *  will be adjusted. Unlike the other parameters, the channel count is enforced and will not
- *  change.
+ *  change. Channels are in the order SDL uses for that count. Sources with a different amount of
+ *  channels are converted to this layout.
  *
  * \param frameSize
  *  Size in frames (samples per channel) of the internal buffer that is used to feed audio samples
@@ -67,7 +69,8 @@ AULIB_EXPORT auto init(int freq, AudioFormat format, int channels, int frameSize
  *
  * SDL_InitSubSystem() will not be called and thus the SDL audio subsystem is left uninitialized.
  *
- * You cannot use Aulib::Stream objects. Trying to do so will result in undefined behavior.
+ * Aulib::Stream objects can be used, but nothing plays them in real time. Instead, the mix of all
+ * playing streams is pulled with \ref renderMix().
  *
  * \param freq
  * Target sample rate for decoders that generate audio themselves (like the MIDI and MOD decoders.)
@@ -82,6 +85,31 @@ AULIB_EXPORT auto init(int freq, AudioFormat format, int channels, int frameSize
  */
 AULIB_EXPORT auto initWithoutOutput(int freq, int channels) -> bool;
 
+/*!
+ * \brief Mixes the next frames of all playing streams.
+ *
+ * Only available after initializing with \ref initWithoutOutput(). This runs the same mixer that
+ * feeds the audio device when using the normal init function, but as fast as possible. Time only
+ * advances with the amount of rendered frames, so fades, start offsets and playback positions
+ * behave exactly as they would when playing in real time. For example, rendering 48000 frames at a
+ * sample rate of 48kHz runs all streams for one second.
+ *
+ * Stream functions can be called from other threads; they are synchronized with the rendering.
+ * Stream decode-ahead (\ref Stream::setDecodeAhead()) is not used when rendering.
+ *
+ * \param out
+ *  Receives the interleaved samples, in float format. Must have room for frames * \ref
+ *  channelCount() samples. Up to 8 channels are supported.
+ *
+ * \param frames
+ *  Amount of frames to render.
+ *
+ * \return
+ *  \retval true The frames were rendered.
+ *  \retval false The library was not initialized for rendering.
+ */
+AULIB_EXPORT auto renderMix(float out[], int frames) -> bool;
+
 /*!
  *  \brief Shuts down the SDL_audiolib library.
  *
@@ -118,6 +146,124 @@ AULIB_EXPORT auto channelCount() noexcept -> int;
  */
 AULIB_EXPORT auto frameSize() noexcept -> int;
 
+/*!
+ * \brief Sets the amount of threads used for streams with decode-ahead enabled.
+ *
+ * See \ref Stream::setDecodeAhead(). The threads are only started once there's a stream that needs
+ * them.
+ *
+ * \param count
+ *  Amount of decode threads. 0 selects the default, which is half the amount of CPU cores.
+ */
+AULIB_EXPORT void setDecodeThreadCount(int count);
+
+/*!
+ * \brief Returns the amount of threads used for streams with decode-ahead enabled.
+ */
+AULIB_EXPORT auto decodeThreadCount() -> int;
+
+/*!
+ * \brief Sets the amount of threads used for mixing streams.
+ *
+ * By default, all playing streams are decoded, processed and mixed one after the other in the SDL
+ * audio callback. With a thread count larger than 1, the streams are split across a pool of high
+ * priority mixing threads instead, with the audio callback thread being one of them. This helps
+ * when playing many streams at once.
+ *
+ * Note that streams are then processed concurrently. If you add the same Processor instance to more
+ * than one stream, it needs to be thread-safe. Finish and loop callbacks are always invoked from
+ * the audio callback thread.
+ *
+ * \param count
+ *  Amount of mixing threads, including the audio callback thread. 1 or less disables parallel
+ *  mixing.
+ */
+AULIB_EXPORT void setMixThreadCount(int count);
+
+/*!
+ * \brief Returns the amount of threads used for mixing streams.
+ */
+AULIB_EXPORT auto mixThreadCount() -> int;
+
+/*!
+ * \brief Limits the amount of streams that are decoded and mixed at the same time.
+ *
+ * When more streams are playing, only the ones with the highest priority and, among those, the
+ * loudest are played for real. The others become virtual: they keep their playback position
+ * advancing without being decoded, and continue from there once they win again. See
+ * Stream::setPriority() and Stream::isVirtual(). This puts a cap on the CPU time mixing needs,
+ * regardless of how many streams are started. Inaudible streams are always virtual. Streams that
+ * can't become virtual, like ones using decode-ahead, are always real and take up a slot.
+ *
+ * \param count
+ *  Maximum amount of real voices. 0 means no limit, which is the default.
+ */
+AULIB_EXPORT void setMaxRealVoices(int count);
+
+/*!
+ * \brief Returns the maximum amount of real voices, or 0 if there is no limit.
+ */
+AULIB_EXPORT auto maxRealVoices() -> int;
+
+/*!
+ * \brief Writes the most recent trace events to a file.
+ *
+ * Only available when the library was built with ENABLE_TRACING. Each thread that does audio work
+ * keeps a record of its most recent audio callbacks, decoder calls, resampler calls, processor
+ * calls and seeks, with their start times and durations. This writes them in the Chrome trace
+ * event format, which can be opened with Perfetto (https://ui.perfetto.dev) or chrome://tracing.
+ * This makes it possible to find out which call caused a glitch in the output.
+ *
+ * Can be called at any time, from any thread. Recording continues while the file is written.
+ *
+ * \param filename
+ *  File to write to. It's overwritten if it already exists.
+ *
+ * \return
+ *  \retval true The trace was written.
+ *  \retval false Tracing is not available, or the file could not be written. Use SDL_GetError() to
+ *  get the error message.
+ */
+AULIB_EXPORT auto writeTrace(const std::string& filename) -> bool;
+
+/*!
+ * \brief Severity of a log message.
+ */
+enum class LogLevel
+{
+    //! Only produced by debug builds of the library.
+    Debug,
+    Info,
+    Warning,
+};
+
+/*!
+ * \brief Function that receives log messages.
+ *
+ * The message has no trailing newline.
+ */
+using LogCallback = std::function<void(LogLevel level, const char* message)>;
+
+/*!
+ * \brief Sets the function that receives the library's log messages.
+ *
+ * By default, warnings and debug messages are printed to stderr and info messages to stdout.
+ *
+ * While the library is initialized, messages are handed to a background thread, so that logging
+ * from the audio thread never has to wait for the output. The callback is then invoked from that
+ * thread. Otherwise, it's invoked by the thread that logs the message. It's never invoked by more
+ * than one thread at a time.
+ *
+ * When the same message is logged over and over again, like a decoder that reports the same error
+ * on every audio callback, only the first few per second are passed on, followed by a note of how
+ * many were suppressed. Messages that don't fit into the background thread's queue are dropped and
+ * counted the same way.
+ *
+ * \param callback
+ *  The function to call. An empty function restores the default.
+ */
+AULIB_EXPORT void setLogCallback(LogCallback callback);
+
 } // namespace Aulib
 
 /*
@@ -0,0 +1,251 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "Aulib/Bus.h"
+
+#include "SdlAudioLocker.h"
+#include "bus_p.h"
+#include "mixkernels.h"
+#include "rtcheck.h"
+#include "stream_p.h"
+#include "trace.h"
+#include <SDL_error.h>
+#include <algorithm>
+#include <cstring>
+#include <typeinfo>
+
+std::vector<Aulib::Bus_priv*> Aulib::Bus_priv::fBuses;
+std::vector<Uint32> Aulib::Bus_priv::fGenerations;
+std::vector<int> Aulib::Bus_priv::fOrder;
+
+Aulib::Bus_priv::Bus_priv(Bus* const pub)
+    : q(pub)
+{}
+
+void Aulib::Bus_priv::fUpdateOrder()
+{
+    auto depth = [](const Bus_priv* bus) {
+        int n = 0;
+        for (const Bus_priv* out = bus->fOutput; out; out = out->fOutput) {
+            ++n;
+        }
+        return n;
+    };
+
+    // A bus is always further away from the master output than the bus it outputs to, so sorting
+    // by distance puts every bus before its output.
+    fOrder.clear();
+    for (const auto bus : fBuses) {
+        if (bus) {
+            fOrder.push_back(bus->fSlot);
+        }
+    }
+    std::stable_sort(fOrder.begin(), fOrder.end(),
+                     [&](const int a, const int b) { return depth(fBuses[a]) > depth(fBuses[b]); });
+}
+
+void Aulib::Bus_priv::fUpdateAudibleGains()
+{
+    // Outputs come after the buses that feed them, so go backwards to have them ready first.
+    for (auto it = fOrder.rbegin(); it != fOrder.rend(); ++it) {
+        Bus_priv& bus = *fBuses[*it];
+        const float gain = bus.fMuted ? 0.f : bus.fVolume.load(std::memory_order_relaxed);
+        bus.fAudibleGain = gain * (bus.fOutput ? bus.fOutput->fAudibleGain : 1.f);
+    }
+}
+
+void Aulib::Bus_priv::fMixBuses(const int laneCount, const int samples)
+{
+    AM_traceScope("buses", nullptr);
+    auto& master = *Stream_priv::fMixLanes[0];
+
+    // Collect the partial sums of the other lanes. Lanes only clear the buffers of the buses they
+    // actually mixed into.
+    for (const int slot : fOrder) {
+        float* const dst = master.busBuffer(slot);
+        if (not master.busUsed[slot]) {
+            std::fill(dst, dst + samples, 0.f);
+        }
+        for (int i = 1; i < laneCount; ++i) {
+            auto& lane = *Stream_priv::fMixLanes[i];
+            if (not lane.busUsed[slot]) {
+                continue;
+            }
+            const float* const src = lane.busBuffer(slot);
+            for (int j = 0; j < samples; ++j) {
+                dst[j] += src[j];
+            }
+        }
+    }
+
+    // Buses come before their outputs, so by the time we get to a bus, everything that outputs to
+    // it has been added already.
+    const int channels = Stream_priv::fAudioSpec.channels;
+    const int frames = samples / channels;
+    for (const int slot : fOrder) {
+        Bus_priv& bus = *fBuses[slot];
+        float* const buf = master.busBuffer(slot);
+
+        for (const auto& proc : bus.fProcessors) {
+            AM_rtContext("processor", typeid(*proc).name());
+            AM_traceScope("process", typeid(*proc).name());
+            proc->process(master.procBuf.get(), buf, samples);
+            std::memcpy(buf, master.procBuf.get(), samples * sizeof(*buf));
+        }
+
+        // Ramp from the gain of the previous block, so that volume changes don't click.
+        const float gain = bus.fMuted ? 0.f : bus.fVolume.load(std::memory_order_relaxed);
+        MixGains gains{};
+        gains.left = gains.right = bus.fLastGain < 0.f ? gain : bus.fLastGain;
+        bus.fLastGain = gain;
+        if (gains.left == 0.f and gain == 0.f) {
+            continue;
+        }
+        MixGain gainType = MixGain::Constant;
+        if (gains.left != gain and frames > 0) {
+            gainType = MixGain::Ramp;
+            gains.leftStep = gains.rightStep = (gain - gains.left) / static_cast<float>(frames);
+        } else if (gain == 1.f) {
+            gainType = MixGain::Unity;
+        }
+        float* const out = bus.fOutput ? master.busBuffer(bus.fOutput->fSlot) : master.mixBuf.get();
+        mixKernelFor(channels, gainType, false)(out, buf, frames, gains);
+    }
+}
+
+Aulib::Bus::Bus()
+    : d(std::make_unique<Bus_priv>(this))
+{
+    SdlAudioLocker locker;
+
+    auto& buses = Bus_priv::fBuses;
+    auto freeSlot = std::find(buses.begin(), buses.end(), nullptr);
+    if (freeSlot == buses.end()) {
+        // Grow by doubling. The mix lanes have a buffer for every slot.
+        const auto oldSize = buses.size();
+        buses.resize(std::max<size_t>(8, oldSize * 2), nullptr);
+        Bus_priv::fGenerations.resize(buses.size(), 0);
+        Bus_priv::fOrder.reserve(buses.size());
+        Stream_priv::fReserveBusBuffers();
+        freeSlot = buses.begin() + oldSize;
+    }
+    *freeSlot = d.get();
+    d->fSlot = static_cast<int>(freeSlot - buses.begin());
+    d->fGeneration = Bus_priv::fGenerations[d->fSlot];
+    Bus_priv::fUpdateOrder();
+}
+
+Aulib::Bus::~Bus()
+{
+    SdlAudioLocker locker;
+
+    // Everything that was routed here goes to the master output now.
+    for (const auto bus : Bus_priv::fBuses) {
+        if (bus and bus->fOutput == d.get()) {
+            bus->fOutput = nullptr;
+        }
+    }
+    Stream_priv::fUnrouteBus(*d);
+    Bus_priv::fBuses[d->fSlot] = nullptr;
+    ++Bus_priv::fGenerations[d->fSlot];
+    Bus_priv::fUpdateOrder();
+}
+
+auto Aulib::Bus::setOutput(Bus* const output) -> bool
+{
+    SdlAudioLocker locker;
+
+    Bus_priv* const target = output ? output->d.get() : nullptr;
+    for (const Bus_priv* bus = target; bus; bus = bus->fOutput) {
+        if (bus == d.get()) {
+            SDL_SetError("Cannot route bus output: this would create a cycle.");
+            return false;
+        }
+    }
+    d->fOutput = target;
+    Bus_priv::fUpdateOrder();
+    return true;
+}
+
+auto Aulib::Bus::output() const -> Bus*
+{
+    SdlAudioLocker locker;
+
+    return d->fOutput ? d->fOutput->q : nullptr;
+}
+
+void Aulib::Bus::setVolume(const float volume)
+{
+    d->fVolume = std::max(volume, 0.f);
+}
+
+auto Aulib::Bus::volume() const -> float
+{
+    return d->fVolume;
+}
+
+void Aulib::Bus::mute()
+{
+    d->fMuted = true;
+}
+
+void Aulib::Bus::unmute()
+{
+    d->fMuted = false;
+}
+
+auto Aulib::Bus::isMuted() const -> bool
+{
+    return d->fMuted;
+}
+
+void Aulib::Bus::addProcessor(std::shared_ptr<Processor> processor)
+{
+    SdlAudioLocker locker;
+
+    if (not processor
+        or std::find(d->fProcessors.begin(), d->fProcessors.end(), processor)
+               != d->fProcessors.end()) {
+        return;
+    }
+    d->fProcessors.push_back(std::move(processor));
+}
+
+void Aulib::Bus::removeProcessor(Processor* const processor)
+{
+    SdlAudioLocker locker;
+
+    auto it = std::find_if(
+        d->fProcessors.begin(), d->fProcessors.end(),
+        [processor](const std::shared_ptr<Processor>& p) { return p.get() == processor; });
+    if (it == d->fProcessors.end()) {
+        return;
+    }
+    d->fProcessors.erase(it);
+}
+
+void Aulib::Bus::clearProcessors()
+{
+    SdlAudioLocker locker;
+
+    d->fProcessors.clear();
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
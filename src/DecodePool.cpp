@@ -0,0 +1,205 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "DecodePool.h"
+
+#include "SdlMutex.h"
+#include "aulib_log.h"
+#include "stream_p.h"
+#include "trace.h"
+#include <SDL_cpuinfo.h>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+static SdlMutex gMutex;
+static std::vector<Aulib::Stream_priv*> gStreams;
+static std::vector<SDL_Thread*> gThreads;
+static SDL_sem* gWakeSem = nullptr;
+static std::atomic<bool> gQuit{false};
+static int gThreadCount = 0;
+
+// How long an idle worker sleeps before checking the streams again even if nobody woke it up.
+constexpr Uint32 IDLE_TIMEOUT_MS = 5;
+
+static auto defaultThreadCount() -> int
+{
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+    return std::max(1, SDL_GetCPUCount() / 2);
+#else
+    return 1;
+#endif
+}
+
+// Returns the stream that will run out of buffered samples first, or null if all streams have
+// enough. Since all streams are consumed at the output rate, this is simply the one with the least
+// amount of frames in its ring.
+static auto pickMostStarved() -> Aulib::Stream_priv*
+{
+    Aulib::Stream_priv* best = nullptr;
+    int bestBuffered = 0;
+
+    for (const auto strm : gStreams) {
+        if (strm->fBusy.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        const int buffered = strm->fDecodeAheadStarvation();
+        if (buffered < 0) {
+            continue;
+        }
+        if (not best or buffered < bestBuffered) {
+            best = strm;
+            bestBuffered = buffered;
+        }
+    }
+    return best;
+}
+
+extern "C" {
+static int decodeThreadMain(void* /*unused*/)
+{
+    AM_traceThreadName("decode worker");
+
+    while (not gQuit) {
+        SDL_SemWaitTimeout(gWakeSem, IDLE_TIMEOUT_MS);
+
+        while (not gQuit) {
+            Aulib::Stream_priv* strm;
+            {
+                std::lock_guard<SdlMutex> lock(gMutex);
+                strm = pickMostStarved();
+                if (not strm) {
+                    break;
+                }
+                strm->fBusy = true;
+                // Lock while still holding the pool mutex, so that remove() can't return while
+                // we're about to fill this stream.
+                strm->fDecodeMutex.lock();
+            }
+            strm->fFillDecodeAhead();
+            strm->fBusy = false;
+            strm->fDecodeMutex.unlock();
+        }
+    }
+    return 0;
+}
+}
+
+static void startThreads()
+{
+    if (gThreadCount <= 0) {
+        gThreadCount = defaultThreadCount();
+    }
+    if (not gWakeSem) {
+        gWakeSem = SDL_CreateSemaphore(0);
+        if (not gWakeSem) {
+            aulib::log::warnLn("Failed to create decode thread semaphore: {}", SDL_GetError());
+            return;
+        }
+    }
+    gQuit = false;
+    for (int i = 0; i < gThreadCount; ++i) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+        SDL_Thread* thread = SDL_CreateThread(decodeThreadMain, "aulib decode", nullptr);
+#else
+        SDL_Thread* thread = SDL_CreateThread(decodeThreadMain, nullptr);
+#endif
+        if (not thread) {
+            aulib::log::warnLn("Failed to create decode thread: {}", SDL_GetError());
+            continue;
+        }
+        gThreads.push_back(thread);
+    }
+    aulib::log::debugLn("Started {} decode thread(s).", gThreads.size());
+}
+
+static void stopThreads()
+{
+    gQuit = true;
+    for (size_t i = 0; i < gThreads.size(); ++i) {
+        SDL_SemPost(gWakeSem);
+    }
+    for (const auto thread : gThreads) {
+        SDL_WaitThread(thread, nullptr);
+    }
+    gThreads.clear();
+}
+
+void Aulib::DecodePool::add(Stream_priv* stream)
+{
+    std::lock_guard<SdlMutex> lock(gMutex);
+    if (std::find(gStreams.begin(), gStreams.end(), stream) == gStreams.end()) {
+        gStreams.push_back(stream);
+    }
+    if (gThreads.empty()) {
+        startThreads();
+    }
+}
+
+void Aulib::DecodePool::remove(Stream_priv* stream)
+{
+    std::lock_guard<SdlMutex> lock(gMutex);
+    gStreams.erase(std::remove(gStreams.begin(), gStreams.end(), stream), gStreams.end());
+}
+
+void Aulib::DecodePool::wake() noexcept
+{
+    if (gWakeSem and SDL_SemValue(gWakeSem) == 0) {
+        SDL_SemPost(gWakeSem);
+    }
+}
+
+void Aulib::DecodePool::setThreadCount(const int count)
+{
+    const int newCount = count > 0 ? count : defaultThreadCount();
+    // Workers take gMutex, so don't hold it while waiting for them to exit.
+    const bool wasRunning = [] {
+        std::lock_guard<SdlMutex> lock(gMutex);
+        return not gThreads.empty();
+    }();
+    if (wasRunning) {
+        stopThreads();
+    }
+    std::lock_guard<SdlMutex> lock(gMutex);
+    gThreadCount = newCount;
+    if (wasRunning) {
+        startThreads();
+    }
+}
+
+auto Aulib::DecodePool::threadCount() -> int
+{
+    std::lock_guard<SdlMutex> lock(gMutex);
+    return gThreadCount > 0 ? gThreadCount : defaultThreadCount();
+}
+
+void Aulib::DecodePool::shutdown()
+{
+    stopThreads();
+    if (gWakeSem) {
+        SDL_DestroySemaphore(gWakeSem);
+        gWakeSem = nullptr;
+    }
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
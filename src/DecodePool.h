@@ -0,0 +1,58 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_global.h"
+
+namespace Aulib {
+
+struct Stream_priv;
+
+/*
+ * Shared pool of worker threads that decode and resample audio ahead of time for streams that have
+ * decode-ahead enabled. The workers fill each stream's ring buffer, always serving the stream that
+ * is closest to running dry first, so that the audio callback only needs to copy samples out of the
+ * rings.
+ *
+ * Lock order is pool first, then the stream's decode mutex. Workers never take the SDL audio lock.
+ */
+namespace DecodePool {
+
+// Registers a stream with the pool. Starts the worker threads if they're not running yet.
+AULIB_NO_EXPORT void add(Stream_priv* stream);
+
+// Unregisters a stream. After this returns, no worker will pick the stream again, but one might
+// still be filling it. Lock and unlock the stream's decode mutex to wait for that.
+AULIB_NO_EXPORT void remove(Stream_priv* stream);
+
+// Wakes up the workers. Called from the audio callback after each block, so it doesn't block.
+AULIB_NO_EXPORT void wake() noexcept;
+
+AULIB_NO_EXPORT void setThreadCount(int count);
+AULIB_NO_EXPORT auto threadCount() -> int;
+
+// Stops all worker threads. They will be started again on the next add().
+AULIB_NO_EXPORT void shutdown();
+
+} // namespace DecodePool
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
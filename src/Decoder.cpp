@@ -1,33 +1,34 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "Aulib/Decoder.h"
 
-#include "Aulib/DecoderAdlmidi.h"
-#include "Aulib/DecoderBassmidi.h"
-#include "Aulib/DecoderDrflac.h"
-#include "Aulib/DecoderDrmp3.h"
-#include "Aulib/DecoderDrwav.h"
-#include "Aulib/DecoderFluidsynth.h"
-#include "Aulib/DecoderModplug.h"
-#include "Aulib/DecoderMpg123.h"
-#include "Aulib/DecoderMusepack.h"
-#include "Aulib/DecoderOpenmpt.h"
-#include "Aulib/DecoderOpus.h"
-#include "Aulib/DecoderSndfile.h"
-#include "Aulib/DecoderVorbis.h"
-#include "Aulib/DecoderWildmidi.h"
-#include "Aulib/DecoderXmp.h"
 #include "Buffer.h"
+#include "DecoderSniffer.h"
 #include "aulib.h"
 #include "aulib_config.h"
+#include "aulib_log.h"
+#include "chanlayout.h"
+#include "mixkernels.h"
+#include "mixstats.h"
+#include "rtcheck.h"
+#include "sampleconv.h"
+#include "trace.h"
 #include <SDL_audio.h>
 #include <SDL_rwops.h>
-#include <array>
+#include <cstring>
+#include <utility>
 
 namespace Aulib {
 
 struct Decoder_priv final
 {
-    Buffer<float> stereoBuf{0};
+    // Decoded audio that still needs to be converted to the output channels.
+    Buffer<float> convBuf{0};
+    // Conversion for layouts other than mono and stereo.
+    LayoutMatrix layout;
+    // Interleaved audio for decoders that can't decode planar audio themselves.
+    Buffer<float> interleavedBuf{0};
+    // 0 follows Aulib::channelCount().
+    int outChannels = 0;
     bool isOpen = false;
 };
 
@@ -44,101 +45,113 @@ auto Aulib::Decoder::decoderFor(const std::string& filename) -> std::unique_ptr<
     auto rwopsClose = [](SDL_RWops* rwops) { SDL_RWclose(rwops); };
     std::unique_ptr<SDL_RWops, decltype(rwopsClose)> rwops(SDL_RWFromFile(filename.c_str(), "rb"),
                                                            rwopsClose);
-    return Decoder::decoderFor(rwops.get());
+    return Decoder::decoderFor(rwops.get(), filename);
 }
 
 auto Aulib::Decoder::decoderFor(SDL_RWops* rwops) -> std::unique_ptr<Aulib::Decoder>
 {
-    const auto rwPos = SDL_RWtell(rwops);
+    return Decoder::decoderFor(rwops, {});
+}
 
-    auto rewindRwops = [rwops, rwPos] { SDL_RWseek(rwops, rwPos, RW_SEEK_SET); };
-
-    [[maybe_unused]] auto tryDecoder = [rwops, &rewindRwops](auto dec) {
-        rewindRwops();
-        bool ret = dec->open(rwops);
-        rewindRwops();
-        return ret;
-    };
-
-#if USE_DEC_DRFLAC
-    if (tryDecoder(std::make_unique<DecoderDrflac>())) {
-        return std::make_unique<Aulib::DecoderDrflac>();
-    }
-#endif
-#if USE_DEC_LIBVORBIS
-    if (tryDecoder(std::make_unique<DecoderVorbis>())) {
-        return std::make_unique<Aulib::DecoderVorbis>();
-    }
-#endif
-#if USE_DEC_LIBOPUSFILE
-    if (tryDecoder(std::make_unique<DecoderOpus>())) {
-        return std::make_unique<Aulib::DecoderOpus>();
-    }
-#endif
-#if USE_DEC_MUSEPACK
-    if (tryDecoder(std::make_unique<DecoderMusepack>())) {
-        return std::make_unique<Aulib::DecoderMusepack>();
-    }
-#endif
-#if USE_DEC_FLUIDSYNTH or USE_DEC_BASSMIDI or USE_DEC_WILDMIDI or USE_DEC_ADLMIDI
-    {
-        std::array<char, 5> head{};
-        if (SDL_RWread(rwops, head.data(), 1, 4) == 4 and head == decltype(head){"MThd"}) {
-            using midi_dec_type =
-#    if USE_DEC_FLUIDSYNTH
-                DecoderFluidsynth;
-#    elif USE_DEC_BASSMIDI
-                DecoderBassmidi;
-#    elif USE_DEC_WILDMIDI
-                DecoderWildmidi;
-#    elif USE_DEC_ADLMIDI
-                DecoderAdlmidi;
-#    endif
-            if (tryDecoder(std::make_unique<midi_dec_type>())) {
-                return std::make_unique<midi_dec_type>();
-            }
+// Opens the first of 'sniffers' that accepts the data. On success, 'rwops' is left wherever the
+// decoder left it, since the decoder might depend on that.
+static auto openFirst(SDL_RWops* rwops, const std::vector<const Aulib::DecoderSniffer*>& sniffers)
+    -> std::pair<std::unique_ptr<Aulib::Decoder>, const Aulib::DecoderSniffer*>
+{
+    const auto rwPos = SDL_RWtell(rwops);
+    for (const auto* sniffer : sniffers) {
+        auto dec = sniffer->create();
+        if (dec->open(rwops)) {
+            aulib::log::debugLn("Detected decoder: {}", sniffer->name);
+            return {std::move(dec), sniffer};
         }
+        SDL_RWseek(rwops, rwPos, RW_SEEK_SET);
     }
-#endif
-#if USE_DEC_SNDFILE
-    if (tryDecoder(std::make_unique<DecoderSndfile>())) {
-        return std::make_unique<Aulib::DecoderSndfile>();
+    return {nullptr, nullptr};
+}
+
+// Opens the first decoder that recognizes the data. On success, 'rwops' is left wherever the
+// decoder left it, since the decoder might depend on that.
+static auto openSniffed(SDL_RWops* rwops, const std::string& nameHint)
+    -> std::pair<std::unique_ptr<Aulib::Decoder>, const Aulib::DecoderSniffer*>
+{
+    // Only the decoders whose format was recognized get to open the file. Usually that's just one.
+    const auto sniffed = Aulib::sniffDecoders(rwops, nameHint);
+    auto opened = openFirst(rwops, sniffed);
+    if (opened.first) {
+        return opened;
     }
-#endif
-#if USE_DEC_DRWAV
-    if (tryDecoder(std::make_unique<DecoderDrwav>())) {
-        return std::make_unique<Aulib::DecoderDrwav>();
+    // Not every file has a magic number we check for, like MP3s that don't start with a frame or
+    // modules in some of the older formats. Those are left to the decoders themselves.
+    return openFirst(rwops, Aulib::fallbackDecoders(sniffed));
+}
+
+auto Aulib::Decoder::decoderFor(SDL_RWops* rwops, const std::string& nameHint)
+    -> std::unique_ptr<Aulib::Decoder>
+{
+    if (not rwops) {
+        return nullptr;
     }
-#endif
-#if USE_DEC_OPENMPT
-    if (tryDecoder(std::make_unique<DecoderOpenmpt>())) {
-        return std::make_unique<Aulib::DecoderOpenmpt>();
+
+    const auto rwPos = SDL_RWtell(rwops);
+    const auto* sniffer = openSniffed(rwops, nameHint).second;
+    SDL_RWseek(rwops, rwPos, RW_SEEK_SET);
+    return sniffer ? sniffer->create() : nullptr;
+}
+
+auto Aulib::Decoder::probe(const std::string& filename) -> ProbedDecoder
+{
+    SDL_RWops* rwops = SDL_RWFromFile(filename.c_str(), "rb");
+    if (not rwops) {
+        return {};
     }
-#endif
+    return Decoder::probe(rwops, true, filename);
+}
 
-#if USE_DEC_XMP
-    if (tryDecoder(std::make_unique<DecoderXmp>())) {
-        return std::make_unique<Aulib::DecoderXmp>();
+auto Aulib::Decoder::probe(SDL_RWops* rwops, bool closeRw, const std::string& nameHint)
+    -> ProbedDecoder
+{
+    ProbedDecoder probed;
+    probed.rwops = rwops;
+    probed.closeRw = closeRw;
+    if (not rwops) {
+        SDL_SetError("Cannot probe null rwops.");
+        return probed;
+    }
+    probed.decoder = openSniffed(rwops, nameHint).first;
+    if (not probed.decoder) {
+        SDL_SetError("No decoder can open the data.");
     }
-#endif
-#if USE_DEC_MODPLUG
-    // We don't try ModPlug, since it thinks just about anything is a module
-    // file, which would result in virtually everything we feed it giving a
-    // false positive.
-#endif
+    return probed;
+}
+
+Aulib::ProbedDecoder::ProbedDecoder(ProbedDecoder&& other) noexcept
+    : decoder(std::move(other.decoder))
+    , rwops(std::exchange(other.rwops, nullptr))
+    , closeRw(std::exchange(other.closeRw, false))
+{}
 
-// The MP3 decoders have too many false positives. So try them last.
-#if USE_DEC_MPG123
-    if (tryDecoder(std::make_unique<DecoderMpg123>())) {
-        return std::make_unique<Aulib::DecoderMpg123>();
+auto Aulib::ProbedDecoder::operator=(ProbedDecoder&& other) noexcept -> ProbedDecoder&
+{
+    if (this != &other) {
+        decoder.reset();
+        if (closeRw and rwops) {
+            SDL_RWclose(rwops);
+        }
+        decoder = std::move(other.decoder);
+        rwops = std::exchange(other.rwops, nullptr);
+        closeRw = std::exchange(other.closeRw, false);
     }
-#endif
-#if USE_DEC_DRMP3
-    if (tryDecoder(std::make_unique<DecoderDrmp3>())) {
-        return std::make_unique<Aulib::DecoderDrmp3>();
+    return *this;
+}
+
+Aulib::ProbedDecoder::~ProbedDecoder()
+{
+    // The decoder might still need the rwops while it's being destroyed.
+    decoder.reset();
+    if (closeRw and rwops) {
+        SDL_RWclose(rwops);
     }
-#endif
-    return nullptr;
 }
 
 auto Aulib::Decoder::isOpen() const -> bool
@@ -146,6 +159,16 @@ auto Aulib::Decoder::isOpen() const -> bool
     return d->isOpen;
 }
 
+void Aulib::Decoder::setOutputChannels(const int channels)
+{
+    d->outChannels = channels;
+}
+
+auto Aulib::Decoder::outputChannels() const -> int
+{
+    return d->outChannels > 0 ? d->outChannels : Aulib::channelCount();
+}
+
 // Conversion happens in-place.
 static constexpr void monoToStereo(float buf[], int len)
 {
@@ -171,21 +194,104 @@ static constexpr void stereoToMono(float dst[], const float src[], int srcLen)
 
 auto Aulib::Decoder::decode(float buf[], int len, bool& callAgain) -> int
 {
-    if (this->getChannels() == 1 and Aulib::channelCount() == 2) {
+    AM_rtContext("decoder", typeid(*this).name());
+    AM_statsTime(Decode);
+    AM_traceScope("decode", typeid(*this).name());
+
+    const int outChannels = outputChannels();
+    const int srcChannels = this->getChannels();
+
+    if (srcChannels == outChannels) {
+        return this->doDecoding(buf, len, callAgain);
+    }
+
+    if (srcChannels == 1 and outChannels == 2) {
         int srcLen = this->doDecoding(buf, len / 2, callAgain);
         monoToStereo(buf, srcLen * 2);
         return srcLen * 2;
     }
 
-    if (this->getChannels() == 2 and Aulib::channelCount() == 1) {
-        if (d->stereoBuf.size() != len * 2) {
-            d->stereoBuf.reset(len * 2);
-        }
-        int srcLen = this->doDecoding(d->stereoBuf.get(), d->stereoBuf.size(), callAgain);
-        stereoToMono(buf, d->stereoBuf.get(), srcLen);
+    if (srcChannels > MAX_CHANNELS) {
+        SDL_SetError("Cannot decode more than %d channels.", MAX_CHANNELS);
+        callAgain = false;
+        return 0;
+    }
+
+    // Only grow the buffer. The requested length varies between calls.
+    const int frames = len / outChannels;
+    if (d->convBuf.size() < frames * srcChannels) {
+        d->convBuf.reset(frames * srcChannels);
+    }
+
+    if (srcChannels == 2 and outChannels == 1) {
+        int srcLen = this->doDecoding(d->convBuf.get(), frames * 2, callAgain);
+        stereoToMono(buf, d->convBuf.get(), srcLen);
         return srcLen / 2;
     }
-    return this->doDecoding(buf, len, callAgain);
+
+    if (d->layout.inChannels != srcChannels or d->layout.outChannels != outChannels) {
+        d->layout = layoutMatrix(srcChannels, outChannels);
+    }
+    const int decFrames =
+        this->doDecoding(d->convBuf.get(), frames * srcChannels, callAgain) / srcChannels;
+    layoutKernelFor()(buf, d->convBuf.get(), decFrames, d->layout);
+    return decFrames * outChannels;
+}
+
+auto Aulib::Decoder::decodePlanar(float* const bufs[], const int frames, bool& callAgain) -> int
+{
+    const int outChannels = outputChannels();
+    const int srcChannels = this->getChannels();
+
+    // Only mono and stereo are converted here. Other layouts go through decode().
+    const bool planarLayout = srcChannels == outChannels
+                              or (srcChannels <= 2 and outChannels <= 2);
+    if (not this->supportsPlanar() or not planarLayout) {
+        const int len = frames * outChannels;
+        if (d->interleavedBuf.size() < len) {
+            d->interleavedBuf.reset(len);
+        }
+        const int decFrames = this->decode(d->interleavedBuf.get(), len, callAgain) / outChannels;
+        deinterleave(bufs, d->interleavedBuf.get(), outChannels, decFrames);
+        return decFrames;
+    }
+
+    AM_rtContext("decoder", typeid(*this).name());
+    AM_statsTime(Decode);
+    AM_traceScope("decode", typeid(*this).name());
+
+    if (srcChannels == 1 and outChannels == 2) {
+        const int decFrames = this->doDecodingPlanar(bufs, frames, callAgain);
+        memcpy(bufs[1], bufs[0], static_cast<size_t>(decFrames) * sizeof(*bufs[0]));
+        return decFrames;
+    }
+
+    if (srcChannels == 2 and outChannels == 1) {
+        if (d->convBuf.size() < frames) {
+            d->convBuf.reset(frames);
+        }
+        float* const right = d->convBuf.get();
+        float* const planes[]{bufs[0], right};
+        const int decFrames = this->doDecodingPlanar(planes, frames, callAgain);
+        // Same operations as stereoToMono(), so both paths give the same result.
+        for (int i = 0; i < decFrames; ++i) {
+            bufs[0][i] *= 0.5f;
+            bufs[0][i] += right[i] * 0.5f;
+        }
+        return decFrames;
+    }
+    return this->doDecodingPlanar(bufs, frames, callAgain);
+}
+
+auto Aulib::Decoder::supportsPlanar() const -> bool
+{
+    return false;
+}
+
+auto Aulib::Decoder::doDecodingPlanar(float* const /*bufs*/[], int /*frames*/,
+                                      bool& /*callAgain*/) -> int
+{
+    return 0;
 }
 
 void Aulib::Decoder::setIsOpen(bool f)
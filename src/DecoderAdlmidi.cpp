@@ -1,7 +1,7 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "Aulib/DecoderAdlmidi.h"
 
-#include "Buffer.h"
+#include "RwopsView.h"
 #include "aulib.h"
 #include "aulib_log.h"
 #include "missing.h"
@@ -204,14 +204,8 @@ auto Aulib::DecoderAdlmidi::open(SDL_RWops* rwops) -> bool
     if (isOpen()) {
         return true;
     }
-    Sint64 midiDataLen = SDL_RWsize(rwops);
-    if (midiDataLen <= 0) {
-        SDL_SetError("Tried to open zero-length MIDI data source.");
-        return false;
-    }
-    Buffer<Uint8> new_midi_data(midiDataLen);
-    if (SDL_RWread(rwops, new_midi_data.get(), new_midi_data.size(), 1) != 1) {
-        SDL_SetError("Failed to read MIDI data.");
+    const auto new_midi_data = RwopsView::load(rwops);
+    if (not new_midi_data) {
         return false;
     }
     d->adl_player.reset(adl_init(SAMPLE_RATE));
@@ -233,7 +227,7 @@ auto Aulib::DecoderAdlmidi::open(SDL_RWops* rwops) -> bool
         or (d->embedded_bank >= 0 and not d->setEmbeddedBank())) {
         return false;
     }
-    if (adl_openData(d->adl_player.get(), new_midi_data.get(), new_midi_data.size()) != 0) {
+    if (adl_openData(d->adl_player.get(), new_midi_data->data(), new_midi_data->size()) != 0) {
         SDL_SetError("libADLMIDI failed to open MIDI data: %s", adl_errorInfo(d->adl_player.get()));
         return false;
     }
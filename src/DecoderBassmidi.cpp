@@ -1,7 +1,7 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "Aulib/DecoderBassmidi.h"
 
-#include "Buffer.h"
+#include "RwopsView.h"
 #include "aulib.h"
 #include "aulib_log.h"
 #include "missing.h"
@@ -81,8 +81,9 @@ struct DecoderBassmidi_priv final
 {
     DecoderBassmidi_priv();
 
+    // Declared before the stream, so that it outlives it.
+    std::unique_ptr<RwopsView> midiData;
     HstreamWrapper hstream;
-    Buffer<Uint8> midiData{0};
     bool eof = false;
 };
 
@@ -124,22 +125,19 @@ auto Aulib::DecoderBassmidi::open(SDL_RWops* rwops) -> bool
     }
 
     // FIXME: error reporting
-    Sint64 midiDataLen = SDL_RWsize(rwops);
-    if (midiDataLen <= 0) {
+    auto newMidiData = RwopsView::load(rwops);
+    if (not newMidiData) {
         return false;
     }
-    Buffer<Uint8> newMidiData(midiDataLen);
     DWORD bassFlags =
         BASS_SAMPLE_FLOAT | BASS_STREAM_DECODE | BASS_MIDI_DECAYEND | BASS_MIDI_SINCINTER;
 
-    if (SDL_RWread(rwops, newMidiData.get(), newMidiData.size(), 1) != 1) {
-        return false;
-    }
-    d->hstream.reset(TRUE, newMidiData.get(), 0, newMidiData.size(), bassFlags, 1);
+    // BASS keeps reading from the memory while playing.
+    d->hstream.reset(TRUE, newMidiData->data(), 0, newMidiData->size(), bassFlags, 1);
     if (not d->hstream) {
         return false;
     }
-    d->midiData.swap(newMidiData);
+    d->midiData = std::move(newMidiData);
     setIsOpen(true);
     return true;
 }
@@ -3,6 +3,7 @@
 
 #define DR_FLAC_NO_STDIO
 
+#include "RwopsView.h"
 #include "aulib_log.h"
 #include "dr_flac.h"
 #include "missing.h"
@@ -62,6 +63,9 @@ namespace Aulib {
 
 struct DecoderDrflac_priv final
 {
+    // Set when decoding straight from memory instead of through the rwops callbacks. Declared
+    // before the handle, so that it outlives it.
+    std::unique_ptr<RwopsView> fView;
     std::unique_ptr<drflac, decltype(&drflac_close)> handle_{nullptr, drflac_close};
     bool fEOF = false;
 };
@@ -80,8 +84,13 @@ auto Aulib::DecoderDrflac::open(SDL_RWops* const rwops) -> bool
         return true;
     }
 
-    d->handle_ = {drflac_open(drflacReadCb, drflacSeekCb, rwops, nullptr), drflac_close};
+    // Files and memory are decoded in place. Everything else goes through the rwops.
+    d->fView = RwopsView::map(rwops);
+    d->handle_ = {d->fView ? drflac_open_memory(d->fView->data(), d->fView->size(), nullptr)
+                           : drflac_open(drflacReadCb, drflacSeekCb, rwops, nullptr),
+                  drflac_close};
     if (not d->handle_) {
+        d->fView.reset();
         SDL_SetError("drflac_open returned null.");
         return false;
     }
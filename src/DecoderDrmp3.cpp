@@ -3,6 +3,7 @@
 
 #define DR_MP3_NO_STDIO
 
+#include "RwopsView.h"
 #include "aulib_log.h"
 #include "dr_mp3.h"
 #include "missing.h"
@@ -62,6 +63,8 @@ namespace Aulib {
 
 struct DecoderDrmp3_priv final
 {
+    // Set when decoding straight from memory instead of through the rwops callbacks.
+    std::unique_ptr<RwopsView> fView;
     drmp3 handle_{};
     std::chrono::microseconds duration_{};
     bool fEOF = false;
@@ -87,13 +90,19 @@ auto Aulib::DecoderDrmp3::open(SDL_RWops* const rwops) -> bool
         return true;
     }
 
-    if (not drmp3_init(&d->handle_, drmp3ReadCb, drmp3SeekCb, rwops, nullptr)) {
+    // Files and memory are decoded in place. Everything else goes through the rwops.
+    d->fView = RwopsView::map(rwops);
+    const bool ok = d->fView ? drmp3_init_memory(&d->handle_, d->fView->data(), d->fView->size(),
+                                                 nullptr)
+                             : drmp3_init(&d->handle_, drmp3ReadCb, drmp3SeekCb, rwops, nullptr);
+    if (not ok) {
+        d->fView.reset();
         SDL_SetError("drmp3_init failed.");
         return false;
     }
     // Calculating the duration on an MP3 stream involves iterating over every frame in it, which is
     // only possible when the total size of the stream is known.
-    if (SDL_RWsize(rwops) > 0) {
+    if (d->fView or SDL_RWsize(rwops) > 0) {
         d->duration_ = chrono::duration_cast<chrono::microseconds>(chrono::duration<double>(
             static_cast<double>(drmp3_get_pcm_frame_count(&d->handle_)) / getRate()));
     }
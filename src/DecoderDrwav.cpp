@@ -3,6 +3,7 @@
 
 #define DR_WAV_NO_STDIO
 
+#include "RwopsView.h"
 #include "aulib_log.h"
 #include "dr_wav.h"
 #include "missing.h"
@@ -62,6 +63,8 @@ namespace Aulib {
 
 struct DecoderDrwav_priv final
 {
+    // Set when decoding straight from memory instead of through the rwops callbacks.
+    std::unique_ptr<RwopsView> fView;
     drwav handle_{};
     bool fEOF = false;
 };
@@ -86,7 +89,13 @@ auto Aulib::DecoderDrwav::open(SDL_RWops* const rwops) -> bool
         return true;
     }
 
-    if (not drwav_init(&d->handle_, drwavReadCb, drwavSeekCb, rwops, nullptr)) {
+    // Files and memory are decoded in place. Everything else goes through the rwops.
+    d->fView = RwopsView::map(rwops);
+    const bool ok = d->fView ? drwav_init_memory(&d->handle_, d->fView->data(), d->fView->size(),
+                                                 nullptr)
+                             : drwav_init(&d->handle_, drwavReadCb, drwavSeekCb, rwops, nullptr);
+    if (not ok) {
+        d->fView.reset();
         SDL_SetError("drwav_init failed.");
         return false;
     }
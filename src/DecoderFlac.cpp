@@ -1,9 +1,12 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "Aulib/DecoderFlac.h"
 #include "aulib_log.h"
+#include "chanlayout.h"
 #include "missing.h"
+#include "sampleconv.h"
 #include <FLAC/stream_decoder.h>
 #include <SDL_rwops.h>
+#include <algorithm>
 #include <array>
 
 namespace chrono = std::chrono;
@@ -20,13 +23,19 @@ struct DecoderFlac_priv final
 
     FlacHandle fFlacHandle{nullptr, FLAC__stream_decoder_delete};
     SDL_RWops* fRwops = nullptr;
-    std::array<const FLAC__int32*, 2> fBuffers{};
+    std::array<const FLAC__int32*, MAX_CHANNELS> fBuffers{};
     const FLAC__Frame* fFlacFrame = nullptr;
-    float fSampleConvFactor = 0;
+    // Scales samples to [-1, 1). Multiplying is faster than dividing, and exact for powers of two.
+    float fSampleScale = 0;
+    int fBitsPerSample = 0;
     int fRemainingFrames = 0;
     chrono::microseconds fDuration{};
     int fSampleRate = 0;
     int fChannels = 0;
+    // Channels we output, in SDL's order, and the FLAC channel each of them comes from. -1 means
+    // there is none and the channel is silent.
+    int fOutChannels = 0;
+    std::array<int, MAX_CHANNELS> fSources{};
     bool fEOF = false;
     DecoderFlac::FileFormat fFileFormat;
     const char* fLastError = nullptr;
@@ -109,9 +118,16 @@ void flacMetadataCb(
 
     auto* const d = static_cast<Aulib::DecoderFlac_priv*>(d_ptr);
     const auto& info = metadata->data.stream_info;
-    d->fSampleConvFactor = 1u << (info.bits_per_sample - 1);
+    d->fSampleScale = 1.f / static_cast<float>(1u << (info.bits_per_sample - 1));
+    d->fBitsPerSample = info.bits_per_sample;
     d->fSampleRate = info.sample_rate;
     d->fChannels = info.channels;
+    const auto map = Aulib::flacChannelMap(d->fChannels);
+    d->fOutChannels = map.outChannels;
+    d->fSources.fill(-1);
+    for (int chan = 0; chan < std::min(d->fChannels, Aulib::MAX_CHANNELS); ++chan) {
+        d->fSources[map.target[chan]] = chan;
+    }
     d->fDuration = chrono::duration_cast<chrono::microseconds>(
         chrono::duration<double>(static_cast<float>(info.total_samples) / info.sample_rate));
 
@@ -129,9 +145,8 @@ auto flacWriteCb(
 
     d->fFlacFrame = frame;
     d->fRemainingFrames = frame->header.blocksize;
-    d->fBuffers[0] = buffer[0];
-    if (d->fChannels > 1) {
-        d->fBuffers[1] = buffer[1];
+    for (int chan = 0; chan < std::min(d->fChannels, Aulib::MAX_CHANNELS); ++chan) {
+        d->fBuffers[chan] = buffer[chan];
     }
     return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 }
@@ -253,7 +268,7 @@ auto Aulib::DecoderFlac::open(SDL_RWops* const rwops) -> bool
 
 auto Aulib::DecoderFlac::getChannels() const -> int
 {
-    return d->fChannels;
+    return d->fOutChannels;
 }
 
 auto Aulib::DecoderFlac::getRate() const -> int
@@ -261,6 +276,33 @@ auto Aulib::DecoderFlac::getRate() const -> int
     return d->fSampleRate;
 }
 
+/* Decodes the next FLAC frame if the current one has been used up. Returns false if decoding
+ * failed.
+ */
+static auto fillFrame(Aulib::DecoderFlac_priv& d) -> bool
+{
+    if (d.fRemainingFrames == 0) {
+        d.fLastError = nullptr;
+        if (not FLAC__stream_decoder_process_single(d.fFlacHandle.get())) {
+            const auto state = FLAC__stream_decoder_get_state(d.fFlacHandle.get());
+            aulib::log::warnLn(
+                "DecoderFlac: libFLAC error while decoding: {}.",
+                FLAC__StreamDecoderStateString[state]);
+            d.fRemainingFrames = 0;
+            return false;
+        }
+        if (d.fLastError) {
+            aulib::log::warnLn("DecoderFlac: possible error while decoding: {}", d.fLastError);
+        }
+    }
+
+    if (d.fHasLostSync) {
+        aulib::log::warnLn("DecoderFlac: libFLAC has lost sync during decoding.");
+        return false;
+    }
+    return true;
+}
+
 auto Aulib::DecoderFlac::doDecoding(float buf[], const int len, bool& /*callAgain*/) -> int
 {
     if ((d->fEOF and d->fRemainingFrames == 0) or not isOpen()) {
@@ -271,27 +313,11 @@ auto Aulib::DecoderFlac::doDecoding(float buf[], const int len, bool& /*callAgai
         return 0;
     }
 
-    const int channels = std::min(d->fChannels, 2);
+    const int channels = d->fOutChannels;
     int total_samples = 0;
 
     while (total_samples < len) {
-        if (d->fRemainingFrames == 0) {
-            d->fLastError = nullptr;
-            if (not FLAC__stream_decoder_process_single(d->fFlacHandle.get())) {
-                const auto state = FLAC__stream_decoder_get_state(d->fFlacHandle.get());
-                aulib::log::warnLn(
-                    "DecoderFlac: libFLAC error while decoding: {}.",
-                    FLAC__StreamDecoderStateString[state]);
-                d->fRemainingFrames = 0;
-                return 0;
-            }
-            if (d->fLastError) {
-                aulib::log::warnLn("DecoderFlac: possible error while decoding: {}", d->fLastError);
-            }
-        }
-
-        if (d->fHasLostSync) {
-            aulib::log::warnLn("DecoderFlac: libFLAC has lost sync during decoding.");
+        if (not fillFrame(*d)) {
             return 0;
         }
         if (d->fRemainingFrames == 0) {
@@ -303,13 +329,60 @@ auto Aulib::DecoderFlac::doDecoding(float buf[], const int len, bool& /*callAgai
              total_samples < len and d->fRemainingFrames > 0; ++frame, --d->fRemainingFrames)
         {
             for (int chan = 0; chan < channels; ++chan, ++buf, ++total_samples) {
-                *buf = d->fBuffers[chan][frame] / d->fSampleConvFactor;
+                const int src = d->fSources[chan];
+                *buf = src < 0 ? 0.f
+                               : static_cast<float>(d->fBuffers[src][frame]) * d->fSampleScale;
             }
         }
     }
     return total_samples;
 }
 
+auto Aulib::DecoderFlac::supportsPlanar() const -> bool
+{
+    return true;
+}
+
+auto Aulib::DecoderFlac::doDecodingPlanar(float* const bufs[], const int frames,
+                                          bool& /*callAgain*/) -> int
+{
+    if ((d->fEOF and d->fRemainingFrames == 0) or not isOpen()) {
+        return 0;
+    }
+    if (d->fHasLostSync) {
+        aulib::log::warnLn("DecoderFlac: Refusing to decode since libFLAC has lost sync.");
+        return 0;
+    }
+
+    const int channels = d->fOutChannels;
+    int total_frames = 0;
+
+    while (total_frames < frames) {
+        if (not fillFrame(*d)) {
+            return 0;
+        }
+        if (d->fRemainingFrames == 0) {
+            d->fEOF = true;
+            return total_frames;
+        }
+
+        // libFLAC hands us one buffer per channel, so each one converts in a single pass.
+        const int offset = d->fFlacFrame->header.blocksize - d->fRemainingFrames;
+        const int count = std::min(frames - total_frames, d->fRemainingFrames);
+        for (int chan = 0; chan < channels; ++chan) {
+            if (const int src = d->fSources[chan]; src >= 0) {
+                s32ToFloat(bufs[chan] + total_frames, d->fBuffers[src] + offset, count,
+                           d->fBitsPerSample);
+            } else {
+                std::fill(bufs[chan] + total_frames, bufs[chan] + total_frames + count, 0.f);
+            }
+        }
+        total_frames += count;
+        d->fRemainingFrames -= count;
+    }
+    return total_frames;
+}
+
 auto Aulib::DecoderFlac::rewind() -> bool
 {
     return seekToTime({});
@@ -2,6 +2,7 @@
 #include "Aulib/DecoderFluidsynth.h"
 
 #include "Buffer.h"
+#include "RwopsView.h"
 #include "aulib.h"
 #include "aulib_log.h"
 #include "missing.h"
@@ -115,7 +116,7 @@ struct DecoderFluidsynth_priv final
     std::unique_ptr<fluid_player_t, decltype(&delete_fluid_player)> fPlayer{nullptr,
                                                                             &delete_fluid_player};
     fluid_sfloader_t* sfloader = nullptr;
-    Buffer<Uint8> fMidiData{0};
+    std::unique_ptr<RwopsView> fMidiData;
     bool fEOF = false;
 };
 
@@ -221,14 +222,13 @@ auto Aulib::DecoderFluidsynth::open(SDL_RWops* rwops) -> bool
         return false;
     }
 
-    Sint64 midiDataLen = SDL_RWsize(rwops);
-    if (midiDataLen <= 0) {
-        SDL_SetError("Invalid MIDI data.");
+    // Kept around for rewinding, which needs to hand the data to a new player.
+    auto midiData = RwopsView::load(rwops);
+    if (not midiData) {
         return false;
     }
-    Buffer<Uint8> newMidiData(midiDataLen);
-    if (SDL_RWread(rwops, newMidiData.get(), newMidiData.size(), 1) != 1) {
-        SDL_SetError("Unable to read MIDI data. %s", SDL_GetError());
+    if (midiData->size() == 0) {
+        SDL_SetError("Invalid MIDI data.");
         return false;
     }
     d->fPlayer.reset(new_fluid_player(d->fSynth.get()));
@@ -236,8 +236,7 @@ auto Aulib::DecoderFluidsynth::open(SDL_RWops* rwops) -> bool
         SDL_SetError("Failed to create FluidSynth player.");
         return false;
     }
-    if (fluid_player_add_mem(d->fPlayer.get(), newMidiData.get(), newMidiData.usize())
-        != FLUID_OK) {
+    if (fluid_player_add_mem(d->fPlayer.get(), midiData->data(), midiData->size()) != FLUID_OK) {
         SDL_SetError("FluidSynth failed to load MIDI data.");
         return false;
     }
@@ -245,7 +244,7 @@ auto Aulib::DecoderFluidsynth::open(SDL_RWops* rwops) -> bool
         SDL_SetError("FluidSynth failed to start MIDI player.");
         return false;
     }
-    d->fMidiData.swap(newMidiData);
+    d->fMidiData = std::move(midiData);
     setIsOpen(true);
     return true;
 }
@@ -279,13 +278,14 @@ auto Aulib::DecoderFluidsynth::doDecoding(float buf[], int len, bool& /*callAgai
         return 0;
     }
 
-    len /= Aulib::channelCount();
+    // Only the first stereo pair is rendered.
+    len /= 2;
     int res = fluid_synth_write_float(d->fSynth.get(), len, buf, 0, 2, buf, 1, 2);
     if (fluid_player_get_status(d->fPlayer.get()) == FLUID_PLAYER_DONE) {
         d->fEOF = true;
     }
     if (res == FLUID_OK) {
-        return len * Aulib::channelCount();
+        return len * 2;
     }
     return 0;
 }
@@ -302,7 +302,7 @@ auto Aulib::DecoderFluidsynth::rewind() -> bool
         SDL_SetError("FluidSynth failed to create new player.");
         return false;
     }
-    fluid_player_add_mem(d->fPlayer.get(), d->fMidiData.get(), d->fMidiData.usize());
+    fluid_player_add_mem(d->fPlayer.get(), d->fMidiData->data(), d->fMidiData->size());
     fluid_player_play(d->fPlayer.get());
     d->fEOF = false;
     return true;
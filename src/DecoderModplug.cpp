@@ -2,8 +2,10 @@
 #include "Aulib/DecoderModplug.h"
 
 #include "Buffer.h"
+#include "RwopsView.h"
 #include "aulib.h"
 #include "missing.h"
+#include "sampleconv.h"
 #include <SDL_audio.h>
 #include <libmodplug/modplug.h>
 #include <limits>
@@ -37,6 +39,7 @@ struct DecoderModplug_priv final
     std::unique_ptr<ModPlugFile, decltype(&ModPlug_Unload)> mpHandle{nullptr, &ModPlug_Unload};
     bool atEOF = false;
     chrono::microseconds fDuration{};
+    Buffer<Sint32> tmpBuf{0};
 };
 
 } // namespace Aulib
@@ -60,15 +63,11 @@ auto Aulib::DecoderModplug::open(SDL_RWops* rwops) -> bool
         return true;
     }
     // FIXME: error reporting
-    Sint64 dataSize = SDL_RWsize(rwops);
-    if (dataSize <= 0 or dataSize > std::numeric_limits<int>::max()) {
+    const auto data = RwopsView::load(rwops);
+    if (not data or data->size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
         return false;
     }
-    Buffer<Uint8> data(dataSize);
-    if (SDL_RWread(rwops, data.get(), data.size(), 1) != 1) {
-        return false;
-    }
-    d->mpHandle.reset(ModPlug_Load(data.get(), data.size()));
+    d->mpHandle.reset(ModPlug_Load(data->data(), static_cast<int>(data->size())));
     if (not d->mpHandle) {
         return false;
     }
@@ -93,12 +92,11 @@ auto Aulib::DecoderModplug::doDecoding(float buf[], int len, bool& /*callAgain*/
     if (d->atEOF or not isOpen()) {
         return 0;
     }
-    Buffer<Sint32> tmpBuf(len);
-    int ret = ModPlug_Read(d->mpHandle.get(), tmpBuf.get(), len * 4);
-    // Convert from 32-bit to float.
-    for (int i = 0; i < len; ++i) {
-        buf[i] = tmpBuf[i] / 2147483648.f;
+    if (d->tmpBuf.size() < len) {
+        d->tmpBuf.reset(len);
     }
+    int ret = ModPlug_Read(d->mpHandle.get(), d->tmpBuf.get(), len * 4);
+    s32ToFloat(buf, d->tmpBuf.get(), ret / static_cast<int>(sizeof(Sint32)));
     if (ret == 0) {
         d->atEOF = true;
     }
@@ -1,7 +1,7 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "Aulib/DecoderOpenmpt.h"
 
-#include "Buffer.h"
+#include "RwopsView.h"
 #include "aulib.h"
 #include "aulib_log.h"
 #include "missing.h"
@@ -35,18 +35,14 @@ auto Aulib::DecoderOpenmpt::open(SDL_RWops* rwops) -> bool
         return true;
     }
     // FIXME: error reporting
-    Sint64 dataSize = SDL_RWsize(rwops);
-    if (dataSize <= 0 or dataSize > std::numeric_limits<int>::max()) {
-        return false;
-    }
-    Buffer<Uint8> data(dataSize);
-    if (SDL_RWread(rwops, data.get(), data.size(), 1) != 1) {
+    const auto data = RwopsView::load(rwops);
+    if (not data or data->size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
         return false;
     }
 
     std::unique_ptr<openmpt::module> module;
     try {
-        module = std::make_unique<openmpt::module>(data.get(), data.size());
+        module = std::make_unique<openmpt::module>(data->data(), data->size());
     }
     catch (const openmpt::exception& e) {
         aulib::log::warnLn("libopenmpt failed to load mod: {}", e.what());
@@ -62,7 +58,13 @@ auto Aulib::DecoderOpenmpt::open(SDL_RWops* rwops) -> bool
 
 auto Aulib::DecoderOpenmpt::getChannels() const -> int
 {
-    return Aulib::channelCount();
+    // libopenmpt renders mono, stereo or quad. Quad is front left, front right, back left and back
+    // right, which is also SDL's order.
+    const int channels = Aulib::channelCount();
+    if (channels >= 4) {
+        return 4;
+    }
+    return channels == 1 ? 1 : 2;
 }
 
 auto Aulib::DecoderOpenmpt::getRate() const -> int
@@ -97,12 +99,15 @@ auto Aulib::DecoderOpenmpt::doDecoding(float buf[], int len, bool& /*callAgain*/
         return 0;
     }
     int ret;
-    if (Aulib::channelCount() == 2) {
+    if (getChannels() == 4) {
+        ret = d->fModule->read_interleaved_quad(Aulib::sampleRate(), static_cast<size_t>(len / 4),
+                                                buf)
+              * 4;
+    } else if (getChannels() == 2) {
         ret = d->fModule->read_interleaved_stereo(Aulib::sampleRate(), static_cast<size_t>(len / 2),
                                                   buf)
               * 2;
     } else {
-        AM_debugAssert(Aulib::channelCount() == 1);
         ret = d->fModule->read(Aulib::sampleRate(), static_cast<size_t>(len), buf);
     }
     if (ret == 0) {
@@ -38,6 +38,8 @@ struct DecoderOpus_priv final
     OpusFileCallbacks fCbs{opusReadCb, opusSeekCb, opusTellCb, nullptr};
     bool fEOF = false;
     chrono::microseconds fDuration{};
+    // Mono files are decoded as mono. Anything else is downmixed to stereo by libopusfile.
+    int fChannels = 2;
 };
 
 } // namespace Aulib
@@ -58,10 +60,19 @@ auto Aulib::DecoderOpus::open(SDL_RWops* rwops) -> bool
     if (not d->fOpusHandle) {
         aulib::log::debugLn("ERROR: {}", error);
         if (error == OP_ENOTFORMAT) {
-            aulib::log::debugLn("OP_ENOTFORMAT");
+            aulib::log::debugLn("libopusfile stream error: OP_ENOTFORMAT");
         }
         return false;
     }
+    // Chained files can change the channel count from one link to the next, so only go with mono if
+    // all of them are mono.
+    d->fChannels = 1;
+    for (int link = 0; link < op_link_count(d->fOpusHandle.get()); ++link) {
+        if (op_channel_count(d->fOpusHandle.get(), link) != 1) {
+            d->fChannels = 2;
+            break;
+        }
+    }
     ogg_int64_t len = op_pcm_total(d->fOpusHandle.get(), -1);
     if (len == OP_EINVAL) {
         d->fDuration = chrono::microseconds::zero();
@@ -76,7 +87,7 @@ auto Aulib::DecoderOpus::open(SDL_RWops* rwops) -> bool
 
 auto Aulib::DecoderOpus::getChannels() const -> int
 {
-    return 2;
+    return d->fChannels;
 }
 
 auto Aulib::DecoderOpus::getRate() const -> int
@@ -93,29 +104,31 @@ auto Aulib::DecoderOpus::doDecoding(float buf[], int len, bool& /*callAgain*/) -
     int decSamples = 0;
 
     while (decSamples < len) {
-        int ret = op_read_float_stereo(d->fOpusHandle.get(), buf + decSamples, len - decSamples);
+        int ret = d->fChannels == 1 ? op_read_float(d->fOpusHandle.get(), buf + decSamples,
+                                                    len - decSamples, nullptr)
+                                    : op_read_float_stereo(d->fOpusHandle.get(), buf + decSamples,
+                                                           len - decSamples);
         if (ret == 0) {
             d->fEOF = true;
             break;
         }
         if (ret < 0) {
-            aulib::log::debug("libopusfile stream error: ");
             switch (ret) {
             case OP_HOLE:
-                aulib::log::debugLn("OP_HOLE");
+                aulib::log::debugLn("libopusfile stream error: OP_HOLE");
                 break;
             case OP_EBADLINK:
-                aulib::log::debugLn("OP_EBADLINK");
+                aulib::log::debugLn("libopusfile stream error: OP_EBADLINK");
                 break;
             case OP_EINVAL:
-                aulib::log::debugLn("OP_EINVAL");
+                aulib::log::debugLn("libopusfile stream error: OP_EINVAL");
                 break;
             default:
-                aulib::log::debugLn("unknown error: {}", ret);
+                aulib::log::debugLn("libopusfile stream error: unknown error {}", ret);
             }
             break;
         }
-        decSamples += ret * 2;
+        decSamples += ret * d->fChannels;
     }
     return decSamples;
 }
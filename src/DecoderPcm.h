@@ -0,0 +1,108 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "Aulib/Decoder.h"
+#include "Aulib/PcmCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+namespace Aulib {
+
+/*
+ * Plays a PcmBuffer. Since the samples are already in the output format, the mixer can also take
+ * them straight out of the buffer with take() instead of having them copied by decode().
+ */
+class DecoderPcm final: public Decoder
+{
+public:
+    explicit DecoderPcm(std::shared_ptr<const PcmBuffer> pcm)
+        : fPcm(std::move(pcm))
+    {}
+
+    auto open(SDL_RWops* /*rwops*/) -> bool override
+    {
+        setIsOpen(true);
+        return true;
+    }
+
+    auto getChannels() const -> int override
+    {
+        return fPcm->channels;
+    }
+
+    auto getRate() const -> int override
+    {
+        return fPcm->rate;
+    }
+
+    auto rewind() -> bool override
+    {
+        fPos = 0;
+        return true;
+    }
+
+    auto duration() const -> std::chrono::microseconds override
+    {
+        return std::chrono::microseconds(static_cast<Sint64>(fPcm->frames()) * 1000000
+                                         / fPcm->rate);
+    }
+
+    auto seekToTime(const std::chrono::microseconds pos) -> bool override
+    {
+        const auto frame = static_cast<Sint64>(pos.count()) * fPcm->rate / 1000000;
+        fPos = static_cast<int>(std::min<Sint64>(std::max<Sint64>(frame, 0), fPcm->frames()))
+               * fPcm->channels;
+        return true;
+    }
+
+    // Returns the next 'len' samples and moves past them. Returns null, without moving, if there
+    // are less than 'len' samples left.
+    auto take(const int len) noexcept -> const float*
+    {
+        if (static_cast<int>(fPcm->samples.size()) - fPos < len) {
+            return nullptr;
+        }
+        const float* samples = fPcm->samples.data() + fPos;
+        fPos += len;
+        return samples;
+    }
+
+protected:
+    auto doDecoding(float buf[], const int len, bool& /*callAgain*/) -> int override
+    {
+        const int count = std::min(len, static_cast<int>(fPcm->samples.size()) - fPos);
+        std::memcpy(buf, fPcm->samples.data() + fPos, count * sizeof(*buf));
+        fPos += count;
+        return count;
+    }
+
+private:
+    const std::shared_ptr<const PcmBuffer> fPcm;
+    // Position in samples.
+    int fPos = 0;
+};
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,309 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "DecoderSniffer.h"
+
+#include "Aulib/DecoderAdlmidi.h"
+#include "Aulib/DecoderBassmidi.h"
+#include "Aulib/DecoderDrflac.h"
+#include "Aulib/DecoderDrmp3.h"
+#include "Aulib/DecoderDrwav.h"
+#include "Aulib/DecoderFlac.h"
+#include "Aulib/DecoderFluidsynth.h"
+#include "Aulib/DecoderModplug.h"
+#include "Aulib/DecoderMpg123.h"
+#include "Aulib/DecoderMusepack.h"
+#include "Aulib/DecoderOpenmpt.h"
+#include "Aulib/DecoderOpus.h"
+#include "Aulib/DecoderSndfile.h"
+#include "Aulib/DecoderVorbis.h"
+#include "Aulib/DecoderWildmidi.h"
+#include "Aulib/DecoderXmp.h"
+#include "aulib_config.h"
+#include <SDL_rwops.h>
+#include <SDL_stdinc.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+auto hasTag(const Uint8* head, std::size_t len, std::size_t offset, const char* tag) -> bool
+{
+    const auto tagLen = std::strlen(tag);
+    return len >= offset + tagLen and std::memcmp(head + offset, tag, tagLen) == 0;
+}
+
+auto isDigit(Uint8 c) -> bool
+{
+    return c >= '0' and c <= '9';
+}
+
+auto isRiff(const Uint8* head, std::size_t len, const char* form) -> bool
+{
+    return hasTag(head, len, 0, "RIFF") and hasTag(head, len, 8, form);
+}
+
+auto isOgg(const Uint8* head, std::size_t len, const char* codec) -> bool
+{
+    // The codec's identification header is the first packet of the first page. It starts right
+    // after the page header, which is 28 bytes long when the packet fits in a single segment.
+    return hasTag(head, len, 0, "OggS") and hasTag(head, len, 28, codec);
+}
+
+[[maybe_unused]] auto isWav(const Uint8* head, std::size_t len) -> bool
+{
+    // RIFF, RF64 and Sony Wave64, whose header starts with the GUID of its "riff" chunk.
+    return isRiff(head, len, "WAVE") or hasTag(head, len, 0, "RF64")
+           or (hasTag(head, len, 0, "riff") and hasTag(head, len, 4, "\x2E\x91\xCF\x11"));
+}
+
+[[maybe_unused]] auto isFlac(const Uint8* head, std::size_t len) -> bool
+{
+    return hasTag(head, len, 0, "fLaC") or isOgg(head, len, "\x7F" "FLAC");
+}
+
+[[maybe_unused]] auto isVorbis(const Uint8* head, std::size_t len) -> bool
+{
+    return isOgg(head, len, "\x01vorbis");
+}
+
+[[maybe_unused]] auto isOpus(const Uint8* head, std::size_t len) -> bool
+{
+    return isOgg(head, len, "OpusHead");
+}
+
+[[maybe_unused]] auto isMusepack(const Uint8* head, std::size_t len) -> bool
+{
+    return hasTag(head, len, 0, "MPCK") or hasTag(head, len, 0, "MP+");
+}
+
+[[maybe_unused]] auto isMidi(const Uint8* head, std::size_t len) -> bool
+{
+    return hasTag(head, len, 0, "MThd") or isRiff(head, len, "RMID");
+}
+
+[[maybe_unused]] auto isSndfile(const Uint8* head, std::size_t len) -> bool
+{
+    // The formats libsndfile is most commonly used for. Anything more exotic needs the extension.
+    return isWav(head, len) or isFlac(head, len) or isVorbis(head, len) or isOpus(head, len)
+           or (hasTag(head, len, 0, "FORM")
+               and (hasTag(head, len, 8, "AIFF") or hasTag(head, len, 8, "AIFC")))
+           or hasTag(head, len, 0, ".snd") or hasTag(head, len, 0, "caff")
+           or hasTag(head, len, 0, "wvpk");
+}
+
+[[maybe_unused]] auto isModule(const Uint8* head, std::size_t len) -> bool
+{
+    if (hasTag(head, len, 0, "Extended Module: ") or hasTag(head, len, 0, "IMPM")
+        or hasTag(head, len, 44, "SCRM") or hasTag(head, len, 0, "MTM")
+        or hasTag(head, len, 0, "OKTASONG") or hasTag(head, len, 0, "MAS_UTrack_V00")
+        or hasTag(head, len, 0, "DMDL") or hasTag(head, len, 0, "DBM0")
+        or hasTag(head, len, 0, "FAR\xFE") or hasTag(head, len, 0, "PSM ")
+        or hasTag(head, len, 0, "MO3") or hasTag(head, len, 0, "MMD"))
+    {
+        return true;
+    }
+
+    // Protracker and its descendants put a four character tag after the sample and pattern order
+    // tables.
+    constexpr std::size_t MOD_TAG_OFFSET = 1080;
+    if (len < MOD_TAG_OFFSET + 4) {
+        return false;
+    }
+    const Uint8* tag = head + MOD_TAG_OFFSET;
+    constexpr std::array<const char*, 14> MOD_TAGS{"M.K.", "M!K!", "M&K!", "N.T.", "FLT4",
+                                                   "FLT8", "EXO4", "EXO8", "CD81", "CD61",
+                                                   "OKTA", "OCTA", "FEST", "NSMS"};
+    if (std::any_of(MOD_TAGS.begin(), MOD_TAGS.end(),
+                    [tag](const char* t) { return std::memcmp(tag, t, 4) == 0; }))
+    {
+        return true;
+    }
+    // "6CHN", "8CHN", "16CH", "32CN" and so on.
+    return (isDigit(tag[0]) and std::memcmp(tag + 1, "CHN", 3) == 0)
+           or (isDigit(tag[0]) and isDigit(tag[1])
+               and (std::memcmp(tag + 2, "CH", 2) == 0 or std::memcmp(tag + 2, "CN", 2) == 0));
+}
+
+[[maybe_unused]] auto isMp3(const Uint8* head, std::size_t len) -> bool
+{
+    if (hasTag(head, len, 0, "ID3")) {
+        return true;
+    }
+    // Frame header: 11 sync bits, a valid MPEG version and layer, and a bitrate and sample rate
+    // index that aren't reserved.
+    return len >= 4 and head[0] == 0xFF and (head[1] & 0xE0) == 0xE0 and (head[1] & 0x18) != 0x08
+           and (head[1] & 0x06) != 0 and (head[2] & 0xF0) != 0xF0 and (head[2] & 0x0C) != 0x0C;
+}
+
+template <class Dec>
+auto create() -> std::unique_ptr<Aulib::Decoder>
+{
+    return std::make_unique<Dec>();
+}
+
+constexpr const char* MIDI_EXTENSIONS = "mid midi rmi smf kar";
+constexpr const char* MODULE_EXTENSIONS =
+    "mod s3m xm it mptm mtm 669 med okt ult mdl dbm far psm mo3 stm stx ptm dsm amf umx j2b dmf "
+    "gdm imf mt2 nst wow";
+constexpr const char* MP3_EXTENSIONS = "mp3 mp2 mp1 mpga";
+
+// In the order decoders should be tried. Like before the sniffers existed, the MP3 decoders come
+// last, since a stray frame sync is more likely than a stray magic number of the other formats.
+// MIDI decoders were only ever tried on files with a MIDI header, so they're not tried on data
+// that wasn't recognized.
+const Aulib::DecoderSniffer SNIFFERS[] = {
+#if USE_DEC_DRFLAC
+    {"dr_flac", "flac oga", isFlac, create<Aulib::DecoderDrflac>, true},
+#endif
+#if USE_DEC_FLAC
+    {"libFLAC", "flac", isFlac, create<Aulib::DecoderFlac>, true},
+#endif
+#if USE_DEC_LIBVORBIS
+    {"libvorbis", "ogg oga", isVorbis, create<Aulib::DecoderVorbis>, true},
+#endif
+#if USE_DEC_LIBOPUSFILE
+    {"opusfile", "opus", isOpus, create<Aulib::DecoderOpus>, true},
+#endif
+#if USE_DEC_MUSEPACK
+    {"musepack", "mpc mp+ mpp", isMusepack, create<Aulib::DecoderMusepack>, true},
+#endif
+#if USE_DEC_FLUIDSYNTH
+    {"FluidSynth", MIDI_EXTENSIONS, isMidi, create<Aulib::DecoderFluidsynth>, false},
+#endif
+#if USE_DEC_BASSMIDI
+    {"BASSMIDI", MIDI_EXTENSIONS, isMidi, create<Aulib::DecoderBassmidi>, false},
+#endif
+#if USE_DEC_WILDMIDI
+    {"WildMIDI", MIDI_EXTENSIONS, isMidi, create<Aulib::DecoderWildmidi>, false},
+#endif
+#if USE_DEC_ADLMIDI
+    {"ADLMIDI", MIDI_EXTENSIONS, isMidi, create<Aulib::DecoderAdlmidi>, false},
+#endif
+#if USE_DEC_SNDFILE
+    {"libsndfile", "wav w64 rf64 aif aiff aifc au snd caf wv flac ogg oga opus voc paf svx sph",
+     isSndfile, create<Aulib::DecoderSndfile>, true},
+#endif
+#if USE_DEC_DRWAV
+    {"dr_wav", "wav w64 rf64", isWav, create<Aulib::DecoderDrwav>, true},
+#endif
+#if USE_DEC_OPENMPT
+    {"libopenmpt", MODULE_EXTENSIONS, isModule, create<Aulib::DecoderOpenmpt>, true},
+#endif
+#if USE_DEC_XMP
+    {"libxmp", MODULE_EXTENSIONS, isModule, create<Aulib::DecoderXmp>, true},
+#endif
+#if USE_DEC_MODPLUG
+    // ModPlug accepts just about anything as a module, so it can only be used for files that were
+    // recognized as one.
+    {"ModPlug", MODULE_EXTENSIONS, isModule, create<Aulib::DecoderModplug>, false},
+#endif
+#if USE_DEC_MPG123
+    {"mpg123", MP3_EXTENSIONS, isMp3, create<Aulib::DecoderMpg123>, true},
+#endif
+#if USE_DEC_DRMP3
+    {"dr_mp3", MP3_EXTENSIONS, isMp3, create<Aulib::DecoderDrmp3>, true},
+#endif
+    // Keeps the array from being empty when no decoder is enabled.
+    {nullptr, "", nullptr, nullptr, false},
+};
+
+// Returns the lower case extension of a file name, or the hint itself if it has no dot.
+auto extensionOf(const std::string& nameHint) -> std::string
+{
+    const auto dot = nameHint.find_last_of('.');
+    const auto slash = nameHint.find_last_of("/\\");
+    std::string ext;
+    if (dot == std::string::npos) {
+        ext = nameHint;
+    } else if (slash == std::string::npos or slash < dot) {
+        ext = nameHint.substr(dot + 1);
+    }
+    for (auto& c : ext) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return ext;
+}
+
+auto hasExtension(const char* extensions, const std::string& ext) -> bool
+{
+    if (ext.empty()) {
+        return false;
+    }
+    for (const char* p = extensions; (p = std::strstr(p, ext.c_str())) != nullptr;
+         p += ext.size())
+    {
+        const bool startsWord = p == extensions or p[-1] == ' ';
+        const bool endsWord = p[ext.size()] == ' ' or p[ext.size()] == '\0';
+        if (startsWord and endsWord) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+auto Aulib::sniffDecoders(SDL_RWops* const rwops, const std::string& nameHint)
+    -> std::vector<const DecoderSniffer*>
+{
+    std::vector<const DecoderSniffer*> found;
+    if (not rwops) {
+        return found;
+    }
+
+    std::array<Uint8, DecoderSniffer::PEEK_SIZE> head;
+    const auto pos = SDL_RWtell(rwops);
+    const std::size_t len = SDL_RWread(rwops, head.data(), 1, head.size());
+    SDL_RWseek(rwops, pos, RW_SEEK_SET);
+
+    for (const auto& sniffer : SNIFFERS) {
+        if (sniffer.matches and sniffer.matches(head.data(), len)) {
+            found.push_back(&sniffer);
+        }
+    }
+    const auto ext = extensionOf(nameHint);
+    for (const auto& sniffer : SNIFFERS) {
+        if (sniffer.matches and hasExtension(sniffer.extensions, ext)
+            and std::find(found.begin(), found.end(), &sniffer) == found.end())
+        {
+            found.push_back(&sniffer);
+        }
+    }
+    return found;
+}
+
+auto Aulib::fallbackDecoders(const std::vector<const DecoderSniffer*>& sniffed)
+    -> std::vector<const DecoderSniffer*>
+{
+    std::vector<const DecoderSniffer*> found;
+    for (const auto& sniffer : SNIFFERS) {
+        if (sniffer.tryUnrecognized
+            and std::find(sniffed.begin(), sniffed.end(), &sniffer) == sniffed.end())
+        {
+            found.push_back(&sniffer);
+        }
+    }
+    return found;
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,74 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_global.h"
+#include <SDL_stdinc.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SDL_RWops;
+
+namespace Aulib {
+
+class Decoder;
+
+/*
+ * Identifies the format of a file from its first bytes, so that Decoder::decoderFor() only needs to
+ * open the decoder that is going to be used instead of trying every one of them.
+ *
+ * There's one sniffer per decoder type that is compiled in. Sniffers only look at magic numbers and
+ * header fields, so they are cheap but can't tell whether a decoder will actually accept a file.
+ */
+struct DecoderSniffer final
+{
+    // Amount of bytes that are read from the start of the file. Large enough to reach the signature
+    // of Protracker modules, which is at offset 1080.
+    static constexpr std::size_t PEEK_SIZE = 2048;
+
+    const char* name;
+    // Space separated, lower case file name extensions. Used for formats that don't always have a
+    // magic number.
+    const char* extensions;
+    auto (*matches)(const Uint8* head, std::size_t len) -> bool;
+    auto (*create)() -> std::unique_ptr<Decoder>;
+    // Whether the decoder is also tried on data that no sniffer recognized, like every decoder
+    // was before the sniffers existed. Not the case for decoders that accept almost anything.
+    bool tryUnrecognized;
+};
+
+// Returns the sniffers that recognize the data at the current position of 'rwops', most suitable
+// first. Sniffers that recognize the content come before those that only recognize the extension
+// of 'nameHint', which can be a file name or just an extension. The position of 'rwops' is
+// restored.
+AULIB_NO_EXPORT auto sniffDecoders(SDL_RWops* rwops, const std::string& nameHint)
+    -> std::vector<const DecoderSniffer*>;
+
+// Returns the sniffers of the decoders that should be tried when none of 'sniffed' could open the
+// data, in the order they should be tried.
+AULIB_NO_EXPORT auto fallbackDecoders(const std::vector<const DecoderSniffer*>& sniffed)
+    -> std::vector<const DecoderSniffer*>;
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
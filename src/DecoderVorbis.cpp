@@ -1,8 +1,14 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "Aulib/DecoderVorbis.h"
 
+#include "Buffer.h"
 #include "aulib_log.h"
+#include "chanlayout.h"
+#include "sampleconv.h"
 #include <SDL_rwops.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <vorbis/vorbisfile.h>
 
 namespace chrono = std::chrono;
@@ -38,10 +44,74 @@ struct DecoderVorbis_priv final
     vorbis_info* fCurrentInfo = nullptr;
     bool fEOF = false;
     chrono::microseconds fDuration{};
+    // Channels in SDL's order, for interleaving. Channels that Vorbis doesn't have point to
+    // fSilence, which is never written to.
+    std::array<const float*, MAX_CHANNELS> fPlanes{};
+    Buffer<float> fSilence{0};
 };
 
 } // namespace Aulib
 
+/* Reads up to 'frames' frames of float samples. Sets 'callAgain' when a new logical stream
+ * begins. Returns the amount of frames read, 0 on EOF, or a negative value on error.
+ */
+static auto readFloat(Aulib::DecoderVorbis_priv& d, float*** out, int frames, bool& callAgain)
+    -> long
+{
+    int lastSection = d.fCurrentSection;
+    auto ret = ov_read_float(d.fVFHandle.get(), out, frames, &d.fCurrentSection);
+    if (ret == 0) {
+        d.fEOF = true;
+        return 0;
+    }
+    if (ret < 0) {
+        switch (ret) {
+        case OV_HOLE:
+            aulib::log::debugLn("libvorbis stream error: OV_HOLE");
+            break;
+        case OV_EBADLINK:
+            aulib::log::debugLn("libvorbis stream error: OV_EBADLINK");
+            break;
+        case OV_EINVAL:
+            aulib::log::debugLn("libvorbis stream error: OV_EINVAL");
+            break;
+        default:
+            aulib::log::debugLn("libvorbis stream error: unknown error {}", ret);
+        }
+        return ret;
+    }
+    if (d.fCurrentSection != lastSection) {
+        d.fCurrentInfo = ov_info(d.fVFHandle.get(), -1);
+        callAgain = true;
+    }
+    return ret;
+}
+
+// Returns the planes of 'frames' frames of libvorbis output in SDL's channel order.
+static auto sdlPlanes(Aulib::DecoderVorbis_priv& d, float** out, const Aulib::ChannelMap& map,
+                      const int frames) -> const float* const*
+{
+    if (map.outChannels == d.fCurrentInfo->channels) {
+        bool reordered = false;
+        for (int chan = 0; chan < map.outChannels; ++chan) {
+            reordered = reordered or map.target[chan] != chan;
+        }
+        if (not reordered) {
+            return out;
+        }
+    }
+    if (d.fSilence.size() < frames) {
+        d.fSilence.reset(frames);
+    }
+    d.fPlanes.fill(d.fSilence.get());
+    for (int chan = 0; chan < std::min(d.fCurrentInfo->channels, Aulib::MAX_CHANNELS); ++chan) {
+        if (map.target[chan] >= 0) {
+            d.fPlanes[map.target[chan]] = out[chan];
+        }
+    }
+    return d.fPlanes.data();
+}
+
 Aulib::DecoderVorbis::DecoderVorbis()
     : d(std::make_unique<DecoderVorbis_priv>())
 {}
@@ -76,7 +146,7 @@ auto Aulib::DecoderVorbis::open(SDL_RWops* rwops) -> bool
 
 auto Aulib::DecoderVorbis::getChannels() const -> int
 {
-    return d->fCurrentInfo ? d->fCurrentInfo->channels : 0;
+    return d->fCurrentInfo ? vorbisChannelMap(d->fCurrentInfo->channels).outChannels : 0;
 }
 
 auto Aulib::DecoderVorbis::getRate() const -> int
@@ -94,45 +164,58 @@ auto Aulib::DecoderVorbis::doDecoding(float buf[], int len, bool& callAgain) ->
     int decSamples = 0;
 
     while (decSamples < len and not callAgain) {
-        int lastSection = d->fCurrentSection;
-        // TODO: We only support up to 2 channels for now.
-        auto channels = std::min(d->fCurrentInfo->channels, 2);
-        auto ret = ov_read_float(d->fVFHandle.get(), &out, (len - decSamples) / channels,
-                                 &d->fCurrentSection);
-        if (ret == 0) {
-            d->fEOF = true;
+        auto ret = readFloat(*d, &out, (len - decSamples) / getChannels(), callAgain);
+        if (ret <= 0) {
             break;
         }
-        if (ret < 0) {
-            aulib::log::debug("libvorbis stream error: ");
-            switch (ret) {
-            case OV_HOLE:
-                aulib::log::debugLn("OV_HOLE");
-                break;
-            case OV_EBADLINK:
-                aulib::log::debugLn("OV_EBADLINK");
-                break;
-            case OV_EINVAL:
-                aulib::log::debugLn("OV_EINVAL");
-                break;
-            default:
-                aulib::log::debugLn("unknown error: {}", ret);
-            }
+        // A new logical stream can have a different amount of channels. Whatever doesn't fit
+        // anymore is dropped.
+        const auto map = vorbisChannelMap(d->fCurrentInfo->channels);
+        const int frames =
+            static_cast<int>(std::min<long>(ret, (len - decSamples) / map.outChannels));
+        // Copy samples to output buffer in interleaved format.
+        interleave(buf, sdlPlanes(*d, out, map, frames), map.outChannels, frames);
+        buf += frames * map.outChannels;
+        decSamples += frames * map.outChannels;
+    }
+    return decSamples;
+}
+
+auto Aulib::DecoderVorbis::supportsPlanar() const -> bool
+{
+    return true;
+}
+
+auto Aulib::DecoderVorbis::doDecodingPlanar(float* const bufs[], int frames, bool& callAgain)
+    -> int
+{
+    if (d->fEOF or not isOpen()) {
+        return 0;
+    }
+
+    float** out;
+    int decFrames = 0;
+
+    while (decFrames < frames and not callAgain) {
+        const int channels = getChannels();
+        auto ret = readFloat(*d, &out, frames - decFrames, callAgain);
+        if (ret <= 0) {
             break;
         }
-        if (d->fCurrentSection != lastSection) {
-            d->fCurrentInfo = ov_info(d->fVFHandle.get(), -1);
-            callAgain = true;
+        // libvorbis already keeps channels apart, so they only need to be put in SDL's order. If a
+        // new logical stream has a different amount of channels, only the ones we have room for
+        // are kept, and the ones it lacks are silent.
+        const auto map = vorbisChannelMap(d->fCurrentInfo->channels);
+        const auto* planes = sdlPlanes(*d, out, map, static_cast<int>(ret));
+        for (int chan = 0; chan < std::min(map.outChannels, channels); ++chan) {
+            memcpy(bufs[chan] + decFrames, planes[chan], static_cast<size_t>(ret) * sizeof(float));
         }
-        // Copy samples to output buffer in interleaved format.
-        for (long samp = 0; samp < ret; ++samp) {
-            for (int chan = 0; chan < channels; ++chan) {
-                *buf++ = out[chan][samp];
-            }
+        for (int chan = map.outChannels; chan < channels; ++chan) {
+            std::fill_n(bufs[chan] + decFrames, ret, 0.f);
         }
-        decSamples += ret * channels;
+        decFrames += ret;
     }
-    return decSamples;
+    return decFrames;
 }
 
 auto Aulib::DecoderVorbis::rewind() -> bool
@@ -2,7 +2,9 @@
 #include "Aulib/DecoderWildmidi.h"
 
 #include "Buffer.h"
+#include "RwopsView.h"
 #include "missing.h"
+#include "sampleconv.h"
 #include <SDL_rwops.h>
 #include <algorithm>
 #include <wildmidi_lib.h>
@@ -13,8 +15,9 @@ namespace Aulib {
 
 struct DecoderWildmidi_priv final
 {
+    // Declared before the handle, so that it outlives it.
+    std::unique_ptr<RwopsView> midiData;
     std::unique_ptr<midi, decltype(&WildMidi_Close)> midiHandle{nullptr, &WildMidi_Close};
-    Buffer<unsigned char> midiData{0};
     Buffer<Sint16> sampBuf{0};
     bool eof = false;
 
@@ -70,20 +73,17 @@ auto Aulib::DecoderWildmidi::open(SDL_RWops* rwops) -> bool
     }
 
     // FIXME: error reporting
-    Sint64 newMidiDataLen = SDL_RWsize(rwops);
-    if (newMidiDataLen <= 0) {
+    auto newMidiData = RwopsView::load(rwops);
+    if (not newMidiData) {
         return false;
     }
-
-    Buffer<unsigned char> newMidiData(newMidiDataLen);
-    if (SDL_RWread(rwops, newMidiData.get(), newMidiData.size(), 1) != 1) {
-        return false;
-    }
-    d->midiHandle.reset(WildMidi_OpenBuffer(newMidiData.get(), newMidiData.usize()));
+    // Older WildMidi versions take a non-const pointer, but never write through it.
+    d->midiHandle.reset(WildMidi_OpenBuffer(const_cast<unsigned char*>(newMidiData->data()),
+                                            newMidiData->size()));
     if (not d->midiHandle) {
         return false;
     }
-    d->midiData.swap(newMidiData);
+    d->midiData = std::move(newMidiData);
     setIsOpen(true);
     return true;
 }
@@ -104,7 +104,7 @@ auto Aulib::DecoderWildmidi::doDecoding(float buf[], int len, bool& /*callAgain*
         return 0;
     }
 
-    if (d->sampBuf.size() != len) {
+    if (d->sampBuf.size() < len) {
         d->sampBuf.reset(len);
     }
 #ifdef LIBWILDMIDI_VERSION
@@ -118,10 +118,7 @@ auto Aulib::DecoderWildmidi::doDecoding(float buf[], int len, bool& /*callAgain*
     if (res < 0) {
         return 0;
     }
-    // Convert from 16-bit to float.
-    for (int i = 0; i < res / 2; ++i) {
-        buf[i] = d->sampBuf[i] / 32768.f;
-    }
+    s16ToFloat(buf, d->sampBuf.get(), res / 2);
     if (res < len) {
         d->eof = true;
     }
@@ -2,8 +2,10 @@
 #include "Aulib/DecoderXmp.h"
 
 #include "Buffer.h"
+#include "RwopsView.h"
 #include "aulib.h"
 #include "missing.h"
+#include "sampleconv.h"
 #include <SDL_rwops.h>
 #include <limits>
 #include <type_traits>
@@ -19,6 +21,7 @@ struct DecoderXmp_priv final
         nullptr, xmp_free_context};
     int fRate = 0;
     bool fEof = false;
+    Buffer<Sint16> fTmpBuf{0};
 };
 
 } // namespace Aulib
@@ -41,15 +44,15 @@ auto Aulib::DecoderXmp::open(SDL_RWops* rwops) -> bool
         return false;
     }
 
-    Sint64 dataSize = SDL_RWsize(rwops);
-    if (dataSize <= 0 or dataSize > std::numeric_limits<int>::max()) {
+    const auto data = RwopsView::load(rwops);
+    if (not data or data->size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
         return false;
     }
-    Buffer<Uint8> data(dataSize);
-    if (SDL_RWread(rwops, data.get(), data.size(), 1) != 1) {
-        return false;
-    }
-    if (xmp_load_module_from_memory(d->fContext.get(), data.get(), data.size()) != 0) {
+    // Older libxmp versions take a non-const pointer, but never write through it.
+    if (xmp_load_module_from_memory(d->fContext.get(), const_cast<Uint8*>(data->data()),
+                                    static_cast<long>(data->size()))
+        != 0)
+    {
         return false;
     }
     // libXMP supports 8-48kHz.
@@ -102,12 +105,11 @@ auto Aulib::DecoderXmp::doDecoding(float buf[], int len, bool& /*callAgain*/) ->
     if (d->fEof or not isOpen()) {
         return 0;
     }
-    Buffer<Sint16> tmpBuf(len);
-    auto ret = xmp_play_buffer(d->fContext.get(), tmpBuf.get(), len * 2, 1);
-    // Convert from 16-bit to float.
-    for (int i = 0; i < len; ++i) {
-        buf[i] = tmpBuf[i] / 32768.f;
+    if (d->fTmpBuf.size() < len) {
+        d->fTmpBuf.reset(len);
     }
+    auto ret = xmp_play_buffer(d->fContext.get(), d->fTmpBuf.get(), len * 2, 1);
+    s16ToFloat(buf, d->fTmpBuf.get(), len);
     if (ret == -XMP_END) {
         d->fEof = true;
     }
@@ -0,0 +1,477 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "Aulib/FileSink.h"
+
+#include "Buffer.h"
+#include "aulib.h"
+#include "aulib_config.h"
+#include "chanlayout.h"
+#include "missing/algorithm.h"
+#include "sampleconv.h"
+#include <SDL_endian.h>
+#include <SDL_error.h>
+#include <SDL_rwops.h>
+#include <algorithm>
+#include <cmath>
+#if USE_DEC_FLAC
+#    include <FLAC/stream_encoder.h>
+#endif
+
+namespace chrono = std::chrono;
+
+namespace Aulib {
+
+struct FileSink_priv final
+{
+    explicit FileSink_priv(const FileSink::FileFormat format)
+        : fFormat(format)
+    {}
+
+    const FileSink::FileFormat fFormat;
+    SDL_RWops* fRwops = nullptr;
+    bool fCloseRw = false;
+    int fChannels = 0;
+    int fRate = 0;
+    Uint64 fFrames = 0;
+    // Where the WAV header starts, or -1 if the output isn't seekable.
+    Sint64 fHeaderPos = -1;
+    Uint64 fDataBytes = 0;
+    SampleConverter fConverter = nullptr;
+    Buffer<Uint8> fConvBuf{0};
+    Buffer<float> fRenderBuf{0};
+#if USE_DEC_FLAC
+    std::unique_ptr<FLAC__StreamEncoder, decltype(&FLAC__stream_encoder_delete)> fFlac{
+        nullptr, FLAC__stream_encoder_delete};
+    Buffer<FLAC__int32> fFlacBuf{0};
+#endif
+
+    auto fIsFloat() const -> bool
+    {
+        return fFormat == FileSink::FileFormat::WavFloat;
+    }
+
+    auto fBytesPerSample() const -> int
+    {
+        return fIsFloat() ? 4 : 2;
+    }
+
+    // Plain PCM format chunks can't describe more than two channels or more than 16 bits per
+    // sample, so these use WAVE_FORMAT_EXTENSIBLE.
+    auto fIsExtensible() const -> bool
+    {
+        return fChannels > 2 or fBytesPerSample() > 2;
+    }
+
+    auto fWavHeaderSize() const -> int
+    {
+        // Extensible WAV files have a 40 byte fmt chunk instead of 16. Float files also need a fact
+        // chunk.
+        return (fIsExtensible() ? 68 : 44) + (fIsFloat() ? 12 : 0);
+    }
+
+    auto fChannelMask() const -> Uint32;
+
+    auto fWriteWavHeader(Uint32 frames, Uint32 dataBytes) -> bool;
+    auto fWriteWav(const float buf[], int frames) -> bool;
+    auto fFinishWav() -> bool;
+    auto fOpenFlac() -> bool;
+    auto fWriteFlac(const float buf[], int frames) -> bool;
+    auto fFinishFlac() -> bool;
+};
+
+} // namespace Aulib
+
+#if USE_DEC_FLAC
+extern "C" {
+
+static auto flacEncWriteCb(const FLAC__StreamEncoder* /*encoder*/, const FLAC__byte buffer[],
+                           size_t bytes, unsigned /*samples*/, unsigned /*current_frame*/,
+                           void* client_data) -> FLAC__StreamEncoderWriteStatus
+{
+    if (SDL_RWwrite(static_cast<SDL_RWops*>(client_data), buffer, 1, bytes) != bytes) {
+        return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+    }
+    return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+static auto flacEncSeekCb(const FLAC__StreamEncoder* /*encoder*/,
+                          FLAC__uint64 absolute_byte_offset, void* client_data)
+    -> FLAC__StreamEncoderSeekStatus
+{
+    if (SDL_RWseek(static_cast<SDL_RWops*>(client_data), absolute_byte_offset, RW_SEEK_SET) < 0) {
+        return FLAC__STREAM_ENCODER_SEEK_STATUS_UNSUPPORTED;
+    }
+    return FLAC__STREAM_ENCODER_SEEK_STATUS_OK;
+}
+
+static auto flacEncTellCb(const FLAC__StreamEncoder* /*encoder*/,
+                          FLAC__uint64* absolute_byte_offset, void* client_data)
+    -> FLAC__StreamEncoderTellStatus
+{
+    const auto pos = SDL_RWtell(static_cast<SDL_RWops*>(client_data));
+    if (pos < 0) {
+        return FLAC__STREAM_ENCODER_TELL_STATUS_UNSUPPORTED;
+    }
+    *absolute_byte_offset = static_cast<FLAC__uint64>(pos);
+    return FLAC__STREAM_ENCODER_TELL_STATUS_OK;
+}
+
+} // extern "C"
+#endif
+
+auto Aulib::FileSink_priv::fChannelMask() const -> Uint32
+{
+    // WAV files with a channel mask store channels in the order of these bits, which is the same
+    // order SPEAKER_LAYOUTS uses.
+    constexpr Uint32 FRONT_LEFT = 0x1;
+    constexpr Uint32 FRONT_RIGHT = 0x2;
+    constexpr Uint32 FRONT_CENTER = 0x4;
+    constexpr Uint32 LFE = 0x8;
+    constexpr Uint32 BACK_LEFT = 0x10;
+    constexpr Uint32 BACK_RIGHT = 0x20;
+    constexpr Uint32 BACK_CENTER = 0x100;
+    constexpr Uint32 SIDE_LEFT = 0x200;
+    constexpr Uint32 SIDE_RIGHT = 0x400;
+
+    // Mono files are conventionally marked as front center.
+    if (fChannels == 1) {
+        return FRONT_CENTER;
+    }
+    if (fChannels > MAX_CHANNELS) {
+        return 0;
+    }
+    Uint32 mask = 0;
+    for (int i = 0; i < fChannels; ++i) {
+        switch (SPEAKER_LAYOUTS[fChannels - 1][i]) {
+        case Speaker::FrontLeft:
+            mask |= FRONT_LEFT;
+            break;
+        case Speaker::FrontRight:
+            mask |= FRONT_RIGHT;
+            break;
+        case Speaker::FrontCenter:
+            mask |= FRONT_CENTER;
+            break;
+        case Speaker::Lfe:
+            mask |= LFE;
+            break;
+        case Speaker::BackLeft:
+            mask |= BACK_LEFT;
+            break;
+        case Speaker::BackRight:
+            mask |= BACK_RIGHT;
+            break;
+        case Speaker::SideLeft:
+            mask |= SIDE_LEFT;
+            break;
+        case Speaker::SideRight:
+            mask |= SIDE_RIGHT;
+            break;
+        case Speaker::BackCenter:
+            mask |= BACK_CENTER;
+            break;
+        }
+    }
+    return mask;
+}
+
+auto Aulib::FileSink_priv::fWriteWavHeader(const Uint32 frames, const Uint32 dataBytes) -> bool
+{
+    constexpr Uint16 FORMAT_PCM = 1;
+    constexpr Uint16 FORMAT_FLOAT = 3;
+    constexpr Uint16 FORMAT_EXTENSIBLE = 0xFFFE;
+
+    const Uint16 subFormat = fIsFloat() ? FORMAT_FLOAT : FORMAT_PCM;
+    const Uint16 formatTag = fIsExtensible() ? FORMAT_EXTENSIBLE : subFormat;
+    const auto bitsPerSample = static_cast<Uint16>(fBytesPerSample() * 8);
+    const auto blockAlign = static_cast<Uint16>(fChannels * fBytesPerSample());
+    // Saturate rather than wrap, so the placeholder header written on open says "as large as
+    // possible" instead of describing a tiny file.
+    const auto headerRest = static_cast<Uint32>(fWavHeaderSize() - 8);
+    const Uint32 riffSize =
+        dataBytes > 0xFFFFFFFFu - headerRest ? 0xFFFFFFFFu : headerRest + dataBytes;
+    bool ok = true;
+
+    auto writeTag = [&](const char* tag) { ok = ok and SDL_RWwrite(fRwops, tag, 4, 1) == 1; };
+    auto write16 = [&](const Uint16 value) { ok = ok and SDL_WriteLE16(fRwops, value) == 1; };
+    auto write32 = [&](const Uint32 value) { ok = ok and SDL_WriteLE32(fRwops, value) == 1; };
+
+    writeTag("RIFF");
+    write32(riffSize);
+    writeTag("WAVE");
+    writeTag("fmt ");
+    write32(fIsExtensible() ? 40 : 16);
+    write16(formatTag);
+    write16(static_cast<Uint16>(fChannels));
+    write32(static_cast<Uint32>(fRate));
+    write32(static_cast<Uint32>(fRate) * blockAlign);
+    write16(blockAlign);
+    write16(bitsPerSample);
+    if (fIsExtensible()) {
+        write16(22);
+        write16(bitsPerSample);
+        write32(fChannelMask());
+        // The sub-format GUID is xxxxxxxx-0000-0010-8000-00AA00389B71, with the plain format tag in
+        // place of the x's.
+        static constexpr Uint8 guidSuffix[14]{0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80,
+                                              0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+        write16(subFormat);
+        ok = ok and SDL_RWwrite(fRwops, guidSuffix, sizeof(guidSuffix), 1) == 1;
+    }
+    if (fIsFloat()) {
+        writeTag("fact");
+        write32(4);
+        write32(frames);
+    }
+    writeTag("data");
+    write32(dataBytes);
+    return ok;
+}
+
+auto Aulib::FileSink_priv::fWriteWav(const float buf[], const int frames) -> bool
+{
+    const int samples = frames * fChannels;
+    const int bytes = samples * fBytesPerSample();
+
+    // The WAV header can't describe more than 4GB.
+    if (fDataBytes + bytes > 0xFFFFFFFFu - fWavHeaderSize()) {
+        SDL_SetError("WAV file size limit reached.");
+        return false;
+    }
+    if (fConvBuf.size() < bytes) {
+        fConvBuf.reset(bytes);
+    }
+    fConverter(fConvBuf.get(), buf, samples);
+    if (SDL_RWwrite(fRwops, fConvBuf.get(), bytes, 1) != 1) {
+        return false;
+    }
+    fDataBytes += bytes;
+    return true;
+}
+
+auto Aulib::FileSink_priv::fFinishWav() -> bool
+{
+    if (fHeaderPos < 0) {
+        return true;
+    }
+    const auto endPos = SDL_RWtell(fRwops);
+    if (SDL_RWseek(fRwops, fHeaderPos, RW_SEEK_SET) < 0) {
+        return false;
+    }
+    const bool ok = fWriteWavHeader(static_cast<Uint32>(fFrames), static_cast<Uint32>(fDataBytes));
+    SDL_RWseek(fRwops, endPos, RW_SEEK_SET);
+    return ok;
+}
+
+auto Aulib::FileSink_priv::fOpenFlac() -> bool
+{
+#if USE_DEC_FLAC
+    fFlac.reset(FLAC__stream_encoder_new());
+    if (not fFlac) {
+        SDL_SetError("Failed to create FLAC encoder.");
+        return false;
+    }
+    FLAC__stream_encoder_set_channels(fFlac.get(), fChannels);
+    FLAC__stream_encoder_set_bits_per_sample(fFlac.get(), 24);
+    FLAC__stream_encoder_set_sample_rate(fFlac.get(), fRate);
+    FLAC__stream_encoder_set_compression_level(fFlac.get(), 5);
+    const auto status = FLAC__stream_encoder_init_stream(
+        fFlac.get(), flacEncWriteCb, flacEncSeekCb, flacEncTellCb, nullptr, fRwops);
+    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+        SDL_SetError("Failed to initialize FLAC encoder: %s",
+                     FLAC__StreamEncoderInitStatusString[status]);
+        fFlac.reset();
+        return false;
+    }
+    return true;
+#else
+    SDL_SetError("FLAC output is not available, SDL_audiolib was built without libFLAC.");
+    return false;
+#endif
+}
+
+auto Aulib::FileSink_priv::fWriteFlac([[maybe_unused]] const float buf[],
+                                      [[maybe_unused]] const int frames) -> bool
+{
+#if USE_DEC_FLAC
+    const int samples = frames * fChannels;
+    if (fFlacBuf.size() < samples) {
+        fFlacBuf.reset(samples);
+    }
+    for (int i = 0; i < samples; ++i) {
+        fFlacBuf[i] = static_cast<FLAC__int32>(
+            std::lround(Aulib::priv::clamp(buf[i], -1.f, 1.f) * 8388607.f));
+    }
+    if (not FLAC__stream_encoder_process_interleaved(fFlac.get(), fFlacBuf.get(), frames)) {
+        SDL_SetError("FLAC encoding failed: %s",
+                     FLAC__StreamEncoderStateString[FLAC__stream_encoder_get_state(fFlac.get())]);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+auto Aulib::FileSink_priv::fFinishFlac() -> bool
+{
+#if USE_DEC_FLAC
+    const bool ok = FLAC__stream_encoder_finish(fFlac.get());
+    if (not ok) {
+        SDL_SetError("Failed to finish FLAC stream.");
+    }
+    fFlac.reset();
+    return ok;
+#else
+    return false;
+#endif
+}
+
+Aulib::FileSink::FileSink(const FileFormat format)
+    : d(std::make_unique<FileSink_priv>(format))
+{}
+
+Aulib::FileSink::~FileSink()
+{
+    close();
+}
+
+auto Aulib::FileSink::open(const std::string& filename) -> bool
+{
+    SDL_RWops* const rwops = SDL_RWFromFile(filename.c_str(), "wb");
+    if (not rwops) {
+        return false;
+    }
+    return open(rwops, true);
+}
+
+auto Aulib::FileSink::open(SDL_RWops* const rwops, const bool closeRw) -> bool
+{
+    close();
+
+    if (not rwops) {
+        SDL_SetError("Cannot open file sink: null rwops.");
+        return false;
+    }
+    if (Aulib::sampleRate() <= 0 or Aulib::channelCount() <= 0) {
+        SDL_SetError("Cannot open file sink: SDL_audiolib is not initialized.");
+        if (closeRw) {
+            SDL_RWclose(rwops);
+        }
+        return false;
+    }
+
+    d->fRwops = rwops;
+    d->fCloseRw = closeRw;
+    d->fChannels = Aulib::channelCount();
+    d->fRate = Aulib::sampleRate();
+    d->fFrames = 0;
+    d->fDataBytes = 0;
+
+    bool ok = false;
+    if (d->fFormat == FileFormat::Flac) {
+        ok = d->fOpenFlac();
+    } else {
+        const AudioFormat sampleFormat = d->fIsFloat() ? AUDIO_F32LSB : AUDIO_S16LSB;
+        d->fConverter = simdSampleConverterFor(sampleFormat);
+        if (not d->fConverter) {
+            d->fConverter = d->fIsFloat() ? floatToFloatLSB : floatToS16LSB;
+        }
+        d->fHeaderPos = SDL_RWtell(rwops);
+        // Until the file is closed, the sizes are unknown. Streaming readers accept the maximum.
+        ok = d->fWriteWavHeader(0xFFFFFFFFu, 0xFFFFFFFFu);
+    }
+    if (not ok) {
+        if (closeRw) {
+            SDL_RWclose(rwops);
+        }
+        d->fRwops = nullptr;
+        return false;
+    }
+    return true;
+}
+
+auto Aulib::FileSink::isOpen() const -> bool
+{
+    return d->fRwops != nullptr;
+}
+
+auto Aulib::FileSink::write(const float buf[], const int frames) -> bool
+{
+    if (not isOpen()) {
+        SDL_SetError("File sink is not open.");
+        return false;
+    }
+    if (frames <= 0) {
+        return true;
+    }
+
+    const bool ok = d->fFormat == FileFormat::Flac ? d->fWriteFlac(buf, frames)
+                                                   : d->fWriteWav(buf, frames);
+    if (ok) {
+        d->fFrames += frames;
+    }
+    return ok;
+}
+
+auto Aulib::FileSink::render(const chrono::microseconds duration) -> bool
+{
+    if (not isOpen()) {
+        SDL_SetError("File sink is not open.");
+        return false;
+    }
+
+    const auto micros = std::max<chrono::microseconds::rep>(0, duration.count());
+    const Uint64 totalFrames = static_cast<Uint64>(micros) * d->fRate / 1000000;
+    const int blockFrames = std::max(Aulib::frameSize(), 1);
+    if (d->fRenderBuf.size() < blockFrames * d->fChannels) {
+        d->fRenderBuf.reset(blockFrames * d->fChannels);
+    }
+    for (Uint64 pos = 0; pos < totalFrames; pos += blockFrames) {
+        const int frames = static_cast<int>(std::min<Uint64>(blockFrames, totalFrames - pos));
+        if (not Aulib::renderMix(d->fRenderBuf.get(), frames)
+            or not write(d->fRenderBuf.get(), frames)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+auto Aulib::FileSink::close() -> bool
+{
+    if (not isOpen()) {
+        return true;
+    }
+
+    const bool ok = d->fFormat == FileFormat::Flac ? d->fFinishFlac() : d->fFinishWav();
+    if (d->fCloseRw) {
+        SDL_RWclose(d->fRwops);
+    }
+    d->fRwops = nullptr;
+    return ok;
+}
+
+auto Aulib::FileSink::framesWritten() const -> Uint64
+{
+    return d->fFrames;
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,204 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "MixPool.h"
+
+#include "aulib_debug.h"
+#include "aulib_log.h"
+#include "trace.h"
+#include <SDL_thread.h>
+#include <SDL_version.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct Pool;
+
+struct Worker final
+{
+    SDL_Thread* thread = nullptr;
+    SDL_sem* start = nullptr;
+    int lane = 0;
+    Pool* pool = nullptr;
+};
+
+// A set of worker threads. A new set is started while the current one is still in use, and swapped
+// in once it's ready.
+struct Pool final
+{
+    std::vector<Worker> workers;
+    SDL_sem* doneSem = nullptr;
+    std::atomic<bool> quit{false};
+};
+
+} // namespace
+
+static std::unique_ptr<Pool> gActive;
+static std::unique_ptr<Pool> gPrepared;
+static std::unique_ptr<Pool> gRetired;
+static void (*gFunc)(int) = nullptr;
+// Lanes of the active pool, readable without holding the audio lock.
+static std::atomic<int> gThreadCount{1};
+
+extern "C" {
+static int mixThreadMain(void* data)
+{
+    const auto* worker = static_cast<Worker*>(data);
+
+#if SDL_VERSION_ATLEAST(2, 0, 9)
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL);
+#elif SDL_VERSION_ATLEAST(2, 0, 0)
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+#endif
+    AM_traceThreadName("mix worker");
+
+    while (true) {
+        SDL_SemWait(worker->start);
+        if (worker->pool->quit) {
+            break;
+        }
+        gFunc(worker->lane);
+        SDL_SemPost(worker->pool->doneSem);
+    }
+    return 0;
+}
+}
+
+static void stopPool(std::unique_ptr<Pool>& pool)
+{
+    if (not pool) {
+        return;
+    }
+    pool->quit = true;
+    for (const auto& worker : pool->workers) {
+        SDL_SemPost(worker.start);
+    }
+    for (const auto& worker : pool->workers) {
+        SDL_WaitThread(worker.thread, nullptr);
+        SDL_DestroySemaphore(worker.start);
+    }
+    if (pool->doneSem) {
+        SDL_DestroySemaphore(pool->doneSem);
+    }
+    pool.reset();
+}
+
+static auto startPool(const int count) -> std::unique_ptr<Pool>
+{
+    auto pool = std::make_unique<Pool>();
+    if (count <= 1) {
+        return pool;
+    }
+
+    pool->doneSem = SDL_CreateSemaphore(0);
+    if (not pool->doneSem) {
+        aulib::log::warnLn("Failed to create mix thread semaphore: {}", SDL_GetError());
+        return pool;
+    }
+    // Reserve up front; the threads keep pointers to their Worker.
+    auto& workers = pool->workers;
+    workers.reserve(count - 1);
+    for (int i = 1; i < count; ++i) {
+        Worker worker;
+        worker.lane = static_cast<int>(workers.size()) + 1;
+        worker.pool = pool.get();
+        worker.start = SDL_CreateSemaphore(0);
+        if (not worker.start) {
+            aulib::log::warnLn("Failed to create mix thread semaphore: {}", SDL_GetError());
+            break;
+        }
+        workers.push_back(worker);
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+        workers.back().thread = SDL_CreateThread(mixThreadMain, "aulib mix", &workers.back());
+#else
+        workers.back().thread = SDL_CreateThread(mixThreadMain, &workers.back());
+#endif
+        if (not workers.back().thread) {
+            aulib::log::warnLn("Failed to create mix thread: {}", SDL_GetError());
+            SDL_DestroySemaphore(workers.back().start);
+            workers.pop_back();
+            break;
+        }
+    }
+    aulib::log::debugLn("Started {} mix thread(s).", workers.size());
+    return pool;
+}
+
+void Aulib::MixPool::setThreadCount(const int count)
+{
+    prepareThreadCount(count);
+    swapPrepared();
+    stopRetired();
+}
+
+void Aulib::MixPool::prepareThreadCount(const int count)
+{
+    stopPool(gPrepared);
+    gPrepared = startPool(count);
+}
+
+void Aulib::MixPool::swapPrepared()
+{
+    AM_debugAssert(not gRetired);
+    if (not gPrepared) {
+        return;
+    }
+    gRetired = std::move(gActive);
+    gActive = std::move(gPrepared);
+    gThreadCount = static_cast<int>(gActive->workers.size()) + 1;
+}
+
+void Aulib::MixPool::stopRetired()
+{
+    stopPool(gRetired);
+}
+
+auto Aulib::MixPool::threadCount() noexcept -> int
+{
+    return gThreadCount;
+}
+
+void Aulib::MixPool::run(void (*func)(int lane))
+{
+    if (not gActive) {
+        func(0);
+        return;
+    }
+    gFunc = func;
+    for (const auto& worker : gActive->workers) {
+        SDL_SemPost(worker.start);
+    }
+    func(0);
+    for (size_t i = 0; i < gActive->workers.size(); ++i) {
+        SDL_SemWait(gActive->doneSem);
+    }
+}
+
+void Aulib::MixPool::shutdown()
+{
+    stopPool(gPrepared);
+    stopPool(gRetired);
+    stopPool(gActive);
+    gThreadCount = 1;
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
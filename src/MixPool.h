@@ -0,0 +1,59 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_global.h"
+
+namespace Aulib {
+
+/*
+ * Fixed pool of high priority worker threads used by the audio callback to mix streams in
+ * parallel. Each thread works on its own "lane". Lane 0 always runs on the thread that calls run(),
+ * so a pool with a thread count of 1 has no worker threads at all.
+ */
+namespace MixPool {
+
+// Must not be called while run() is in progress; hold the audio lock.
+AULIB_NO_EXPORT void setThreadCount(int count);
+AULIB_NO_EXPORT auto threadCount() noexcept -> int;
+
+/*
+ * Changing the thread count while the audio device is running. Starting and stopping threads takes
+ * a while, so only swapPrepared() needs the audio lock:
+ *
+ *   prepareThreadCount() starts the new threads. The current ones are still used by run().
+ *   swapPrepared() makes run() use the new threads. Must not be called while run() is in
+ *   progress; hold the audio lock.
+ *   stopRetired() stops the threads that were swapped out. Must be called after each swap.
+ */
+AULIB_NO_EXPORT void prepareThreadCount(int count);
+AULIB_NO_EXPORT void swapPrepared();
+AULIB_NO_EXPORT void stopRetired();
+
+// Calls 'func' once for each lane, in parallel, and returns after all of them are done.
+AULIB_NO_EXPORT void run(void (*func)(int lane));
+
+AULIB_NO_EXPORT void shutdown();
+
+} // namespace MixPool
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
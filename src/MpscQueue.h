@@ -0,0 +1,144 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "Buffer.h"
+#include "aulib_debug.h"
+#include <SDL_stdinc.h>
+#include <atomic>
+
+/*
+ * Bounded lock-free multi-producer, single-consumer queue.
+ *
+ * Any number of threads may push into the queue concurrently. Only one thread at a time may consume
+ * from it. Producers can push several elements at once, in which case they end up next to each
+ * other in the queue even if other producers push at the same time.
+ *
+ * Each slot carries a sequence number that tells whether it's free for the producer of a given
+ * position or holds an element for the consumer. Since the consumer frees slots in order, a free
+ * slot means that all the slots before it are free too.
+ */
+template <typename T>
+class MpscQueue final
+{
+public:
+    // 'capacity' must be a power of two.
+    explicit MpscQueue(const int capacity)
+        : fSlots(capacity)
+        , fMask(static_cast<Uint64>(capacity) - 1)
+    {
+        AM_debugAssert(capacity > 0 and (capacity & (capacity - 1)) == 0);
+        for (int i = 0; i < capacity; ++i) {
+            fSlots[i].seq.store(static_cast<Uint64>(i), std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    auto operator=(const MpscQueue&) -> MpscQueue& = delete;
+
+    auto capacity() const noexcept -> int
+    {
+        return fSlots.size();
+    }
+
+    /*
+     * Producer side.
+     */
+
+    // Push 'count' elements so that they're adjacent in the queue. Returns false without pushing
+    // anything if there's not enough room.
+    auto push(const T items[], const int count) noexcept -> bool
+    {
+        if (count <= 0 or count > capacity()) {
+            return count == 0;
+        }
+
+        Uint64 pos = fWritePos.load(std::memory_order_relaxed);
+        for (;;) {
+            const Uint64 last = pos + static_cast<Uint64>(count) - 1;
+            const auto diff = static_cast<Sint64>(
+                slotFor(last).seq.load(std::memory_order_acquire) - last);
+            if (diff == 0) {
+                if (fWritePos.compare_exchange_weak(pos, pos + static_cast<Uint64>(count),
+                                                    std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // The consumer hasn't freed the slot yet.
+                return false;
+            } else {
+                pos = fWritePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        for (int i = 0; i < count; ++i) {
+            Slot& slot = slotFor(pos + static_cast<Uint64>(i));
+            slot.value = items[i];
+            slot.seq.store(pos + static_cast<Uint64>(i) + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    /*
+     * Consumer side.
+     */
+
+    // Returns the element 'offset' positions after the front of the queue, or null if that
+    // element hasn't been fully pushed yet.
+    auto peek(const int offset) noexcept -> const T*
+    {
+        const Uint64 pos = fReadPos + static_cast<Uint64>(offset);
+        Slot& slot = slotFor(pos);
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+            return nullptr;
+        }
+        return &slot.value;
+    }
+
+    // Removes 'count' elements from the front. They must all have been peeked at.
+    void pop(const int count) noexcept
+    {
+        for (int i = 0; i < count; ++i) {
+            AM_debugAssert(peek(0));
+            slotFor(fReadPos).seq.store(fReadPos + fMask + 1, std::memory_order_release);
+            ++fReadPos;
+        }
+    }
+
+private:
+    struct Slot final
+    {
+        std::atomic<Uint64> seq{0};
+        T value{};
+    };
+
+    Buffer<Slot> fSlots;
+    const Uint64 fMask;
+    alignas(64) std::atomic<Uint64> fWritePos{0};
+    alignas(64) Uint64 fReadPos = 0;
+
+    auto slotFor(const Uint64 pos) noexcept -> Slot&
+    {
+        return fSlots[static_cast<int>(pos & fMask)];
+    }
+};
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
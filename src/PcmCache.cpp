@@ -0,0 +1,267 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "Aulib/PcmCache.h"
+
+#include "Aulib/Decoder.h"
+#include "Aulib/Resampler.h"
+#include "Aulib/ResamplerSpeex.h"
+#include "SdlMutex.h"
+#include "aulib.h"
+#include "aulib_log.h"
+#include "chanlayout.h"
+#include <SDL_error.h>
+#include <SDL_rwops.h>
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+constexpr std::size_t DEFAULT_BUDGET = 64 * 1024 * 1024;
+// Samples decoded per call while filling a buffer. Divisible by every supported channel count.
+constexpr int DECODE_CHUNK = 4200;
+
+namespace {
+
+struct Entry final
+{
+    std::string key;
+    std::shared_ptr<const Aulib::PcmBuffer> pcm;
+    // Channels of the sound itself. The buffer has less if the device had less.
+    int sourceChannels;
+};
+
+} // namespace
+
+// Most recently requested first. Everything is protected by gMutex.
+static std::list<Entry> gEntries;
+static std::unordered_map<std::string, std::list<Entry>::iterator> gIndex;
+static std::size_t gBudget = DEFAULT_BUDGET;
+static std::size_t gUsedBytes = 0;
+static SdlMutex gMutex;
+
+static auto bytesOf(const Aulib::PcmBuffer& pcm) -> std::size_t
+{
+    return pcm.samples.size() * sizeof(pcm.samples[0]);
+}
+
+static void eraseEntry(const std::list<Entry>::iterator it)
+{
+    gUsedBytes -= bytesOf(*it->pcm);
+    gIndex.erase(it->key);
+    gEntries.erase(it);
+}
+
+// Drops the least recently requested sounds until 'bytes' more fit into the budget.
+static void makeRoom(const std::size_t bytes)
+{
+    while (not gEntries.empty() and gUsedBytes + bytes > gBudget) {
+        eraseEntry(std::prev(gEntries.end()));
+    }
+}
+
+// Must be called with gMutex locked. Sounds decoded for a different output format are dropped.
+// Sounds with less channels than the device are kept that way, so they work with any channel count
+// that isn't lower.
+static auto lookup(const std::string& key) -> std::shared_ptr<const Aulib::PcmBuffer>
+{
+    const auto found = gIndex.find(key);
+    if (found == gIndex.end()) {
+        return nullptr;
+    }
+    const auto it = found->second;
+    if (it->pcm->rate != Aulib::sampleRate()
+        or it->pcm->channels != std::min(it->sourceChannels, Aulib::channelCount())) {
+        eraseEntry(it);
+        return nullptr;
+    }
+    gEntries.splice(gEntries.begin(), gEntries, it);
+    return it->pcm;
+}
+
+static auto decodeAll(const std::string& key, SDL_RWops* rwops,
+                      std::unique_ptr<Aulib::Decoder> decoder,
+                      std::unique_ptr<Aulib::Resampler> resampler, int& sourceChannels)
+    -> std::shared_ptr<Aulib::PcmBuffer>
+{
+    if (Aulib::sampleRate() <= 0) {
+        SDL_SetError("Cannot decode sound: SDL_audiolib is not initialized.");
+        return nullptr;
+    }
+    if (not decoder) {
+        // Keys are usually file names. The probed decoder is already open, so the open() below
+        // doesn't parse the file again.
+        decoder = Aulib::Decoder::probe(rwops, false, key).decoder;
+        if (not decoder) {
+            SDL_SetError("Cannot decode sound: no suitable decoder found.");
+            return nullptr;
+        }
+    }
+    if (not decoder->open(rwops)) {
+        return nullptr;
+    }
+
+    auto pcm = std::make_shared<Aulib::PcmBuffer>();
+    pcm->rate = Aulib::sampleRate();
+    // Sounds with less channels than the device are stored as they are. The mixer converts them on
+    // its own, so there's no need to store them with more.
+    sourceChannels = decoder->getChannels();
+    if (sourceChannels > Aulib::MAX_CHANNELS) {
+        SDL_SetError("Cannot decode sound: more than %d channels.", Aulib::MAX_CHANNELS);
+        return nullptr;
+    }
+    pcm->channels = std::min(sourceChannels, Aulib::channelCount());
+    decoder->setOutputChannels(pcm->channels);
+    if (const auto duration = decoder->duration(); duration.count() > 0) {
+        // Only a hint. Some decoders report inexact durations.
+        pcm->samples.reserve(duration.count() * pcm->rate / 1000000 * pcm->channels
+                             + DECODE_CHUNK);
+    }
+
+    std::shared_ptr<Aulib::Decoder> sharedDecoder = std::move(decoder);
+    if (not resampler and sharedDecoder->getRate() != pcm->rate) {
+        resampler = std::make_unique<Aulib::ResamplerSpeex>();
+    }
+    if (resampler) {
+        resampler->setDecoder(sharedDecoder);
+        resampler->setSpec(pcm->rate, pcm->channels, Aulib::frameSize());
+    }
+
+    auto& samples = pcm->samples;
+    bool callAgain = false;
+    while (true) {
+        const std::size_t pos = samples.size();
+        samples.resize(pos + DECODE_CHUNK);
+        int len;
+        if (resampler) {
+            len = resampler->resample(samples.data() + pos, DECODE_CHUNK);
+        } else {
+            callAgain = false;
+            len = sharedDecoder->decode(samples.data() + pos, DECODE_CHUNK, callAgain);
+        }
+        samples.resize(pos + std::max(len, 0));
+        if (len <= 0 and not callAgain) {
+            break;
+        }
+    }
+    samples.shrink_to_fit();
+    return pcm;
+}
+
+auto Aulib::PcmCache::get(const std::string& filename) -> std::shared_ptr<const PcmBuffer>
+{
+    if (auto pcm = find(filename)) {
+        return pcm;
+    }
+    SDL_RWops* rwops = SDL_RWFromFile(filename.c_str(), "rb");
+    if (not rwops) {
+        return nullptr;
+    }
+    return get(filename, rwops, nullptr, nullptr, true);
+}
+
+auto Aulib::PcmCache::get(const std::string& key, SDL_RWops* rwops,
+                          std::unique_ptr<Decoder> decoder, std::unique_ptr<Resampler> resampler,
+                          const bool closeRw) -> std::shared_ptr<const PcmBuffer>
+{
+    std::shared_ptr<const PcmBuffer> pcm = find(key);
+    int sourceChannels = 0;
+    if (not pcm) {
+        if (rwops) {
+            pcm = decodeAll(key, rwops, std::move(decoder), std::move(resampler), sourceChannels);
+        } else {
+            SDL_SetError("Cannot decode sound: null rwops.");
+        }
+    }
+    if (closeRw and rwops) {
+        SDL_RWclose(rwops);
+    }
+    if (not pcm) {
+        aulib::log::warnLn("Failed to decode \"{}\": {}", key, SDL_GetError());
+        return nullptr;
+    }
+
+    std::lock_guard<SdlMutex> lock(gMutex);
+
+    // Another thread might have decoded the same sound in the meantime. Keep the one that's
+    // already shared.
+    if (auto cached = lookup(key)) {
+        return cached;
+    }
+    const std::size_t bytes = bytesOf(*pcm);
+    if (bytes > gBudget) {
+        return pcm;
+    }
+    makeRoom(bytes);
+    gEntries.push_front({key, pcm, sourceChannels});
+    gIndex[key] = gEntries.begin();
+    gUsedBytes += bytes;
+    return pcm;
+}
+
+auto Aulib::PcmCache::find(const std::string& key) -> std::shared_ptr<const PcmBuffer>
+{
+    std::lock_guard<SdlMutex> lock(gMutex);
+
+    return lookup(key);
+}
+
+void Aulib::PcmCache::remove(const std::string& key)
+{
+    std::lock_guard<SdlMutex> lock(gMutex);
+
+    if (const auto found = gIndex.find(key); found != gIndex.end()) {
+        eraseEntry(found->second);
+    }
+}
+
+void Aulib::PcmCache::clear()
+{
+    std::lock_guard<SdlMutex> lock(gMutex);
+
+    gIndex.clear();
+    gEntries.clear();
+    gUsedBytes = 0;
+}
+
+void Aulib::PcmCache::setBudget(const std::size_t bytes)
+{
+    std::lock_guard<SdlMutex> lock(gMutex);
+
+    gBudget = bytes;
+    makeRoom(0);
+}
+
+auto Aulib::PcmCache::budget() -> std::size_t
+{
+    std::lock_guard<SdlMutex> lock(gMutex);
+
+    return gBudget;
+}
+
+auto Aulib::PcmCache::usedBytes() -> std::size_t
+{
+    std::lock_guard<SdlMutex> lock(gMutex);
+
+    return gUsedBytes;
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
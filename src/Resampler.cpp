@@ -5,34 +5,146 @@
 #include "Buffer.h"
 #include "aulib_global.h"
 #include "aulib_log.h"
+#include "chanlayout.h"
+#include "rtcheck.h"
+#include "sampleconv.h"
+#include "trace.h"
 #include <SDL_audio.h>
 #include <algorithm>
+#include <array>
 #include <cmath>
-#include <cstring>
 #include <utility>
 
-/* Relocate any samples in the specified buffer to the beginning:
+using Planes = std::array<float*, Aulib::MAX_CHANNELS>;
+
+// Returns pointers to the channels of a planar buffer, 'offset' frames in.
+static auto planesOf(float* const buf, const int planeSize, const int channels, const int offset)
+    -> Planes
+{
+    Planes planes{};
+    for (int chan = 0; chan < channels; ++chan) {
+        planes[chan] = buf + chan * planeSize + offset;
+    }
+    return planes;
+}
+
+namespace {
+
+/* Staging buffer used as a ring of whole frames. Samples that are left over after a read stay
+ * where they are instead of being moved to the front, and writes continue at the start once the
+ * end is reached:
  *
- *      ....ssss  ->  ssss....
+ *      ss....ss
  *
- * The tracking indices are adjusted as needed.
+ * The capacity is a power of two, so positions wrap around with a mask, and a frame never
+ * straddles the end of the buffer. Audio is either interleaved, or stored as one ring per channel,
+ * one after the other. The ring itself doesn't care, only the pointers into it differ.
  */
-static void relocateBuffer(float* buf, int& pos, int& end)
+struct FrameRing final
 {
-    if (end < 1) {
-        return;
+    Buffer<float> fData{0};
+    int fFrames = 0;
+    int fChannels = 0;
+    // Read position and amount of frames stored, both in frames.
+    int fPos = 0;
+    int fFilled = 0;
+
+    /* Makes room for at least 'minFrames' frames of 'channels' channels. Stored frames are kept
+     * if 'keep' is set and the amount of channels stays the same, otherwise the ring is emptied.
+     */
+    void resize(int minFrames, int channels, bool keep);
+
+    void clear() noexcept
+    {
+        fPos = fFilled = 0;
     }
-    if (pos >= end) {
-        pos = end = 0;
-        return;
+
+    auto space() const noexcept -> int
+    {
+        return fFrames - fFilled;
+    }
+
+    auto writePos() const noexcept -> int
+    {
+        return (fPos + fFilled) & (fFrames - 1);
+    }
+
+    // Frames that can be read or written in one go, without wrapping around.
+    auto readable() const noexcept -> int
+    {
+        return std::min(fFilled, fFrames - fPos);
+    }
+
+    auto writable() const noexcept -> int
+    {
+        return std::min(space(), fFrames - writePos());
+    }
+
+    void commit(const int frames) noexcept
+    {
+        fFilled += frames;
+    }
+
+    void consume(const int frames) noexcept
+    {
+        fFilled -= frames;
+        // Start over when empty, so that the next write gets the whole buffer in one piece.
+        fPos = fFilled == 0 ? 0 : (fPos + frames) & (fFrames - 1);
+    }
+
+    auto at(const int frame) noexcept -> float*
+    {
+        return fData.get() + frame * fChannels;
+    }
+
+    auto planes(const int frame) noexcept -> Planes
+    {
+        return planesOf(fData.get(), fFrames, fChannels, frame);
+    }
+
+    // Rotates the stored frames to the start of the buffer, so that they can be read in one go.
+    void linearize(bool planar);
+};
+
+} // namespace
+
+void FrameRing::resize(const int minFrames, const int channels, const bool keep)
+{
+    int frames = 1;
+    while (frames < minFrames) {
+        frames *= 2;
     }
-    if (pos < 1) {
+    if (not keep or channels != fChannels) {
+        clear();
+    }
+    // This can happen on the audio thread when the decoder changes its spec mid-stream, so avoid
+    // reallocating if the size stays the same.
+    if (frames == fFrames and channels == fChannels) {
         return;
     }
-    int len = end - pos;
-    memmove(buf, buf + pos, static_cast<size_t>(len) * sizeof(*buf));
-    pos = 0;
-    end = len;
+    Buffer<float> data(frames * channels);
+    const int kept = std::min(fFilled, frames);
+    const int first = std::min(kept, fFrames - fPos);
+    std::copy_n(at(fPos), first * channels, data.get());
+    std::copy_n(at(0), (kept - first) * channels, data.get() + first * channels);
+    fData.swap(data);
+    fFrames = frames;
+    fChannels = channels;
+    fPos = 0;
+    fFilled = kept;
+}
+
+void FrameRing::linearize(const bool planar)
+{
+    if (not planar) {
+        std::rotate(fData.begin(), at(fPos), fData.end());
+    } else {
+        const auto chans = planes(0);
+        for (int chan = 0; chan < fChannels; ++chan) {
+            std::rotate(chans[chan], chans[chan] + fPos, chans[chan] + fFrames);
+        }
+    }
+    fPos = 0;
 }
 
 namespace Aulib {
@@ -48,13 +160,13 @@ struct Resampler_priv final
     int fSrcRate = 0;
     int fChannels = 0;
     int fChunkSize = 0;
-    Buffer<float> fOutBuffer{0};
-    Buffer<float> fInBuffer{0};
-    int fOutBufferPos = 0;
-    int fOutBufferEnd = 0;
-    int fInBufferPos = 0;
-    int fInBufferEnd = 0;
+    FrameRing fOutBuffer;
+    FrameRing fInBuffer;
     bool fPendingSpecChange = false;
+    // In planar mode, fInBuffer holds one ring per channel. The resampler's output goes to
+    // fOutPlanes, and is interleaved into fOutBuffer from there.
+    bool fPlanar = false;
+    Buffer<float> fOutPlanes{0};
 
     /* Move at most 'dstLen' samples from the output buffer into 'dst'.
      *
@@ -65,12 +177,30 @@ struct Resampler_priv final
     /* Adjust all internal buffer sizes for the current source and target
      * sampling rates.
      */
-    void fAdjustBufferSizes();
+    void fAdjustBufferSizes(bool wasPlanar, int oldChannels);
+
+    // Decodes into the free part of the input buffer. Returns the amount of frames decoded.
+    auto fDecodeIntoInBuffer(bool& callAgain) -> int;
+
+    /* Whether the decoder can write straight into the caller's buffer. That's the case when the
+     * rates are the same and our buffers are empty, so that no samples get out of order.
+     */
+    auto fCanBypass() const noexcept -> bool
+    {
+        return fSrcRate == fDstRate and fInBuffer.fFilled == 0 and fOutBuffer.fFilled == 0;
+    }
 
     /* Resample samples from the input buffer and move them to the output
      * buffer.
      */
     void fResampleFromInBuffer();
+
+    /* Resample what's in the input buffer using the current spec and move it to 'dst', until
+     * either 'dst' is full or no more progress is made.
+     *
+     * Returns the amount of samples that were moved.
+     */
+    auto fDrain(float dst[], int dstLen) -> int;
 };
 
 } // namespace Aulib
@@ -81,77 +211,103 @@ Aulib::Resampler_priv::Resampler_priv(Resampler* pub)
 
 auto Aulib::Resampler_priv::fMoveFromOutBuffer(float dst[], int dstLen) -> int
 {
-    if (fOutBufferEnd == 0) {
-        return 0;
-    }
-    if (fOutBufferPos >= fOutBufferEnd) {
-        fOutBufferPos = fOutBufferEnd = 0;
-        return 0;
-    }
-    int len = std::min(fOutBufferEnd - fOutBufferPos, dstLen);
-    memcpy(dst, fOutBuffer.get() + fOutBufferPos,
-           static_cast<size_t>(len) * sizeof(*fOutBuffer.get()));
-    fOutBufferPos += len;
-    if (fOutBufferPos >= fOutBufferEnd) {
-        fOutBufferEnd = fOutBufferPos = 0;
+    int len = 0;
+    while (fOutBuffer.fFilled > 0) {
+        const int frames = std::min(fOutBuffer.readable(), (dstLen - len) / fChannels);
+        if (frames == 0) {
+            break;
+        }
+        std::copy_n(fOutBuffer.at(fOutBuffer.fPos), frames * fChannels, dst + len);
+        fOutBuffer.consume(frames);
+        len += frames * fChannels;
     }
     return len;
 }
 
-void Aulib::Resampler_priv::fAdjustBufferSizes()
+void Aulib::Resampler_priv::fAdjustBufferSizes(const bool wasPlanar, const int oldChannels)
 {
-    int oldInBufLen = fInBufferEnd - fInBufferPos;
-    int outBufSiz = fChannels * fChunkSize;
-    int inBufSiz;
-
-    if (fDstRate == fSrcRate) {
-        // In the no-op case where we don't actually resample, input and output
-        // buffers have the same size, since we're just copying the samples
-        // as-is from input to output.
-        inBufSiz = outBufSiz;
-    } else {
-        // When resampling, the input buffer's size depends on the ratio between
-        // the source and destination sample rates.
-        inBufSiz = std::ceil(static_cast<float>(outBufSiz) * fSrcRate / fDstRate);
-        auto remainder = inBufSiz % fChannels;
-        if (remainder != 0) {
-            inBufSiz = inBufSiz + fChannels - remainder;
-        }
+    int inFrames = fChunkSize;
+
+    // In the no-op case where we don't actually resample, the decoder writes straight into the
+    // caller's buffer. Ours only hold samples left over from before a spec change, which are
+    // copied as-is, so input and output buffers have the same size. When resampling, the input
+    // buffer's size depends on the ratio between the source and destination sample rates.
+    if (fDstRate != fSrcRate) {
+        inFrames = std::ceil(static_cast<float>(fChunkSize) * fSrcRate / fDstRate);
     }
 
-    fOutBuffer.reset(outBufSiz);
-    fInBuffer.resize(inBufSiz);
-    fOutBufferPos = fOutBufferEnd = fInBufferPos = 0;
-    if (oldInBufLen != 0) {
-        fInBufferEnd = oldInBufLen;
-    } else {
-        fInBufferEnd = 0;
+    // Leftover samples of planar audio, or of a different channel count, would end up in the
+    // wrong channel.
+    const bool keep = not fPlanar and not wasPlanar and fChannels == oldChannels;
+    fInBuffer.resize(inFrames, fChannels, keep);
+    fOutBuffer.resize(fChunkSize, fChannels, false);
+    if (fPlanar and fOutPlanes.size() != fChunkSize * fChannels) {
+        fOutPlanes.reset(fChunkSize * fChannels);
+    }
+}
+
+auto Aulib::Resampler_priv::fDecodeIntoInBuffer(bool& callAgain) -> int
+{
+    const int pos = fInBuffer.writePos();
+    const int frames = fInBuffer.writable();
+    if (not fPlanar) {
+        return fDecoder->decode(fInBuffer.at(pos), frames * fChannels, callAgain) / fChannels;
     }
+    return fDecoder->decodePlanar(fInBuffer.planes(pos).data(), frames, callAgain);
 }
 
 void Aulib::Resampler_priv::fResampleFromInBuffer()
 {
-    int inLen = fInBufferEnd - fInBufferPos;
-    float* from = fInBuffer.get() + fInBufferPos;
-    float* to = fOutBuffer.get() + fOutBufferEnd;
-    if (fSrcRate == fDstRate) {
+    const int inAvail = fInBuffer.readable();
+    const int outAvail = fOutBuffer.writable();
+    int inFrames = inAvail;
+    int outFrames = outAvail;
+    float* to = fOutBuffer.at(fOutBuffer.writePos());
+    if (fPlanar) {
+        // Planar mode is only used when the rates differ.
+        outFrames = std::min(outFrames, fChunkSize);
+        const auto src = fInBuffer.planes(fInBuffer.fPos);
+        const auto dst = planesOf(fOutPlanes.get(), fChunkSize, fChannels, 0);
+        q->doResamplingPlanar(dst.data(), src.data(), outFrames, inFrames);
+        interleave(to, dst.data(), fChannels, outFrames);
+    } else if (fSrcRate == fDstRate) {
         // No resampling is needed. Just copy the samples as-is.
-        int outLen = std::min(fOutBuffer.size() - fOutBufferEnd, inLen);
-        std::memcpy(to, from, static_cast<size_t>(outLen) * sizeof(*from));
-        fOutBufferEnd += outLen;
-        fInBufferPos += outLen;
+        inFrames = outFrames = std::min(inFrames, outFrames);
+        std::copy_n(fInBuffer.at(fInBuffer.fPos), inFrames * fChannels, to);
     } else {
-        int outLen = fOutBuffer.size() - fOutBufferEnd;
-        q->doResampling(to, from, outLen, inLen);
-        fOutBufferEnd += outLen;
-        fInBufferPos += inLen;
+        int outLen = outFrames * fChannels;
+        int inLen = inFrames * fChannels;
+        q->doResampling(to, fInBuffer.at(fInBuffer.fPos), outLen, inLen);
+        outFrames = outLen / fChannels;
+        inFrames = inLen / fChannels;
     }
-    if (fInBufferPos >= fInBufferEnd) {
-        // No more samples left to resample. Mark the input buffer as empty.
-        fInBufferPos = fInBufferEnd = 0;
+    fOutBuffer.commit(outFrames);
+    fInBuffer.consume(inFrames);
+
+    // A resampler is allowed to leave samples at the end of its input unused. If that happens
+    // right before the wrap-around point, it would never see the samples that follow. Put them
+    // all in one piece and try again. This is rare, so it's fine to move the samples here.
+    if (inFrames == 0 and outFrames == 0 and outAvail > 0 and inAvail < fInBuffer.fFilled) {
+        fInBuffer.linearize(fPlanar);
+        fResampleFromInBuffer();
     }
 }
 
+auto Aulib::Resampler_priv::fDrain(float dst[], const int dstLen) -> int
+{
+    int len = fMoveFromOutBuffer(dst, dstLen);
+    while (len < dstLen and fInBuffer.fFilled > 0) {
+        const int inFilled = fInBuffer.fFilled;
+        fResampleFromInBuffer();
+        const int moved = fMoveFromOutBuffer(dst + len, dstLen - len);
+        len += moved;
+        if (moved == 0 and fInBuffer.fFilled == inFilled) {
+            break;
+        }
+    }
+    return len;
+}
+
 Aulib::Resampler::Resampler()
     : d(std::make_unique<Resampler_priv>(this))
 {}
@@ -165,12 +321,16 @@ void Aulib::Resampler::setDecoder(std::shared_ptr<Decoder> decoder)
 
 auto Aulib::Resampler::setSpec(int dstRate, int channels, int chunkSize) -> int
 {
+    const int oldChannels = d->fChannels;
     d->fDstRate = dstRate;
     d->fChannels = channels;
     d->fChunkSize = chunkSize;
     d->fSrcRate = d->fDecoder->getRate();
     d->fSrcRate = std::min(std::max(4000, d->fSrcRate), 192000);
-    d->fAdjustBufferSizes();
+    const bool wasPlanar = d->fPlanar;
+    d->fPlanar = d->fSrcRate != d->fDstRate and supportsPlanar() and d->fDecoder->supportsPlanar()
+                 and channels <= MAX_CHANNELS;
+    d->fAdjustBufferSizes(wasPlanar, oldChannels);
     // Inform our child class about the spec change.
     adjustForOutputSpec(d->fDstRate, d->fSrcRate, d->fChannels);
     return 0;
@@ -193,19 +353,23 @@ auto Aulib::Resampler::currentChunkSize() const -> int
 
 auto Aulib::Resampler::resample(float dst[], int dstLen) -> int
 {
+    AM_rtContext("resampler", typeid(*this).name());
+    AM_traceScope("resample", typeid(*this).name());
+
     int totalSamples = 0;
     bool decEOF = false;
 
+    // Our buffers only ever hold whole frames.
+    dstLen -= dstLen % std::max(d->fChannels, 1);
+
     if (d->fPendingSpecChange) {
         // There's a spec change pending. Process any data that is still in our
         // buffers using the current spec.
-        totalSamples += d->fMoveFromOutBuffer(dst, dstLen);
-        relocateBuffer(d->fOutBuffer.get(), d->fOutBufferPos, d->fOutBufferEnd);
-        d->fResampleFromInBuffer();
+        totalSamples += d->fDrain(dst, dstLen);
         if (totalSamples >= dstLen) {
-            // There's still samples left in the output buffer, so don't change
-            // the spec yet.
-            return dstLen;
+            // There might still be samples left in our buffers, so don't
+            // change the spec yet.
+            return totalSamples;
         }
         // Our buffers are empty, so we can change to the new spec.
         setSpec(d->fDstRate, d->fChannels, d->fChunkSize);
@@ -215,44 +379,72 @@ auto Aulib::Resampler::resample(float dst[], int dstLen) -> int
     // Keep resampling until we either produce the requested amount of output
     // samples, or the decoder has no more samples to give us.
     while (totalSamples < dstLen and not decEOF) {
-        // If the input buffer is not filled, get some more samples from the
-        // decoder.
-        if (d->fInBufferEnd < d->fInBuffer.size()) {
+        if (d->fCanBypass()) {
             bool callAgain = false;
-            int decSamples = d->fDecoder->decode(d->fInBuffer.get() + d->fInBufferEnd,
-                                                 d->fInBuffer.size() - d->fInBufferEnd, callAgain);
-            // If the decoder indicated a spec change, process any data that is
-            // still in our buffers using the current spec.
+            int decSamples = d->fDecoder->decode(dst + totalSamples, dstLen - totalSamples,
+                                                 callAgain);
+            totalSamples += std::max(decSamples, 0);
+            // The samples we got are already in place, so a spec change can be applied right
+            // away. If the rates differ afterwards, we go back to resampling.
             if (callAgain) {
-                d->fInBufferEnd += decSamples;
-                d->fResampleFromInBuffer();
-                totalSamples += d->fMoveFromOutBuffer(dst + totalSamples, dstLen - totalSamples);
-                if (totalSamples >= dstLen) {
-                    // There's still samples left in the output buffer. Keep
-                    // the current spec and prepare to change it on our next
-                    // call.
-                    d->fPendingSpecChange = true;
-                    return dstLen;
-                }
                 setSpec(d->fDstRate, d->fChannels, d->fChunkSize);
             } else if (decSamples <= 0) {
                 decEOF = true;
-            } else {
-                d->fInBufferEnd += decSamples;
             }
+            continue;
         }
 
-        d->fResampleFromInBuffer();
-        relocateBuffer(d->fInBuffer.get(), d->fInBufferPos, d->fInBufferEnd);
-        totalSamples += d->fMoveFromOutBuffer(dst + totalSamples, dstLen - totalSamples);
-        relocateBuffer(d->fOutBuffer.get(), d->fOutBufferPos, d->fOutBufferEnd);
+        // Use up what we have first. That leaves the input buffer empty, so the decoder gets all
+        // of it in one piece.
+        totalSamples += d->fDrain(dst + totalSamples, dstLen - totalSamples);
+        if (totalSamples >= dstLen) {
+            break;
+        }
+
+        bool callAgain = false;
+        int decFrames = d->fDecodeIntoInBuffer(callAgain);
+        // If the decoder indicated a spec change, process any data that is
+        // still in our buffers using the current spec.
+        if (callAgain) {
+            d->fInBuffer.commit(std::max(decFrames, 0));
+            totalSamples += d->fDrain(dst + totalSamples, dstLen - totalSamples);
+            if (totalSamples >= dstLen) {
+                // There might still be samples left in our buffers. Keep
+                // the current spec and prepare to change it on our next
+                // call.
+                d->fPendingSpecChange = true;
+                return totalSamples;
+            }
+            setSpec(d->fDstRate, d->fChannels, d->fChunkSize);
+        } else if (decFrames <= 0) {
+            decEOF = true;
+        } else {
+            d->fInBuffer.commit(decFrames);
+        }
     }
     return totalSamples;
 }
 
+auto Aulib::Resampler::supportsPlanar() const -> bool
+{
+    return false;
+}
+
+auto Aulib::Resampler::isPlanar() const -> bool
+{
+    return d->fPlanar;
+}
+
+void Aulib::Resampler::doResamplingPlanar(float* const /*dst*/[], const float* const /*src*/[],
+                                          int& dstFrames, int& srcFrames)
+{
+    dstFrames = srcFrames = 0;
+}
+
 void Aulib::Resampler::discardPendingSamples()
 {
-    d->fOutBufferPos = d->fOutBufferEnd = d->fInBufferPos = d->fInBufferEnd = 0;
+    d->fOutBuffer.clear();
+    d->fInBuffer.clear();
     doDiscardPendingSamples();
 }
 
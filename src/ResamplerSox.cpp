@@ -51,10 +51,36 @@ void Aulib::ResamplerSox::doResampling(float dst[], const float src[], int& dstL
     srcLen = static_cast<int>(srcDone) * channels;
 }
 
+auto Aulib::ResamplerSox::supportsPlanar() const -> bool
+{
+    return true;
+}
+
+void Aulib::ResamplerSox::doResamplingPlanar(float* const dst[], const float* const src[],
+                                             int& dstFrames, int& srcFrames)
+{
+    if (not d->fResampler) {
+        dstFrames = srcFrames = 0;
+        return;
+    }
+    // With split channels, soxr takes arrays of channel pointers instead of sample pointers.
+    size_t dstDone, srcDone;
+    soxr_error_t error =
+        soxr_process(d->fResampler.get(), src, static_cast<size_t>(srcFrames), &srcDone,
+                     const_cast<float**>(dst), static_cast<size_t>(dstFrames), &dstDone);
+    if (error) {
+        aulib::log::warnLn("soxr_process() error: {}", error);
+        dstFrames = srcFrames = 0;
+        return;
+    }
+    dstFrames = static_cast<int>(dstDone);
+    srcFrames = static_cast<int>(srcDone);
+}
+
 auto Aulib::ResamplerSox::adjustForOutputSpec(int dstRate, int srcRate, int channels) -> int
 {
     soxr_io_spec_t io_spec{};
-    io_spec.itype = io_spec.otype = SOXR_FLOAT32_I;
+    io_spec.itype = io_spec.otype = isPlanar() ? SOXR_FLOAT32_S : SOXR_FLOAT32_I;
     io_spec.scale = 1.0;
 
     const int sox_quality = [&] {
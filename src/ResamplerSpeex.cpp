@@ -63,6 +63,32 @@ void Aulib::ResamplerSpeex::doResampling(float dst[], const float src[], int& ds
     srcLen = static_cast<int>(spxInLen) * channels;
 }
 
+auto Aulib::ResamplerSpeex::supportsPlanar() const -> bool
+{
+    return true;
+}
+
+void Aulib::ResamplerSpeex::doResamplingPlanar(float* const dst[], const float* const src[],
+                                               int& dstFrames, int& srcFrames)
+{
+    if (not d->fResampler or srcFrames == 0 or dstFrames == 0) {
+        dstFrames = srcFrames = 0;
+        return;
+    }
+
+    // All channels share the same filter state, so they consume and produce the same amounts.
+    auto spxInLen = static_cast<spx_uint32_t>(srcFrames);
+    auto spxOutLen = static_cast<spx_uint32_t>(dstFrames);
+    for (int chan = 0; chan < currentChannels(); ++chan) {
+        spxInLen = static_cast<spx_uint32_t>(srcFrames);
+        spxOutLen = static_cast<spx_uint32_t>(dstFrames);
+        speex_resampler_process_float(d->fResampler.get(), static_cast<spx_uint32_t>(chan),
+                                      src[chan], &spxInLen, dst[chan], &spxOutLen);
+    }
+    dstFrames = static_cast<int>(spxOutLen);
+    srcFrames = static_cast<int>(spxInLen);
+}
+
 auto Aulib::ResamplerSpeex::adjustForOutputSpec(int dstRate, int srcRate, int channels) -> int
 {
     int err;
@@ -0,0 +1,157 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "RwopsView.h"
+
+#include "missing.h"
+#include <SDL_error.h>
+#include <SDL_rwops.h>
+#include <SDL_version.h>
+#include <cstdio>
+
+#if SDL_VERSION_ATLEAST(2, 0, 0) and defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #define MAP_WIN32 1
+#elif SDL_VERSION_ATLEAST(2, 0, 0) and defined(HAVE_STDIO_H) \
+    and (defined(__unix__) or defined(__APPLE__))
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define MAP_POSIX 1
+#endif
+
+auto RwopsView::load(SDL_RWops* const rwops) -> std::unique_ptr<RwopsView>
+{
+    return fCreate(rwops, true);
+}
+
+auto RwopsView::map(SDL_RWops* const rwops) -> std::unique_ptr<RwopsView>
+{
+    return fCreate(rwops, false);
+}
+
+RwopsView::~RwopsView()
+{
+    if (not fMapping) {
+        return;
+    }
+#if MAP_WIN32
+    UnmapViewOfFile(fMapping);
+#elif MAP_POSIX
+    munmap(fMapping, fMappingSize);
+#endif
+}
+
+auto RwopsView::fCreate(SDL_RWops* const rwops, const bool allowCopy)
+    -> std::unique_ptr<RwopsView>
+{
+    if (not rwops) {
+        SDL_SetError("Cannot read from null rwops.");
+        return nullptr;
+    }
+    const Sint64 pos = SDL_RWtell(rwops);
+    const Sint64 end = SDL_RWsize(rwops);
+    if (pos < 0 or end < 0) {
+        SDL_SetError("Cannot determine the size of the rwops data.");
+        return nullptr;
+    }
+    if (end <= pos) {
+        SDL_SetError("The rwops has no data left to read.");
+        return nullptr;
+    }
+
+    std::unique_ptr<RwopsView> view(new RwopsView);
+    const auto len = static_cast<std::size_t>(end - pos);
+    bool inPlace = false;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+    if (rwops->type == SDL_RWOPS_MEMORY or rwops->type == SDL_RWOPS_MEMORY_RO) {
+        view->fData = rwops->hidden.mem.base + pos;
+        view->fSize = len;
+        inPlace = true;
+    }
+#endif
+    if (not inPlace and not view->fMapFile(rwops, pos)) {
+        if (not allowCopy) {
+            SDL_SetError("The rwops data can't be mapped into memory.");
+            return nullptr;
+        }
+        view->fCopy.reset(new Uint8[len]);
+        if (SDL_RWread(rwops, view->fCopy.get(), len, 1) != 1) {
+            SDL_SetError("Failed to read rwops data.");
+            return nullptr;
+        }
+        view->fData = view->fCopy.get();
+        view->fSize = len;
+    }
+    SDL_RWseek(rwops, 0, RW_SEEK_END);
+    return view;
+}
+
+auto RwopsView::fMapFile([[maybe_unused]] SDL_RWops* const rwops, [[maybe_unused]] const Sint64 pos)
+    -> bool
+{
+#if MAP_WIN32
+    if (rwops->type != SDL_RWOPS_WINFILE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (not GetFileSizeEx(rwops->hidden.windowsio.h, &fileSize) or fileSize.QuadPart <= pos) {
+        return false;
+    }
+    HANDLE mappingHandle =
+        CreateFileMapping(rwops->hidden.windowsio.h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (not mappingHandle) {
+        return false;
+    }
+    // The view keeps the mapping object alive.
+    fMapping = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mappingHandle);
+    if (not fMapping) {
+        return false;
+    }
+    fMappingSize = static_cast<std::size_t>(fileSize.QuadPart);
+    fData = static_cast<const Uint8*>(fMapping) + pos;
+    fSize = fMappingSize - static_cast<std::size_t>(pos);
+    return true;
+#elif MAP_POSIX
+    if (rwops->type != SDL_RWOPS_STDFILE) {
+        return false;
+    }
+    const int fd = fileno(rwops->hidden.stdio.fp);
+    struct stat st;
+    if (fd < 0 or fstat(fd, &st) != 0 or not S_ISREG(st.st_mode) or st.st_size <= pos) {
+        return false;
+    }
+    // The mapping stays valid after the file is closed.
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    fMapping = mapping;
+    fMappingSize = static_cast<std::size_t>(st.st_size);
+    fData = static_cast<const Uint8*>(fMapping) + pos;
+    fSize = fMappingSize - static_cast<std::size_t>(pos);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,78 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include <SDL_stdinc.h>
+#include <cstddef>
+#include <memory>
+
+struct SDL_RWops;
+
+/*
+ * Read-only view of an SDL_RWops, from its current position to its end.
+ *
+ * RWops created with SDL_RWFromMem() or SDL_RWFromConstMem() are viewed in place, and RWops created
+ * with SDL_RWFromFile() are memory-mapped, so neither needs a copy. Anything else is read into a
+ * buffer by load() and rejected by map(). Either way, the RWops ends up positioned at its end.
+ *
+ * Mapped files and buffers stay valid after the RWops is closed. Views of memory RWops point to
+ * the application's memory and are only valid as long as that memory is.
+ */
+class RwopsView final
+{
+public:
+    // Views the data without copying it if possible, and reads it otherwise.
+    static auto load(SDL_RWops* rwops) -> std::unique_ptr<RwopsView>;
+
+    // Only succeeds if the data can be viewed without copying it.
+    static auto map(SDL_RWops* rwops) -> std::unique_ptr<RwopsView>;
+
+    ~RwopsView();
+
+    RwopsView(const RwopsView&) = delete;
+    auto operator=(const RwopsView&) -> RwopsView& = delete;
+
+    auto data() const noexcept -> const Uint8*
+    {
+        return fData;
+    }
+
+    auto size() const noexcept -> std::size_t
+    {
+        return fSize;
+    }
+
+private:
+    RwopsView() = default;
+
+    const Uint8* fData = nullptr;
+    std::size_t fSize = 0;
+    // Start and length of the file mapping, if any. The view can start past the start of the
+    // mapping, since mappings need to start at a page boundary.
+    void* fMapping = nullptr;
+    std::size_t fMappingSize = 0;
+    std::unique_ptr<Uint8[]> fCopy;
+
+    static auto fCreate(SDL_RWops* rwops, bool allowCopy) -> std::unique_ptr<RwopsView>;
+    auto fMapFile(SDL_RWops* rwops, Sint64 pos) -> bool;
+};
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
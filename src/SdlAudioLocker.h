@@ -5,13 +5,20 @@
 #include <SDL_audio.h>
 
 /*
- * RAII wrapper for SDL_LockAudio().
+ * RAII wrapper for SDL_LockAudio(). When rendering without an audio device, this locks the render
+ * mutex instead.
  */
 class SdlAudioLocker final
 {
 public:
     SdlAudioLocker()
+        : fOffline(Aulib::Stream_priv::fOffline)
     {
+        if (fOffline) {
+            Aulib::Stream_priv::fRenderMutex.lock();
+            fIsLocked = true;
+            return;
+        }
 #if SDL_VERSION_ATLEAST(2, 0, 0)
         SDL_LockAudioDevice(Aulib::Stream_priv::fDeviceId);
 #else
@@ -30,18 +37,24 @@ public:
 
     void unlock()
     {
-        if (fIsLocked) {
+        if (not fIsLocked) {
+            return;
+        }
+        if (fOffline) {
+            Aulib::Stream_priv::fRenderMutex.unlock();
+        } else {
 #if SDL_VERSION_ATLEAST(2, 0, 0)
             SDL_UnlockAudioDevice(Aulib::Stream_priv::fDeviceId);
 #else
             SDL_UnlockAudio();
 #endif
-            fIsLocked = false;
         }
+        fIsLocked = false;
     }
 
 private:
     bool fIsLocked;
+    const bool fOffline;
 };
 
 /*
@@ -1,6 +1,7 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "SdlMutex.h"
 #include "missing.h"
+#include "rtcheck.h"
 #include <stdexcept>
 
 SdlMutex::SdlMutex()
@@ -12,6 +13,7 @@ SdlMutex::SdlMutex()
 
 void SdlMutex::lock()
 {
+    AM_rtViolation("mutex lock");
     if (SDL_LockMutex(mutex_) != 0) {
         Aulib::priv::throw_(std::runtime_error(SDL_GetError()));
     }
@@ -0,0 +1,179 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "Buffer.h"
+#include "aulib_debug.h"
+#include <SDL_stdinc.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+/*
+ * Lock-free single-producer, single-consumer ring buffer.
+ *
+ * One thread may write into the ring while another thread reads from it, without any locking.
+ * reset() and clear() are not thread-safe; the caller must make sure that neither the producer nor
+ * the consumer are accessing the ring while they run.
+ *
+ * The read and write counters never wrap around (they're 64-bit), so they can also be used as
+ * absolute positions in the stream of elements that went through the ring.
+ */
+template <typename T>
+class SpscRing final
+{
+public:
+    explicit SpscRing(const int capacity)
+        : fData(capacity)
+    {}
+
+    SpscRing(const SpscRing&) = delete;
+    auto operator=(const SpscRing&) -> SpscRing& = delete;
+
+    auto capacity() const noexcept -> int
+    {
+        return fData.size();
+    }
+
+    void reset(const int newCapacity)
+    {
+        fData.reset(newCapacity);
+        clear();
+    }
+
+    void clear() noexcept
+    {
+        fReadCount.store(0, std::memory_order_relaxed);
+        fWriteCount.store(0, std::memory_order_release);
+    }
+
+    // Amount of elements currently in the ring. Can be called from either side.
+    auto size() const noexcept -> int
+    {
+        return static_cast<int>(fWriteCount.load(std::memory_order_acquire)
+                                - fReadCount.load(std::memory_order_acquire));
+    }
+
+    auto empty() const noexcept -> bool
+    {
+        return size() == 0;
+    }
+
+    /*
+     * Consumer side.
+     */
+
+    // Total amount of elements read so far.
+    auto readCount() const noexcept -> Uint64
+    {
+        return fReadCount.load(std::memory_order_relaxed);
+    }
+
+    auto front() const noexcept -> const T&
+    {
+        AM_debugAssert(not empty());
+        return fData[offsetOf(fReadCount.load(std::memory_order_relaxed))];
+    }
+
+    void pop() noexcept
+    {
+        AM_debugAssert(not empty());
+        fReadCount.store(fReadCount.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_release);
+    }
+
+    // Move at most 'len' elements out of the ring into 'dst'. Returns the amount of elements that
+    // were actually moved.
+    auto read(T dst[], const int len) noexcept -> int
+    {
+        const Uint64 readPos = fReadCount.load(std::memory_order_relaxed);
+        const int avail = static_cast<int>(fWriteCount.load(std::memory_order_acquire) - readPos);
+        const int total = std::min(avail, len);
+        if (total <= 0) {
+            return 0;
+        }
+        const int offset = offsetOf(readPos);
+        const int firstLen = std::min(total, capacity() - offset);
+
+        std::memcpy(dst, fData.get() + offset, sizeof(T) * firstLen);
+        std::memcpy(dst + firstLen, fData.get(), sizeof(T) * (total - firstLen));
+        fReadCount.store(readPos + total, std::memory_order_release);
+        return total;
+    }
+
+    /*
+     * Producer side.
+     */
+
+    // Total amount of elements written so far.
+    auto writeCount() const noexcept -> Uint64
+    {
+        return fWriteCount.load(std::memory_order_relaxed);
+    }
+
+    auto writeAvailable() const noexcept -> int
+    {
+        return capacity() - size();
+    }
+
+    // Returns a pointer to the largest contiguous free region in the ring and stores its size in
+    // 'len'. Nothing is considered written until commitWrite() is called.
+    auto writeRegion(int& len) noexcept -> T*
+    {
+        if (capacity() == 0) {
+            len = 0;
+            return fData.get();
+        }
+        const Uint64 writePos = fWriteCount.load(std::memory_order_relaxed);
+        const int offset = offsetOf(writePos);
+        len = std::min(writeAvailable(), capacity() - offset);
+        return fData.get() + offset;
+    }
+
+    void commitWrite(const int len) noexcept
+    {
+        AM_debugAssert(len >= 0 and len <= writeAvailable());
+        fWriteCount.store(fWriteCount.load(std::memory_order_relaxed) + len,
+                          std::memory_order_release);
+    }
+
+    auto push(const T& value) noexcept -> bool
+    {
+        if (writeAvailable() < 1) {
+            return false;
+        }
+        fData[offsetOf(fWriteCount.load(std::memory_order_relaxed))] = value;
+        commitWrite(1);
+        return true;
+    }
+
+private:
+    Buffer<T> fData;
+    alignas(64) std::atomic<Uint64> fReadCount{0};
+    alignas(64) std::atomic<Uint64> fWriteCount{0};
+
+    auto offsetOf(const Uint64 pos) const noexcept -> int
+    {
+        return static_cast<int>(pos % static_cast<Uint64>(capacity()));
+    }
+};
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
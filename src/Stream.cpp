@@ -1,18 +1,22 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "Aulib/Stream.h"
 
+#include "Aulib/Bus.h"
 #include "Aulib/Decoder.h"
 #include "Aulib/Processor.h"
 #include "Aulib/Resampler.h"
+#include "Aulib/ResamplerSpeex.h"
+#include "DecoderPcm.h"
 #include "SdlAudioLocker.h"
 #include "aulib.h"
 #include "aulib_global.h"
 #include "aulib_log.h"
+#include "bus_p.h"
 #include "missing/algorithm.h"
 #include "sampleconv.h"
 #include "stream_p.h"
+#include "trace.h"
 #include <SDL_audio.h>
-#include <SDL_timer.h>
 #include <mutex>
 
 Aulib::Stream::Stream(const std::string& filename, std::unique_ptr<Decoder> decoder,
@@ -42,11 +46,33 @@ Aulib::Stream::Stream(SDL_RWops* rwops, std::unique_ptr<Decoder> decoder, bool c
     : d(std::make_unique<Stream_priv>(this, std::move(decoder), nullptr, rwops, closeRw))
 {}
 
+Aulib::Stream::Stream(ProbedDecoder probed, std::unique_ptr<Resampler> resampler)
+    : Stream(probed.rwops, std::move(probed.decoder), std::move(resampler), probed.closeRw)
+{
+    probed.closeRw = false;
+}
+
+Aulib::Stream::Stream(ProbedDecoder probed)
+    : Stream(std::move(probed), nullptr)
+{}
+
+Aulib::Stream::Stream(std::shared_ptr<const PcmBuffer> pcm)
+    : d(std::make_unique<Stream_priv>(this, pcm ? std::make_unique<DecoderPcm>(pcm) : nullptr,
+                                      nullptr, nullptr, false))
+{
+    d->fPcmDecoder = static_cast<DecoderPcm*>(d->fDecoder.get());
+}
+
 Aulib::Stream::~Stream()
 {
-    SdlAudioLocker lock;
+    {
+        SdlAudioLocker lock;
 
-    d->fStop();
+        d->fStop();
+        // Commands that are still queued for this stream are skipped once its slot is freed.
+        d->fDiscardBatchedCommands();
+    }
+    d->fEndDecodeAhead();
 }
 
 auto Aulib::Stream::open() -> bool
@@ -56,16 +82,41 @@ auto Aulib::Stream::open() -> bool
     if (d->fIsOpen) {
         return true;
     }
-    if (not d->fRWops) {
+    if (not d->fRWops and not d->fPcmDecoder) {
         SDL_SetError("Cannot open stream: null rwops.");
         return false;
     }
+    if (not d->fDecoder) {
+        SDL_SetError("Cannot open stream: null decoder.");
+        return false;
+    }
     if (not d->fDecoder->open(d->fRWops)) {
         return false;
     }
+    // Decoded sounds are normally already at the output rate, unless they were decoded before the
+    // library was initialized again with a different rate.
+    if (d->fPcmDecoder and not d->fResampler
+        and d->fPcmDecoder->getRate() != Aulib::sampleRate()) {
+        d->fResampler = std::make_unique<ResamplerSpeex>();
+        d->fResampler->setDecoder(d->fDecoder);
+    }
+    if (d->fDecoder->getChannels() > MAX_CHANNELS) {
+        SDL_SetError("Cannot open stream: more than %d channels.", MAX_CHANNELS);
+        return false;
+    }
+    // Sources with more channels than the device are downmixed by the decoder, so that less of
+    // them need to be resampled. The others are converted to the device's layout when mixed.
+    d->fChannels = std::min(d->fDecoder->getChannels(), Aulib::channelCount());
+    d->fLayout = layoutMatrix(d->fChannels, Aulib::channelCount());
+    d->fDecoder->setOutputChannels(d->fChannels);
     if (d->fResampler) {
-        d->fResampler->setSpec(Aulib::sampleRate(), Aulib::channelCount(), Aulib::frameSize());
+        d->fResampler->setSpec(Aulib::sampleRate(), d->fChannels, Aulib::frameSize());
     }
+    d->fDurationFrames = d->fDecoder->duration().count() * Aulib::sampleRate() / 1000000;
+    d->fPosFrames = 0;
+    Stream_priv::fVoices.channels[d->fSlot] = d->fChannels;
+    Stream_priv::fVoices.resampler[d->fSlot] = d->fResampler.get();
+    Stream_priv::fVoices.pcmDecoder[d->fSlot] = d->fPcmDecoder;
     d->fIsOpen = true;
     return true;
 }
@@ -76,29 +127,43 @@ auto Aulib::Stream::play(int iterations, std::chrono::microseconds fadeTime) ->
         return false;
     }
 
+    if (isPlaying()) {
+        return true;
+    }
+
+    // Prepare the decoder without holding the audio lock, since this might need to decode. There's
+    // no deadline to meet when rendering offline, so decode-ahead isn't used there.
+    const bool useDecodeAhead = d->fDecodeAheadFrames > 0 and not Stream_priv::fOffline;
+    if (useDecodeAhead) {
+        d->fStartDecodeAhead(iterations);
+    } else {
+        d->fEndDecodeAhead();
+    }
+
     SdlAudioLocker locker;
 
     if (d->fIsPlaying) {
         return true;
     }
-    d->fCurrentIteration = 0;
-    d->fWantedIterations = iterations;
-    d->fPlaybackStartTick = SDL_GetTicks();
-    d->fStarting = true;
+    auto& voices = Stream_priv::fVoices;
+    const int slot = d->fSlot;
+    voices.decodeAhead[slot] = useDecodeAhead;
+    voices.iteration[slot] = 0;
+    voices.wantedIterations[slot] = iterations;
+    voices.startFrame[slot] = Stream_priv::fNowFrame();
+    voices.starting[slot] = true;
+    voices.resetLastGain(slot);
+    d->fIsVirtual = false;
     if (fadeTime.count() > 0) {
         d->fInternalVolume = 0.f;
-        d->fFadingIn = true;
-        d->fFadingOut = false;
-        d->fFadeInDuration = std::chrono::duration_cast<std::chrono::milliseconds>(fadeTime);
-        d->fFadeInStartTick = d->fPlaybackStartTick;
+        d->fStartFade(true, fadeTime);
     } else {
         d->fInternalVolume = 1.f;
         d->fFadingIn = false;
     }
     d->fIsPlaying = true;
-    {
-        std::lock_guard<SdlMutex> lock(d->fStreamListMutex);
-        d->fStreamList.push_back(this);
+    if (not d->fIsPaused) {
+        voices.activate(slot);
     }
     return true;
 }
@@ -108,10 +173,7 @@ void Aulib::Stream::stop(std::chrono::microseconds fadeTime)
     SdlAudioLocker lock;
 
     if (fadeTime.count() > 0) {
-        d->fFadingIn = false;
-        d->fFadingOut = true;
-        d->fFadeOutDuration = std::chrono::duration_cast<std::chrono::milliseconds>(fadeTime);
-        d->fFadeOutStartTick = SDL_GetTicks();
+        d->fStartFade(false, fadeTime);
         d->fStopAfterFade = true;
     } else {
         d->fStop();
@@ -130,13 +192,11 @@ void Aulib::Stream::pause(std::chrono::microseconds fadeTime)
         return;
     }
     if (fadeTime.count() > 0) {
-        d->fFadingIn = false;
-        d->fFadingOut = true;
-        d->fFadeOutDuration = std::chrono::duration_cast<std::chrono::milliseconds>(fadeTime);
-        d->fFadeOutStartTick = SDL_GetTicks();
+        d->fStartFade(false, fadeTime);
         d->fStopAfterFade = false;
     } else {
-        d->fIsPaused = true;
+        d->fSetPaused(true);
+        Stream_priv::fVoices.deactivate(d->fSlot);
     }
 }
 
@@ -149,14 +209,17 @@ void Aulib::Stream::resume(std::chrono::microseconds fadeTime)
     }
     if (fadeTime.count() > 0) {
         d->fInternalVolume = 0.f;
-        d->fFadingIn = true;
-        d->fFadingOut = false;
-        d->fFadeInDuration = std::chrono::duration_cast<std::chrono::milliseconds>(fadeTime);
-        d->fFadeInStartTick = SDL_GetTicks();
+        d->fStartFade(true, fadeTime);
     } else {
         d->fInternalVolume = 1.f;
+        d->fFadingIn = false;
+        d->fFadingOut = false;
+    }
+    Stream_priv::fVoices.resetLastGain(d->fSlot);
+    d->fSetPaused(false);
+    if (d->fIsPlaying) {
+        Stream_priv::fVoices.activate(d->fSlot);
     }
-    d->fIsPaused = false;
 }
 
 auto Aulib::Stream::rewind() -> bool
@@ -166,87 +229,128 @@ auto Aulib::Stream::rewind() -> bool
     }
 
     SdlAudioLocker locker;
-    return d->fDecoder->rewind();
+
+    d->fPosFrames = 0;
+    d->fNeedsSeek = false;
+    if (not Stream_priv::fVoices.decodeAhead[d->fSlot]) {
+        return d->fDecoder->rewind();
+    }
+    std::lock_guard<SdlMutex> lock(d->fDecodeMutex);
+    const bool ret = d->fDecoder->rewind();
+    d->fFlushDecodeAhead();
+    return ret;
 }
 
 void Aulib::Stream::setVolume(float volume)
 {
-    SdlAudioLocker locker;
-
     if (volume < 0.f) {
         volume = 0.f;
     }
-    d->fVolume = volume;
+    d->fTargetVolume = volume;
+    d->fPostCommand(Stream_priv::Command::Type::Volume, volume);
 }
 
 auto Aulib::Stream::volume() const -> float
 {
-    SdlAudioLocker locker;
-
-    return d->fVolume;
+    return d->fTargetVolume;
 }
 
 void Aulib::Stream::setStereoPosition(const float position)
 {
-    SdlAudioLocker locker;
-
-    d->fStereoPos = Aulib::priv::clamp(position, -1.f, 1.f);
+    const float clamped = Aulib::priv::clamp(position, -1.f, 1.f);
+    d->fTargetStereoPos = clamped;
+    d->fPostCommand(Stream_priv::Command::Type::StereoPos, clamped);
 }
 
 auto Aulib::Stream::getStereoPosition() const -> float
 {
-    SdlAudioLocker locker;
-
-    return d->fStereoPos;
+    return d->fTargetStereoPos;
 }
 
 void Aulib::Stream::mute()
 {
-    SdlAudioLocker locker;
-
-    d->fIsMuted = true;
+    d->fTargetMuted = true;
+    d->fPostCommand(Stream_priv::Command::Type::Mute, 1.f);
 }
 
 void Aulib::Stream::unmute()
 {
-    SdlAudioLocker locker;
-
-    d->fIsMuted = false;
+    d->fTargetMuted = false;
+    d->fPostCommand(Stream_priv::Command::Type::Mute, 0.f);
 }
 
 auto Aulib::Stream::isMuted() const -> bool
 {
-    SdlAudioLocker locker;
-
-    return d->fIsMuted;
+    return d->fTargetMuted;
 }
 
 auto Aulib::Stream::isPlaying() const -> bool
 {
-    SdlAudioLocker locker;
-
     return d->fIsPlaying;
 }
 
 auto Aulib::Stream::isPaused() const -> bool
 {
-    SdlAudioLocker locker;
-
     return d->fIsPaused;
 }
 
+void Aulib::Stream::beginBatch()
+{
+    Stream_priv::fBeginBatch();
+}
+
+void Aulib::Stream::endBatch()
+{
+    Stream_priv::fEndBatch();
+}
+
 auto Aulib::Stream::duration() const -> std::chrono::microseconds
 {
     SdlAudioLocker locker;
 
+    if (not Stream_priv::fVoices.decodeAhead[d->fSlot]) {
+        return d->fDecoder->duration();
+    }
+    std::lock_guard<SdlMutex> lock(d->fDecodeMutex);
     return d->fDecoder->duration();
 }
 
 auto Aulib::Stream::seekToTime(std::chrono::microseconds pos) -> bool
+{
+    SdlAudioLocker locker;
+    AM_traceScope("seek", typeid(*d->fDecoder).name());
+
+    if (not Stream_priv::fVoices.decodeAhead[d->fSlot]) {
+        if (not d->fDecoder->seekToTime(pos)) {
+            return false;
+        }
+        d->fPosFrames = pos.count() * Aulib::sampleRate() / 1000000;
+        d->fNeedsSeek = false;
+        return true;
+    }
+    std::lock_guard<SdlMutex> lock(d->fDecodeMutex);
+    const bool ret = d->fDecoder->seekToTime(pos);
+    d->fFlushDecodeAhead();
+    return ret;
+}
+
+void Aulib::Stream::setDecodeAhead(const int frames)
 {
     SdlAudioLocker locker;
 
-    return d->fDecoder->seekToTime(pos);
+    d->fDecodeAheadFrames = std::max(0, frames);
+}
+
+auto Aulib::Stream::decodeAhead() const -> int
+{
+    SdlAudioLocker locker;
+
+    return d->fDecodeAheadFrames;
+}
+
+auto Aulib::Stream::underrunCount() const -> int
+{
+    return d->fUnderruns;
 }
 
 void Aulib::Stream::setFinishCallback(Callback func)
@@ -311,6 +415,50 @@ void Aulib::Stream::clearProcessors()
     d->processors.clear();
 }
 
+void Aulib::Stream::setPriority(const int priority)
+{
+    d->fTargetPriority = priority;
+    d->fPostCommand(Stream_priv::Command::Type::Priority, priority);
+}
+
+auto Aulib::Stream::priority() const -> int
+{
+    return d->fTargetPriority;
+}
+
+auto Aulib::Stream::isVirtual() const -> bool
+{
+    return d->fIsPlaying and d->fIsVirtual;
+}
+
+void Aulib::Stream::setBus(Bus* const bus)
+{
+    d->fTargetBus = bus;
+    Stream_priv::Command::BusRef ref{-1, 0};
+    if (bus) {
+        ref = {bus->d->fSlot, bus->d->fGeneration};
+    }
+    d->fPostCommand(Stream_priv::Command::Type::Bus, ref);
+}
+
+auto Aulib::Stream::bus() const -> Bus*
+{
+    return d->fTargetBus;
+}
+
+auto Aulib::Stream::mixStats() const -> StreamStats
+{
+    StreamStats stats;
+#if ENABLE_MIXER_STATS
+    stats.decodeTime = std::chrono::nanoseconds(d->fStats.decodeNs.load(std::memory_order_relaxed));
+    stats.resampleTime =
+        std::chrono::nanoseconds(d->fStats.resampleNs.load(std::memory_order_relaxed));
+    stats.processorTime =
+        std::chrono::nanoseconds(d->fStats.processorNs.load(std::memory_order_relaxed));
+#endif
+    return stats;
+}
+
 void Aulib::Stream::invokeFinishCallback()
 {
     if (d->fFinishCallback) {
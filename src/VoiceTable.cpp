@@ -0,0 +1,115 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "VoiceTable.h"
+
+#include "aulib_debug.h"
+#include <algorithm>
+
+auto Aulib::VoiceTable::add(Stream* const strm) -> int
+{
+    if (fFreeSlots.empty()) {
+        // Grow by doubling, and make sure the lists that refer to slots never need to allocate.
+        const int oldCapacity = capacity();
+        const int newCapacity = std::max(64, oldCapacity * 2);
+        stream.resize(newCapacity, nullptr);
+        generation.resize(newCapacity, 0);
+        volume.resize(newCapacity);
+        stereoPos.resize(newCapacity);
+        muted.resize(newCapacity);
+        bus.resize(newCapacity);
+        priority.resize(newCapacity);
+        audibility.resize(newCapacity);
+        isVirtual.resize(newCapacity);
+        iteration.resize(newCapacity);
+        wantedIterations.resize(newCapacity);
+        paused.resize(newCapacity);
+        startFrame.resize(newCapacity);
+        starting.resize(newCapacity);
+        channels.resize(newCapacity);
+        decodeAhead.resize(newCapacity);
+        resampler.resize(newCapacity);
+        pcmDecoder.resize(newCapacity);
+        lastGainLeft.resize(newCapacity);
+        lastGainRight.resize(newCapacity);
+        fActivePos.resize(newCapacity, -1);
+        fActive.reserve(newCapacity);
+        fFreeSlots.reserve(newCapacity);
+        for (int slot = newCapacity - 1; slot >= oldCapacity; --slot) {
+            fFreeSlots.push_back(slot);
+        }
+    }
+
+    const int slot = fFreeSlots.back();
+    fFreeSlots.pop_back();
+    stream[slot] = strm;
+    volume[slot] = 1.f;
+    stereoPos[slot] = 0.f;
+    muted[slot] = false;
+    bus[slot] = -1;
+    priority[slot] = 0;
+    audibility[slot] = 0.f;
+    isVirtual[slot] = false;
+    iteration[slot] = 0;
+    wantedIterations[slot] = 0;
+    paused[slot] = false;
+    startFrame[slot] = 0;
+    starting[slot] = false;
+    channels[slot] = 0;
+    decodeAhead[slot] = false;
+    resampler[slot] = nullptr;
+    pcmDecoder[slot] = nullptr;
+    resetLastGain(slot);
+    return slot;
+}
+
+void Aulib::VoiceTable::remove(const int slot) noexcept
+{
+    AM_debugAssert(stream[slot]);
+    deactivate(slot);
+    stream[slot] = nullptr;
+    ++generation[slot];
+    fFreeSlots.push_back(slot);
+}
+
+void Aulib::VoiceTable::activate(const int slot) noexcept
+{
+    if (fActivePos[slot] >= 0) {
+        return;
+    }
+    fActivePos[slot] = static_cast<int>(fActive.size());
+    fActive.push_back(slot);
+}
+
+void Aulib::VoiceTable::deactivate(const int slot) noexcept
+{
+    const int pos = fActivePos[slot];
+    if (pos < 0) {
+        return;
+    }
+    // Move the last active slot into the hole.
+    const int last = fActive.back();
+    fActive[pos] = last;
+    fActivePos[last] = pos;
+    fActive.pop_back();
+    fActivePos[slot] = -1;
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,116 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_global.h"
+#include <SDL_stdinc.h>
+#include <vector>
+
+namespace Aulib {
+
+class DecoderPcm;
+class Resampler;
+class Stream;
+
+/*
+ * Table of all existing streams, laid out as a structure of arrays so that the state the mixer
+ * needs for every stream on every block is packed together. A stream is identified by its slot,
+ * which stays the same for as long as the stream exists. Playing streams are additionally kept in
+ * a dense list of active slots, which is what the mixer iterates over.
+ *
+ * Only add() allocates. Everything else is O(1) and allocation-free, so it can be used from the
+ * audio callback. The table must only be accessed with the SDL audio device locked or from the
+ * audio callback.
+ */
+class AULIB_NO_EXPORT VoiceTable final
+{
+public:
+    // Per-slot state.
+    std::vector<Stream*> stream;
+    // Incremented whenever a slot is freed, so that things referring to a deleted stream can be
+    // told apart from ones referring to the stream that took over its slot.
+    std::vector<Uint32> generation;
+    std::vector<float> volume;
+    std::vector<float> stereoPos;
+    std::vector<Uint8> muted;
+    // Slot of the bus the stream is routed to, or -1 for the master output.
+    std::vector<int> bus;
+    // Higher priority streams are preferred when the amount of real voices is limited.
+    std::vector<int> priority;
+    // How loud the stream is going to be in the current block, and whether it's virtual, meaning
+    // that it's not decoded or mixed. Updated at the start of every block for active slots.
+    std::vector<float> audibility;
+    std::vector<Uint8> isVirtual;
+    // Playback state the mixer needs for every active stream on every block, so that it only has
+    // to go through the stream itself for the ones that are actually decoded. The stream owns its
+    // resampler and decoder.
+    std::vector<int> iteration;
+    // 0 means loop forever.
+    std::vector<int> wantedIterations;
+    std::vector<Uint8> paused;
+    // Position of the sample clock at which playback starts, and whether the stream hasn't been
+    // mixed since.
+    std::vector<Uint64> startFrame;
+    std::vector<Uint8> starting;
+    std::vector<int> channels;
+    // Whether the current playback uses decode-ahead. Only changes while not playing.
+    std::vector<Uint8> decodeAhead;
+    std::vector<Resampler*> resampler;
+    std::vector<DecoderPcm*> pcmDecoder;
+    // Gains used for the last mixed block, or 0 if the stream was virtual. Negative if there was no
+    // previous block.
+    std::vector<float> lastGainLeft;
+    std::vector<float> lastGainRight;
+
+    // Returns the slot of the new stream.
+    auto add(Stream* strm) -> int;
+    void remove(int slot) noexcept;
+
+    // Adds the slot to, or removes it from, the active list. Doing so twice is harmless.
+    void activate(int slot) noexcept;
+    void deactivate(int slot) noexcept;
+
+    // Makes the next block start without a gain ramp.
+    void resetLastGain(const int slot) noexcept
+    {
+        lastGainLeft[slot] = lastGainRight[slot] = -1.f;
+    }
+
+    auto capacity() const noexcept -> int
+    {
+        return static_cast<int>(stream.size());
+    }
+
+    auto activeSlots() const noexcept -> const std::vector<int>&
+    {
+        return fActive;
+    }
+
+private:
+    std::vector<int> fActive;
+    // Index of each slot in fActive, or -1 if it's not active.
+    std::vector<int> fActivePos;
+    std::vector<int> fFreeSlots;
+};
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -1,9 +1,16 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "aulib.h"
 
+#include "Aulib/PcmCache.h"
 #include "Aulib/Stream.h"
+#include "DecodePool.h"
+#include "MixPool.h"
+#include "SdlAudioLocker.h"
 #include "aulib_log.h"
 #include "missing.h"
+#include "mixkernels.h"
+#include "mixstats.h"
+#include "rtcheck.h"
 #include "sampleconv.h"
 #include "stream_p.h"
 #include <SDL.h>
@@ -18,6 +25,7 @@ enum class InitType
 };
 
 static InitType gInitType = InitType::None;
+static int gMixThreadCount = 1;
 
 extern "C" {
 static void sdlCallback(void* /*unused*/, Uint8 out[], int outLen)
@@ -38,8 +46,11 @@ auto Aulib::init(int freq, AudioFormat format, int channels, int frameSize,
         return false;
     }
 
-    // We only support mono and stereo at this point.
-    channels = std::min(std::max(1, channels), 2);
+#if ENABLE_RT_CHECKS
+    RtCheck::install();
+#endif
+
+    channels = std::min(std::max(1, channels), MAX_CHANNELS);
 
     SDL_AudioSpec requestedSpec{};
     requestedSpec.freq = freq;
@@ -66,47 +77,46 @@ auto Aulib::init(int freq, AudioFormat format, int channels, int frameSize,
     }
 #endif
 
-    aulib::log::debug("SDL initialized with sample format: ");
     switch (Stream_priv::fAudioSpec.format) {
     case AUDIO_S8:
-        aulib::log::debugLn("S8");
+        aulib::log::debugLn("SDL initialized with sample format: S8");
         Stream_priv::fSampleConverter = Aulib::floatToS8;
         break;
     case AUDIO_U8:
-        aulib::log::debugLn("U8");
+        aulib::log::debugLn("SDL initialized with sample format: U8");
         Stream_priv::fSampleConverter = Aulib::floatToU8;
         break;
     case AUDIO_S16LSB:
-        aulib::log::debugLn("S16LSB");
+        aulib::log::debugLn("SDL initialized with sample format: S16LSB");
         Stream_priv::fSampleConverter = Aulib::floatToS16LSB;
         break;
     case AUDIO_U16LSB:
-        aulib::log::debugLn("U16LSB");
+        aulib::log::debugLn("SDL initialized with sample format: U16LSB");
         Stream_priv::fSampleConverter = Aulib::floatToU16LSB;
         break;
     case AUDIO_S16MSB:
-        aulib::log::debugLn("S16MSB");
+        aulib::log::debugLn("SDL initialized with sample format: S16MSB");
         Stream_priv::fSampleConverter = Aulib::floatToS16MSB;
         break;
     case AUDIO_U16MSB:
-        aulib::log::debugLn("U16MSB");
+        aulib::log::debugLn("SDL initialized with sample format: U16MSB");
         Stream_priv::fSampleConverter = Aulib::floatToU16MSB;
         break;
 #if SDL_VERSION_ATLEAST(2, 0, 0)
     case AUDIO_S32LSB:
-        aulib::log::debugLn("S32LSB");
+        aulib::log::debugLn("SDL initialized with sample format: S32LSB");
         Stream_priv::fSampleConverter = Aulib::floatToS32LSB;
         break;
     case AUDIO_S32MSB:
-        aulib::log::debugLn("S32MSB");
+        aulib::log::debugLn("SDL initialized with sample format: S32MSB");
         Stream_priv::fSampleConverter = Aulib::floatToS32MSB;
         break;
     case AUDIO_F32LSB:
-        aulib::log::debugLn("F32LSB");
+        aulib::log::debugLn("SDL initialized with sample format: F32LSB");
         Stream_priv::fSampleConverter = Aulib::floatToFloatLSB;
         break;
     case AUDIO_F32MSB:
-        aulib::log::debugLn("F32MSB");
+        aulib::log::debugLn("SDL initialized with sample format: F32MSB");
         Stream_priv::fSampleConverter = Aulib::floatToFloatMSB;
         break;
 #endif
@@ -115,6 +125,18 @@ auto Aulib::init(int freq, AudioFormat format, int channels, int frameSize,
         Aulib::quit();
         return false;
     }
+    if (const auto simdConverter = simdSampleConverterFor(Stream_priv::fAudioSpec.format)) {
+        aulib::log::debugLn("Using vectorized sample converter.");
+        Stream_priv::fSampleConverter = simdConverter;
+    }
+
+    initMixKernels();
+    MixPool::setThreadCount(gMixThreadCount);
+    Stream_priv::fSetMixLaneCount(MixPool::threadCount());
+    aulib::log::startThread();
+#if ENABLE_MIXER_STATS
+    MixStats::restart();
+#endif
 
 #if SDL_VERSION_ATLEAST(2, 0, 0)
     SDL_PauseAudioDevice(Stream_priv::fDeviceId, false);
@@ -135,24 +157,65 @@ auto Aulib::initWithoutOutput(const int freq, const int channels) -> bool
 
     Stream_priv::fAudioSpec.freq = freq;
     Stream_priv::fAudioSpec.channels = channels;
+    Stream_priv::fAudioSpec.format = AUDIO_F32SYS;
+    Stream_priv::fAudioSpec.samples = 1024;
+    Stream_priv::fOffline = true;
+
+    initMixKernels();
+    MixPool::setThreadCount(gMixThreadCount);
+    Stream_priv::fSetMixLaneCount(MixPool::threadCount());
+    aulib::log::startThread();
+
     gInitType = InitType::NoOutput;
     std::atexit(Aulib::quit);
     return true;
 }
 
+auto Aulib::renderMix(float out[], const int frames) -> bool
+{
+    if (gInitType != InitType::NoOutput) {
+        SDL_SetError("Rendering requires SDL_audiolib to be initialized without output.");
+        return false;
+    }
+    if (Stream_priv::fAudioSpec.channels < 1 or Stream_priv::fAudioSpec.channels > MAX_CHANNELS) {
+        SDL_SetError("Rendering supports only 1 to %d channels.", MAX_CHANNELS);
+        return false;
+    }
+
+    SdlAudioLocker locker;
+
+    // Mix in blocks no larger than the frame size, so that long renders don't need huge buffers
+    // and streams started from callbacks don't wait for the whole render to finish.
+    const int channels = Stream_priv::fAudioSpec.channels;
+    const int blockFrames = Stream_priv::fAudioSpec.samples;
+    for (int pos = 0; pos < frames; pos += blockFrames) {
+        Stream_priv::fRender(out + pos * channels, std::min(blockFrames, frames - pos));
+    }
+    return true;
+}
+
 void Aulib::quit()
 {
     if (gInitType == InitType::None) {
         return;
     }
+    if (gInitType == InitType::Full) {
 #if SDL_VERSION_ATLEAST(2, 0, 0)
-    SDL_CloseAudioDevice(Stream_priv::fDeviceId);
+        SDL_CloseAudioDevice(Stream_priv::fDeviceId);
 #else
-    SDL_CloseAudio();
+        SDL_CloseAudio();
 #endif
-    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    }
+    DecodePool::shutdown();
+    MixPool::shutdown();
     Stream_priv::fSampleConverter = nullptr;
+    Stream_priv::fOffline = false;
+    Stream_priv::fMixedFrames = 0;
+    // Cached sounds are in the output format, which might be different after the next init.
+    PcmCache::clear();
     gInitType = InitType::None;
+    aulib::log::stopThread();
 }
 
 auto Aulib::sampleFormat() noexcept -> AudioFormat
@@ -175,6 +238,48 @@ auto Aulib::frameSize() noexcept -> int
     return Stream_priv::fAudioSpec.samples;
 }
 
+void Aulib::setDecodeThreadCount(const int count)
+{
+    DecodePool::setThreadCount(count);
+}
+
+auto Aulib::decodeThreadCount() -> int
+{
+    return DecodePool::threadCount();
+}
+
+void Aulib::setMixThreadCount(const int count)
+{
+    gMixThreadCount = std::max(1, count);
+    if (gInitType == InitType::None) {
+        return;
+    }
+
+    MixPool::prepareThreadCount(gMixThreadCount);
+    {
+        SdlAudioLocker locker;
+
+        MixPool::swapPrepared();
+        Stream_priv::fSetMixLaneCount(MixPool::threadCount());
+    }
+    MixPool::stopRetired();
+}
+
+auto Aulib::mixThreadCount() -> int
+{
+    return gInitType != InitType::None ? MixPool::threadCount() : gMixThreadCount;
+}
+
+void Aulib::setMaxRealVoices(const int count)
+{
+    Stream_priv::fMaxRealVoices = std::max(0, count);
+}
+
+auto Aulib::maxRealVoices() -> int
+{
+    return Stream_priv::fMaxRealVoices;
+}
+
 /*
 
 Copyright (C) 2014, 2015, 2016, 2017, 2018, 2019 Nikos Chantziaras.
@@ -0,0 +1,270 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "aulib_log.h"
+
+#include "MpscQueue.h"
+#include "SdlMutex.h"
+#include <SDL_thread.h>
+#include <SDL_timer.h>
+#include <SDL_version.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+struct Record final
+{
+    Aulib::LogLevel level;
+    const void* site;
+    char text[aulib::log::MAX_MESSAGE_LEN];
+};
+
+constexpr int QUEUE_CAPACITY = 256;
+// At most RATE_LIMIT messages from the same site are passed on within RATE_WINDOW_MS. The rest are
+// counted and reported once the window is over. This happens before queueing, so a site that
+// floods the log can't push other messages out of the queue.
+constexpr int RATE_LIMIT = 5;
+constexpr Uint32 RATE_WINDOW_MS = 1000;
+// Sites are never removed, so there needs to be room for every log call in the library.
+constexpr int SITE_SLOTS = 512;
+
+MpscQueue<Record> gQueue{QUEUE_CAPACITY};
+// Never destroyed, since a producer that saw gRunning set might still post to it after stopping.
+SDL_sem* gWakeSem = nullptr;
+SDL_Thread* gThread = nullptr;
+std::atomic<bool> gRunning{false};
+std::atomic<bool> gQuit{false};
+std::atomic<Uint64> gDropped{0};
+
+struct SiteSlot final
+{
+    std::atomic<const void*> site{nullptr};
+    std::atomic<Uint32> windowStart{0};
+    std::atomic<int> count{0};
+    std::atomic<int> suppressed{0};
+};
+
+SiteSlot gSites[SITE_SLOTS];
+
+// Returns false if the message should be suppressed. Lock-free, but only approximate when several
+// threads log from the same site at once.
+auto admit(const void* const site) noexcept -> bool
+{
+    const auto first = static_cast<int>((reinterpret_cast<uintptr_t>(site) >> 3) % SITE_SLOTS);
+    for (int i = 0; i < SITE_SLOTS; ++i) {
+        SiteSlot& slot = gSites[(first + i) % SITE_SLOTS];
+        const void* slotSite = slot.site.load(std::memory_order_acquire);
+        if (not slotSite and slot.site.compare_exchange_strong(slotSite, site)) {
+            slotSite = site;
+        }
+        if (slotSite != site) {
+            continue;
+        }
+
+        const Uint32 now = SDL_GetTicks();
+        Uint32 windowStart = slot.windowStart.load(std::memory_order_relaxed);
+        if (now - windowStart >= RATE_WINDOW_MS
+            and slot.windowStart.compare_exchange_strong(windowStart, now))
+        {
+            slot.count.store(0, std::memory_order_relaxed);
+        }
+        if (slot.count.fetch_add(1, std::memory_order_relaxed) < RATE_LIMIT) {
+            return true;
+        }
+        slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+struct LastMessage final
+{
+    Aulib::LogLevel level;
+    std::string text;
+};
+
+// Everything below is protected by gSinkMutex, which is held while delivering messages.
+SdlMutex gSinkMutex;
+Aulib::LogCallback gCallback;
+// Last message delivered from each site, for reporting suppressed ones.
+std::unordered_map<const void*, LastMessage> gLastMessages;
+
+void emit(const Aulib::LogLevel level, const char* const msg)
+{
+    if (gCallback) {
+        gCallback(level, msg);
+        return;
+    }
+    switch (level) {
+    case Aulib::LogLevel::Debug:
+        fmt::print(stderr, "SDL_audiolib debug: {}\n", msg);
+        break;
+    case Aulib::LogLevel::Info:
+        fmt::print("SDL_audiolib info: {}\n", msg);
+        break;
+    case Aulib::LogLevel::Warning:
+        fmt::print(stderr, "SDL_audiolib warning: {}\n", msg);
+        break;
+    }
+}
+
+void deliver(const Record& rec)
+{
+    emit(rec.level, rec.text);
+    auto& last = gLastMessages[rec.site];
+    last.level = rec.level;
+    last.text = rec.text;
+}
+
+// Reports what was suppressed in windows that are over, or in all windows if 'all' is set.
+void reportSuppressed(const bool all)
+{
+    const Uint32 now = SDL_GetTicks();
+    for (auto& slot : gSites) {
+        const void* const site = slot.site.load(std::memory_order_acquire);
+        if (not site) {
+            continue;
+        }
+        const Uint32 windowStart = slot.windowStart.load(std::memory_order_relaxed);
+        if (slot.suppressed.load(std::memory_order_relaxed) == 0
+            or (not all and now - windowStart < RATE_WINDOW_MS))
+        {
+            continue;
+        }
+        const int count = slot.suppressed.exchange(0, std::memory_order_relaxed);
+        const auto& last = gLastMessages[site];
+        emit(last.level,
+             fmt::format("Suppressed {} more message(s) like: {}", count, last.text).c_str());
+    }
+}
+
+// Must only be called by one thread at a time, since it's the queue's consumer.
+void drain(const bool all)
+{
+    std::lock_guard<SdlMutex> lock(gSinkMutex);
+
+    while (const Record* rec = gQueue.peek(0)) {
+        deliver(*rec);
+        gQueue.pop(1);
+    }
+    if (const Uint64 dropped = gDropped.exchange(0)) {
+        emit(Aulib::LogLevel::Warning,
+             fmt::format("Dropped {} log message(s) because the log queue was full.", dropped)
+                 .c_str());
+    }
+    reportSuppressed(all);
+}
+
+} // namespace
+
+extern "C" {
+static int logThreadMain(void* /*unused*/)
+{
+    while (not gQuit) {
+        SDL_SemWaitTimeout(gWakeSem, RATE_WINDOW_MS);
+        drain(false);
+    }
+    return 0;
+}
+}
+
+void aulib::log::post(const Aulib::LogLevel level, const void* const site, const char msg[],
+                      const size_t len)
+{
+    if (not admit(site)) {
+        return;
+    }
+
+    Record rec;
+    rec.level = level;
+    rec.site = site;
+    const size_t textLen = std::min(len, sizeof(rec.text) - 1);
+    std::memcpy(rec.text, msg, textLen);
+    rec.text[textLen] = '\0';
+    if (len > textLen) {
+        std::memcpy(rec.text + textLen - 3, "...", 3);
+    }
+
+    if (gRunning.load(std::memory_order_acquire)) {
+        if (gQueue.push(&rec, 1)) {
+            SDL_SemPost(gWakeSem);
+        } else {
+            gDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    std::lock_guard<SdlMutex> lock(gSinkMutex);
+    reportSuppressed(false);
+    deliver(rec);
+}
+
+void aulib::log::startThread()
+{
+    if (gThread) {
+        return;
+    }
+    if (not gWakeSem) {
+        gWakeSem = SDL_CreateSemaphore(0);
+        if (not gWakeSem) {
+            warnLn("Failed to create log thread semaphore: {}", SDL_GetError());
+            return;
+        }
+    }
+    gQuit = false;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+    gThread = SDL_CreateThread(logThreadMain, "aulib log", nullptr);
+#else
+    gThread = SDL_CreateThread(logThreadMain, nullptr);
+#endif
+    if (not gThread) {
+        warnLn("Failed to create log thread: {}", SDL_GetError());
+        return;
+    }
+    gRunning.store(true, std::memory_order_release);
+}
+
+void aulib::log::stopThread()
+{
+    if (not gThread) {
+        return;
+    }
+    gRunning.store(false, std::memory_order_release);
+    gQuit = true;
+    SDL_SemPost(gWakeSem);
+    SDL_WaitThread(gThread, nullptr);
+    gThread = nullptr;
+    // Whatever got queued after the thread's last look.
+    drain(true);
+}
+
+void Aulib::setLogCallback(LogCallback callback)
+{
+    std::lock_guard<SdlMutex> lock(gSinkMutex);
+    gCallback = std::move(callback);
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
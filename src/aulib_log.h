@@ -1,19 +1,37 @@
 // This is copyrighted software. More information is at the end of this file.
 #pragma once
+#include "aulib.h"
 #include "aulib_config.h"
+#include "aulib_global.h"
 #include <fmt/core.h>
 
+/*
+ * Messages are formatted into a buffer on the stack and handed to post(). While the background
+ * thread is running, post() only pushes them into a lock-free queue, so logging from the audio
+ * thread neither allocates nor waits for the output. The background thread runs while the library
+ * is initialized.
+ */
 namespace aulib {
 namespace log {
 
+// Longer messages are cut off.
+constexpr int MAX_MESSAGE_LEN = 256;
+
+// 'site' identifies where the message was logged from. Messages from the same site are rate
+// limited together. 'len' is the length the message would have had without being cut off.
+AULIB_NO_EXPORT void post(Aulib::LogLevel level, const void* site, const char msg[], size_t len);
+
+AULIB_NO_EXPORT void startThread();
+// Delivers what's still queued before returning.
+AULIB_NO_EXPORT void stopThread();
+
 template <typename... Args>
-void debug([[maybe_unused]] fmt::format_string<Args...>&& fmt_str, [[maybe_unused]] Args&&... args)
+void postFormatted(const Aulib::LogLevel level, fmt::format_string<Args...>&& fmt_str,
+                   Args&&... args)
 {
-#if AULIB_DEBUG
-    fmt::print(stderr, "SDL_audiolib debug: {}",
-               fmt::format(std::forward<fmt::format_string<Args...>>(fmt_str),
-                           std::forward<Args>(args)...));
-#endif
+    char buf[MAX_MESSAGE_LEN];
+    const auto result = fmt::format_to_n(buf, sizeof(buf), fmt_str, std::forward<Args>(args)...);
+    post(level, static_cast<fmt::string_view>(fmt_str).data(), buf, result.size);
 }
 
 template <typename... Args>
@@ -21,42 +39,23 @@ void debugLn([[maybe_unused]] fmt::format_string<Args...>&& fmt_str,
              [[maybe_unused]] Args&&... args)
 {
 #if AULIB_DEBUG
-    fmt::print(stderr, "SDL_audiolib debug: {}\n",
-               fmt::format(std::forward<fmt::format_string<Args...>>(fmt_str),
-                           std::forward<Args>(args)...));
+    postFormatted(Aulib::LogLevel::Debug, std::forward<fmt::format_string<Args...>>(fmt_str),
+                  std::forward<Args>(args)...);
 #endif
 }
 
-template <typename... Args>
-void warn(fmt::format_string<Args...>&& fmt_str, Args&&... args)
-{
-    fmt::print(stderr, "SDL_audiolib warning: {}",
-               fmt::format(std::forward<fmt::format_string<Args...>>(fmt_str),
-                           std::forward<Args>(args)...));
-}
-
 template <typename... Args>
 void warnLn(fmt::format_string<Args...>&& fmt_str, Args&&... args)
 {
-    fmt::print(stderr, "SDL_audiolib warning: {}\n",
-               fmt::format(std::forward<fmt::format_string<Args...>>(fmt_str),
-                           std::forward<Args>(args)...));
-}
-
-template <typename... Args>
-void info(fmt::format_string<Args...>&& fmt_str, Args&&... args)
-{
-    fmt::print("SDL_audiolib info: {}",
-               fmt::format(std::forward<fmt::format_string<Args...>>(fmt_str),
-                           std::forward<Args>(args)...));
+    postFormatted(Aulib::LogLevel::Warning, std::forward<fmt::format_string<Args...>>(fmt_str),
+                  std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 void infoLn(fmt::format_string<Args...>&& fmt_str, Args&&... args)
 {
-    fmt::print("SDL_audiolib info: {}\n",
-               fmt::format(std::forward<fmt::format_string<Args...>>(fmt_str),
-                           std::forward<Args>(args)...));
+    postFormatted(Aulib::LogLevel::Info, std::forward<fmt::format_string<Args...>>(fmt_str),
+                  std::forward<Args>(args)...);
 }
 
 } // namespace log
@@ -0,0 +1,72 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "Aulib/Bus.h"
+#include "Aulib/Processor.h"
+#include <SDL_stdinc.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Aulib {
+
+struct Bus_priv final
+{
+    explicit Bus_priv(Bus* pub);
+
+    Bus* const q;
+    // Our index in fBuses, and the index of our buffer in each mix lane.
+    int fSlot = -1;
+    // Generation of our slot in fGenerations at the time we took it.
+    Uint32 fGeneration = 0;
+    // Null for the master output.
+    Bus_priv* fOutput = nullptr;
+    std::atomic<float> fVolume{1.f};
+    std::atomic<bool> fMuted{false};
+    // Gain used for the last processed block. Negative if there was no previous block.
+    float fLastGain = -1.f;
+    // Our gain multiplied by the gains of all buses between us and the master output.
+    float fAudibleGain = 1.f;
+    std::vector<std::shared_ptr<Processor>> fProcessors;
+
+    // All existing buses, indexed by slot. Free slots are null.
+    static std::vector<Bus_priv*> fBuses;
+    // Incremented whenever a slot is freed, so that commands referring to a deleted bus can be told
+    // apart from ones referring to the bus that took over its slot.
+    static std::vector<Uint32> fGenerations;
+    // Slots of all existing buses, with every bus coming before the bus it outputs to.
+    static std::vector<int> fOrder;
+
+    // Must be called with the audio device locked whenever buses are added, removed or rerouted.
+    static void fUpdateOrder();
+
+    // Updates fAudibleGain of all buses.
+    static void fUpdateAudibleGains();
+
+    // Sums what the mix lanes routed to each bus, runs the buses and mixes their output into
+    // lane 0.
+    static void fMixBuses(int laneCount, int samples);
+};
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,182 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "chanlayout.h"
+
+#include "aulib_debug.h"
+#include <algorithm>
+#include <initializer_list>
+
+using Aulib::Speaker;
+
+// -3dB, for speakers that are split between two others.
+static constexpr float HALF_POWER = 0.70710678f;
+
+static auto findSpeaker(const int channels, const Speaker speaker) noexcept -> int
+{
+    for (int c = 0; c < channels; ++c) {
+        if (Aulib::SPEAKER_LAYOUTS[channels - 1][c] == speaker) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+// Adds 'weight' of a speaker to the output channels it ends up in. 'channels' is at least 2, so the
+// front left and right speakers always exist.
+static void routeSpeaker(float column[], const int channels, const Speaker speaker,
+                         const float weight) noexcept
+{
+    if (const int c = findSpeaker(channels, speaker); c >= 0) {
+        column[c] += weight;
+        return;
+    }
+
+    // Back and side speakers stand in for each other. If neither exists, they go to the front.
+    auto routeSurround = [&](const Speaker other, const Speaker front) {
+        if (const int c = findSpeaker(channels, other); c >= 0) {
+            column[c] += weight;
+        } else {
+            column[findSpeaker(channels, front)] += weight * HALF_POWER;
+        }
+    };
+
+    switch (speaker) {
+    case Speaker::FrontLeft:
+    case Speaker::FrontRight:
+    case Speaker::Lfe:
+        break;
+    case Speaker::FrontCenter:
+        column[0] += weight * HALF_POWER;
+        column[1] += weight * HALF_POWER;
+        break;
+    case Speaker::BackLeft:
+        routeSurround(Speaker::SideLeft, Speaker::FrontLeft);
+        break;
+    case Speaker::BackRight:
+        routeSurround(Speaker::SideRight, Speaker::FrontRight);
+        break;
+    case Speaker::SideLeft:
+        routeSurround(Speaker::BackLeft, Speaker::FrontLeft);
+        break;
+    case Speaker::SideRight:
+        routeSurround(Speaker::BackRight, Speaker::FrontRight);
+        break;
+    case Speaker::BackCenter:
+        routeSpeaker(column, channels, Speaker::BackLeft, weight * HALF_POWER);
+        routeSpeaker(column, channels, Speaker::BackRight, weight * HALF_POWER);
+        break;
+    }
+}
+
+auto Aulib::layoutMatrix(const int inChannels, const int outChannels) noexcept -> LayoutMatrix
+{
+    AM_debugAssert(inChannels >= 1 and inChannels <= MAX_CHANNELS);
+    AM_debugAssert(outChannels >= 1 and outChannels <= MAX_CHANNELS);
+
+    LayoutMatrix m;
+    m.inChannels = inChannels;
+    m.outChannels = outChannels;
+
+    if (inChannels == 1) {
+        m.columns[0][0] = 1.f;
+        if (outChannels > 1) {
+            m.columns[0][1] = 1.f;
+        }
+        return m;
+    }
+
+    // Mono output is the average of the stereo downmix.
+    const int routedChannels = outChannels == 1 ? 2 : outChannels;
+    for (int i = 0; i < inChannels; ++i) {
+        routeSpeaker(m.columns[i], routedChannels, SPEAKER_LAYOUTS[inChannels - 1][i], 1.f);
+        if (outChannels == 1) {
+            m.columns[i][0] = (m.columns[i][0] + m.columns[i][1]) * 0.5f;
+            m.columns[i][1] = 0.f;
+        }
+    }
+    return m;
+}
+
+static auto makeChannelMap(const int outChannels, std::initializer_list<int> targets) noexcept
+    -> Aulib::ChannelMap
+{
+    Aulib::ChannelMap map;
+    map.outChannels = outChannels;
+    map.target.fill(-1);
+    int c = 0;
+    for (const int target : targets) {
+        map.target[c++] = target;
+    }
+    return map;
+}
+
+auto Aulib::vorbisChannelMap(const int channels) noexcept -> ChannelMap
+{
+    switch (channels) {
+    case 3:
+        // L C R
+        return makeChannelMap(6, {0, 2, 1});
+    case 5:
+        // FL C FR BL BR
+        return makeChannelMap(6, {0, 2, 1, 4, 5});
+    case 6:
+        // FL C FR BL BR LFE
+        return makeChannelMap(6, {0, 2, 1, 4, 5, 3});
+    case 7:
+        // FL C FR SL SR BC LFE
+        return makeChannelMap(7, {0, 2, 1, 5, 6, 4, 3});
+    case 8:
+        // FL C FR SL SR BL BR LFE
+        return makeChannelMap(8, {0, 2, 1, 6, 7, 4, 5, 3});
+    case 1:
+    case 2:
+    case 4:
+        return flacChannelMap(channels);
+    default:
+        // The Vorbis spec leaves the order of more than 8 channels to the application. Keep the
+        // first two.
+        return makeChannelMap(2, {0, 1});
+    }
+}
+
+auto Aulib::flacChannelMap(const int channels) noexcept -> ChannelMap
+{
+    switch (channels) {
+    case 3:
+        // FL FR FC
+        return makeChannelMap(6, {0, 1, 2});
+    case 5:
+        // FL FR FC BL BR
+        return makeChannelMap(6, {0, 1, 2, 4, 5});
+    default:
+        break;
+    }
+
+    ChannelMap map;
+    map.outChannels = std::min(channels, MAX_CHANNELS);
+    map.target.fill(-1);
+    for (int c = 0; c < map.outChannels; ++c) {
+        map.target[c] = c;
+    }
+    return map;
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,114 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_global.h"
+#include <array>
+
+namespace Aulib {
+
+// Most channels the device, a stream or a decoder's output can have.
+constexpr int MAX_CHANNELS = 8;
+
+enum class Speaker
+{
+    FrontLeft,
+    FrontRight,
+    FrontCenter,
+    Lfe,
+    BackLeft,
+    BackRight,
+    SideLeft,
+    SideRight,
+    BackCenter,
+};
+
+/*
+ * Speaker of each channel, indexed by channel count - 1. This is the order SDL expects interleaved
+ * channels in:
+ *
+ *   1: FL
+ *   2: FL FR
+ *   3: FL FR LFE
+ *   4: FL FR BL BR
+ *   5: FL FR LFE BL BR
+ *   6: FL FR FC LFE BL BR
+ *   7: FL FR FC LFE BC SL SR
+ *   8: FL FR FC LFE BL BR SL SR
+ *
+ * All audio inside the library uses this order. Decoders whose formats use a different one need to
+ * reorder their output.
+ */
+inline constexpr Speaker SPEAKER_LAYOUTS[MAX_CHANNELS][MAX_CHANNELS]{
+    {Speaker::FrontLeft},
+    {Speaker::FrontLeft, Speaker::FrontRight},
+    {Speaker::FrontLeft, Speaker::FrontRight, Speaker::Lfe},
+    {Speaker::FrontLeft, Speaker::FrontRight, Speaker::BackLeft, Speaker::BackRight},
+    {Speaker::FrontLeft, Speaker::FrontRight, Speaker::Lfe, Speaker::BackLeft, Speaker::BackRight},
+    {Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::Lfe,
+     Speaker::BackLeft, Speaker::BackRight},
+    {Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::Lfe,
+     Speaker::BackCenter, Speaker::SideLeft, Speaker::SideRight},
+    {Speaker::FrontLeft, Speaker::FrontRight, Speaker::FrontCenter, Speaker::Lfe,
+     Speaker::BackLeft, Speaker::BackRight, Speaker::SideLeft, Speaker::SideRight},
+};
+
+/*
+ * Converts frames from one channel layout to another. Each output channel is a weighted sum of the
+ * input channels.
+ *
+ * Speakers that exist in both layouts are copied. Missing ones are folded into their neighbors:
+ * center channels go to the front left and right at -3dB, back and side channels go to each other
+ * or to the front at -3dB, and LFE is dropped. Mono goes to the front left and right at full
+ * volume, like it always did for stereo output. Mono output gets the average of the stereo downmix.
+ */
+struct LayoutMatrix final
+{
+    int inChannels = 0;
+    int outChannels = 0;
+    // columns[i][o] is the weight of input channel i in output channel o. Weights of outputs past
+    // outChannels are zero, so kernels can use whole vectors.
+    alignas(32) float columns[MAX_CHANNELS][MAX_CHANNELS]{};
+};
+
+AULIB_NO_EXPORT auto layoutMatrix(int inChannels, int outChannels) noexcept -> LayoutMatrix;
+
+/*
+ * Where the channels of a format with its own channel order go in the layouts above. target[c] is
+ * the output channel of input channel c, or -1 if it is dropped. Input channels past MAX_CHANNELS
+ * are always dropped. Outputs that no input maps to are silent.
+ */
+struct ChannelMap final
+{
+    int outChannels = 0;
+    std::array<int, MAX_CHANNELS> target{};
+};
+
+// Vorbis channel order. Layouts without an SDL equivalent get the next bigger one.
+AULIB_NO_EXPORT auto vorbisChannelMap(int channels) noexcept -> ChannelMap;
+
+// FLAC and WAVE channel order. Same as SDL's, except for 3 and 5 channels, which have a center
+// channel instead of LFE.
+AULIB_NO_EXPORT auto flacChannelMap(int channels) noexcept -> ChannelMap;
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,291 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "mixkernels.h"
+
+#include "aulib_config.h"
+#include "aulib_debug.h"
+#include "aulib_log.h"
+#include "mixkernels_impl.h"
+#include "simd.h"
+#include <SDL_cpuinfo.h>
+#include <SDL_version.h>
+
+namespace {
+
+#if AULIB_HAVE_SSE2
+struct Sse2Ops final
+{
+    using Vec = __m128;
+    static constexpr int width = 4;
+
+    static auto load(const float* p) noexcept -> Vec
+    {
+        return _mm_loadu_ps(p);
+    }
+
+    static void store(float* p, const Vec v) noexcept
+    {
+        _mm_storeu_ps(p, v);
+    }
+
+    static auto add(const Vec a, const Vec b) noexcept -> Vec
+    {
+        return _mm_add_ps(a, b);
+    }
+
+    static auto mul(const Vec a, const Vec b) noexcept -> Vec
+    {
+        return _mm_mul_ps(a, b);
+    }
+
+    static auto set1(const float f) noexcept -> Vec
+    {
+        return _mm_set1_ps(f);
+    }
+
+    // Turns abcd into aabb and ccdd.
+    static void duplicate(const Vec v, Vec& lo, Vec& hi) noexcept
+    {
+        lo = _mm_unpacklo_ps(v, v);
+        hi = _mm_unpackhi_ps(v, v);
+    }
+};
+#endif
+
+#if AULIB_HAVE_NEON
+struct NeonOps final
+{
+    using Vec = float32x4_t;
+    static constexpr int width = 4;
+
+    static auto load(const float* p) noexcept -> Vec
+    {
+        return vld1q_f32(p);
+    }
+
+    static void store(float* p, const Vec v) noexcept
+    {
+        vst1q_f32(p, v);
+    }
+
+    static auto add(const Vec a, const Vec b) noexcept -> Vec
+    {
+        return vaddq_f32(a, b);
+    }
+
+    static auto mul(const Vec a, const Vec b) noexcept -> Vec
+    {
+        return vmulq_f32(a, b);
+    }
+
+    static auto set1(const float f) noexcept -> Vec
+    {
+        return vdupq_n_f32(f);
+    }
+
+    // Turns abcd into aabb and ccdd.
+    static void duplicate(const Vec v, Vec& lo, Vec& hi) noexcept
+    {
+        const float32x4x2_t zipped = vzipq_f32(v, v);
+        lo = zipped.val[0];
+        hi = zipped.val[1];
+    }
+};
+#endif
+
+// Dispatch table, indexed by channels - 1, gain type and panning.
+constexpr int GAIN_TYPES = 4;
+using KernelTable = Aulib::MixFunc[Aulib::MAX_CHANNELS][GAIN_TYPES][2];
+using UpmixKernelTable = Aulib::MixFunc[GAIN_TYPES];
+
+} // namespace
+
+static KernelTable gKernels{};
+static UpmixKernelTable gUpmixKernels{};
+static Aulib::LayoutFunc gLayoutKernel = nullptr;
+static Aulib::MixIsa gIsa = Aulib::MixIsa::Scalar;
+
+static void fillKernelTable(const Aulib::MixIsa isa)
+{
+    for (int ch = 0; ch < Aulib::MAX_CHANNELS; ++ch) {
+        for (int gain = 0; gain < GAIN_TYPES; ++gain) {
+            for (int pan = 0; pan < 2; ++pan) {
+                gKernels[ch][gain][pan] =
+                    Aulib::mixKernelFor(isa, ch + 1, static_cast<Aulib::MixGain>(gain), pan != 0);
+            }
+        }
+    }
+    for (int gain = 0; gain < GAIN_TYPES; ++gain) {
+        gUpmixKernels[gain] = Aulib::upmixKernelFor(isa, static_cast<Aulib::MixGain>(gain));
+    }
+    gLayoutKernel = Aulib::layoutKernelFor(isa);
+    gIsa = isa;
+}
+
+// Start out with the scalar kernels, so that mixing works even before initMixKernels() is called.
+static const bool gScalarKernelsFilled = [] {
+    fillKernelTable(Aulib::MixIsa::Scalar);
+    return true;
+}();
+
+void Aulib::initMixKernels()
+{
+    MixIsa isa = MixIsa::Scalar;
+#if AULIB_HAVE_SSE2
+    if (SDL_HasSSE2()) {
+        isa = MixIsa::Sse2;
+    }
+#endif
+#if HAVE_AVX2_KERNELS and SDL_VERSION_ATLEAST(2, 0, 4)
+    if (SDL_HasAVX2()) {
+        isa = MixIsa::Avx2;
+    }
+#endif
+#if AULIB_HAVE_NEON and SDL_VERSION_ATLEAST(2, 0, 6)
+    if (SDL_HasNEON()) {
+        isa = MixIsa::Neon;
+    }
+#endif
+    fillKernelTable(isa);
+    aulib::log::debugLn("Using {} mixing kernels.", mixIsaName(isa));
+}
+
+auto Aulib::mixIsa() noexcept -> MixIsa
+{
+    return gIsa;
+}
+
+auto Aulib::mixIsaName(const MixIsa isa) noexcept -> const char*
+{
+    switch (isa) {
+    case MixIsa::Scalar:
+        return "scalar";
+    case MixIsa::Sse2:
+        return "SSE2";
+    case MixIsa::Avx2:
+        return "AVX2";
+    case MixIsa::Neon:
+        return "NEON";
+    }
+    return "unknown";
+}
+
+auto Aulib::mixKernelFor(const int channels, const MixGain gain, const bool panned) noexcept
+    -> MixFunc
+{
+    AM_debugAssert(channels >= 1 and channels <= MAX_CHANNELS);
+    return gKernels[channels - 1][static_cast<int>(gain)][panned ? 1 : 0];
+}
+
+auto Aulib::mixKernelFor(const MixIsa isa, const int channels, const MixGain gain,
+                         const bool panned) noexcept -> MixFunc
+{
+    switch (isa) {
+    case MixIsa::Scalar:
+        return selectKernel<ScalarOps>(channels, gain, panned);
+    case MixIsa::Sse2:
+#if AULIB_HAVE_SSE2
+        return selectKernel<Sse2Ops>(channels, gain, panned);
+#else
+        return nullptr;
+#endif
+    case MixIsa::Avx2:
+#if HAVE_AVX2_KERNELS
+        return mixKernelForAvx2(channels, gain, panned);
+#else
+        return nullptr;
+#endif
+    case MixIsa::Neon:
+#if AULIB_HAVE_NEON
+        return selectKernel<NeonOps>(channels, gain, panned);
+#else
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+auto Aulib::upmixKernelFor(const MixGain gain) noexcept -> MixFunc
+{
+    return gUpmixKernels[static_cast<int>(gain)];
+}
+
+auto Aulib::upmixKernelFor(const MixIsa isa, const MixGain gain) noexcept -> MixFunc
+{
+    switch (isa) {
+    case MixIsa::Scalar:
+        return selectUpmixKernel<ScalarOps>(gain);
+    case MixIsa::Sse2:
+#if AULIB_HAVE_SSE2
+        return selectUpmixKernel<Sse2Ops>(gain);
+#else
+        return nullptr;
+#endif
+    case MixIsa::Avx2:
+#if HAVE_AVX2_KERNELS
+        return upmixKernelForAvx2(gain);
+#else
+        return nullptr;
+#endif
+    case MixIsa::Neon:
+#if AULIB_HAVE_NEON
+        return selectUpmixKernel<NeonOps>(gain);
+#else
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+auto Aulib::layoutKernelFor() noexcept -> LayoutFunc
+{
+    return gLayoutKernel;
+}
+
+auto Aulib::layoutKernelFor(const MixIsa isa) noexcept -> LayoutFunc
+{
+    switch (isa) {
+    case MixIsa::Scalar:
+        return layoutKernel<ScalarOps>;
+    case MixIsa::Sse2:
+#if AULIB_HAVE_SSE2
+        return layoutKernel<Sse2Ops>;
+#else
+        return nullptr;
+#endif
+    case MixIsa::Avx2:
+#if HAVE_AVX2_KERNELS
+        return layoutKernelForAvx2();
+#else
+        return nullptr;
+#endif
+    case MixIsa::Neon:
+#if AULIB_HAVE_NEON
+        return layoutKernel<NeonOps>;
+#else
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+/*
+
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,113 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_global.h"
+#include "chanlayout.h"
+
+namespace Aulib {
+
+enum class MixGain
+{
+    // Samples are added as-is.
+    Unity,
+    // Samples are scaled by a fixed gain.
+    Constant,
+    // Gain changes linearly from frame to frame.
+    Ramp,
+    // Like Ramp, but additionally multiplied by a cubic fade curve.
+    Fade,
+};
+
+enum class MixIsa
+{
+    Scalar,
+    Sse2,
+    Avx2,
+    Neon,
+};
+
+struct MixGains final
+{
+    // Gain of the first frame. Kernels that are not panned only use the left gain. Panned kernels
+    // use the left gain for speakers on the left, the right gain for those on the right, and the
+    // average of both for speakers in the middle.
+    float left;
+    float right;
+    // Added to the gain on each frame. Only used by ramped kernels.
+    float leftStep;
+    float rightStep;
+    // Fade position of the first frame and its per-frame step. Only used by fading kernels.
+    float fade;
+    float fadeStep;
+};
+
+/*
+ * Adds 'frames' frames of interleaved samples from 'src' to 'dst', applying the given gains. On
+ * frame i, the gain is 'left + leftStep * i' (and the same for right.) Fading kernels multiply that
+ * by '(fade + fadeStep * i)^3'.
+ *
+ * Upmix kernels read mono frames from 'src' and add each one to both channels of a stereo frame in
+ * 'dst', using the left and right gains. They are always panned.
+ */
+using MixFunc = void (*)(float dst[], const float src[], int frames, const MixGains& gains);
+
+/*
+ * Converts 'frames' frames from 'src' to the channel layout of 'dst', overwriting it. 'src' has
+ * 'matrix.inChannels' channels and 'dst' has 'matrix.outChannels'. The buffers must not overlap.
+ */
+using LayoutFunc = void (*)(float dst[], const float src[], int frames, const LayoutMatrix& matrix);
+
+// Picks the best kernels for the CPU we're running on. Until this is called, the scalar kernels are
+// used.
+AULIB_NO_EXPORT void initMixKernels();
+
+AULIB_NO_EXPORT auto mixIsa() noexcept -> MixIsa;
+AULIB_NO_EXPORT auto mixIsaName(MixIsa isa) noexcept -> const char*;
+
+// Kernel for the current ISA. 'channels' must be between 1 and MAX_CHANNELS.
+AULIB_NO_EXPORT auto mixKernelFor(int channels, MixGain gain, bool panned) noexcept -> MixFunc;
+
+// Kernel for a specific ISA. Returns null if the kernels for that ISA are not compiled in. Does not
+// check whether the CPU actually supports the ISA.
+AULIB_NO_EXPORT auto mixKernelFor(MixIsa isa, int channels, MixGain gain, bool panned) noexcept
+    -> MixFunc;
+
+// Mono to stereo kernel for the current ISA.
+AULIB_NO_EXPORT auto upmixKernelFor(MixGain gain) noexcept -> MixFunc;
+
+// Mono to stereo kernel for a specific ISA. Returns null if that ISA is not compiled in.
+AULIB_NO_EXPORT auto upmixKernelFor(MixIsa isa, MixGain gain) noexcept -> MixFunc;
+
+// Layout conversion kernel for the current ISA.
+AULIB_NO_EXPORT auto layoutKernelFor() noexcept -> LayoutFunc;
+
+// Layout conversion kernel for a specific ISA. Returns null if that ISA is not compiled in.
+AULIB_NO_EXPORT auto layoutKernelFor(MixIsa isa) noexcept -> LayoutFunc;
+
+// Implemented in mixkernels_avx2.cpp, which is compiled with AVX2 code generation enabled.
+AULIB_NO_EXPORT auto mixKernelForAvx2(int channels, MixGain gain, bool panned) noexcept -> MixFunc;
+AULIB_NO_EXPORT auto upmixKernelForAvx2(MixGain gain) noexcept -> MixFunc;
+AULIB_NO_EXPORT auto layoutKernelForAvx2() noexcept -> LayoutFunc;
+
+} // namespace Aulib
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
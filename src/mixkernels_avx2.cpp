@@ -0,0 +1,89 @@
+// This is copyrighted software. More information is at the end of this file.
+/*
+ * AVX2 mix kernels. This file is compiled with AVX2 code generation enabled, so nothing in here may
+ * be called unless the CPU has been checked for AVX2 support first.
+ */
+#include "mixkernels_impl.h"
+#include <immintrin.h>
+
+namespace {
+
+struct Avx2Ops final
+{
+    using Vec = __m256;
+    static constexpr int width = 8;
+
+    static auto load(const float* p) noexcept -> Vec
+    {
+        return _mm256_loadu_ps(p);
+    }
+
+    static void store(float* p, const Vec v) noexcept
+    {
+        _mm256_storeu_ps(p, v);
+    }
+
+    static auto add(const Vec a, const Vec b) noexcept -> Vec
+    {
+        return _mm256_add_ps(a, b);
+    }
+
+    static auto mul(const Vec a, const Vec b) noexcept -> Vec
+    {
+        return _mm256_mul_ps(a, b);
+    }
+
+    static auto set1(const float f) noexcept -> Vec
+    {
+        return _mm256_set1_ps(f);
+    }
+
+    // Turns abcdefgh into aabbccdd and eeffgghh. Unpacking works within 128-bit halves, so the
+    // halves need to be put back in order afterwards.
+    static void duplicate(const Vec v, Vec& lo, Vec& hi) noexcept
+    {
+        const Vec unpackedLo = _mm256_unpacklo_ps(v, v);
+        const Vec unpackedHi = _mm256_unpackhi_ps(v, v);
+        lo = _mm256_permute2f128_ps(unpackedLo, unpackedHi, 0x20);
+        hi = _mm256_permute2f128_ps(unpackedLo, unpackedHi, 0x31);
+    }
+};
+
+} // namespace
+
+auto Aulib::mixKernelForAvx2(const int channels, const MixGain gain, const bool panned) noexcept
+    -> MixFunc
+{
+    return selectKernel<Avx2Ops>(channels, gain, panned);
+}
+
+auto Aulib::upmixKernelForAvx2(const MixGain gain) noexcept -> MixFunc
+{
+    return selectUpmixKernel<Avx2Ops>(gain);
+}
+
+auto Aulib::layoutKernelForAvx2() noexcept -> LayoutFunc
+{
+    return layoutKernel<Avx2Ops>;
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,482 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "mixkernels.h"
+#include <type_traits>
+
+/*
+ * Generic mix kernels. This header is included by every translation unit that provides kernels for
+ * a specific instruction set, each of which is built with different code generation flags. Because
+ * of that, everything here must have internal linkage. Otherwise the linker could pick a copy that
+ * was compiled for an instruction set the CPU doesn't support. This includes standard library
+ * function templates like std::max(), which is why the helpers below are used instead.
+ */
+namespace {
+
+struct ScalarOps final
+{};
+
+constexpr auto maxOf(const int a, const int b) noexcept -> int
+{
+    return a > b ? a : b;
+}
+
+constexpr auto gcdOf(const int a, const int b) noexcept -> int
+{
+    return b == 0 ? a : gcdOf(b, a % b);
+}
+
+constexpr auto lcmOf(const int a, const int b) noexcept -> int
+{
+    return a / gcdOf(a, b) * b;
+}
+
+enum class PanSide
+{
+    Left,
+    Right,
+    Middle,
+};
+
+constexpr auto panSide(const int channels, const int channel) noexcept -> PanSide
+{
+    switch (Aulib::SPEAKER_LAYOUTS[channels - 1][channel]) {
+    case Aulib::Speaker::FrontRight:
+    case Aulib::Speaker::BackRight:
+    case Aulib::Speaker::SideRight:
+        return PanSide::Right;
+    case Aulib::Speaker::FrontCenter:
+    case Aulib::Speaker::Lfe:
+    case Aulib::Speaker::BackCenter:
+        return PanSide::Middle;
+    default:
+        return PanSide::Left;
+    }
+}
+
+// Gain of a channel on the first frame, and how much it changes per frame.
+template <int Channels, bool Panned>
+inline auto baseGain(const Aulib::MixGains& g, const int channel) noexcept -> float
+{
+    switch (Panned ? panSide(Channels, channel) : PanSide::Left) {
+    case PanSide::Right:
+        return g.right;
+    case PanSide::Middle:
+        return (g.left + g.right) * 0.5f;
+    default:
+        return g.left;
+    }
+}
+
+template <int Channels, bool Panned>
+inline auto gainStep(const Aulib::MixGains& g, const int channel) noexcept -> float
+{
+    switch (Panned ? panSide(Channels, channel) : PanSide::Left) {
+    case PanSide::Right:
+        return g.rightStep;
+    case PanSide::Middle:
+        return (g.leftStep + g.rightStep) * 0.5f;
+    default:
+        return g.leftStep;
+    }
+}
+
+// The gains of each channel are looked up once, and the fade level is computed once per frame.
+// Gains are computed from the frame index rather than accumulated, which keeps the loop free of
+// dependencies between frames so that compilers can vectorize it.
+template <int Channels, Aulib::MixGain Gain, bool Panned>
+inline void mixScalar(float dst[], const float src[], const int firstFrame, const int endFrame,
+                      const Aulib::MixGains& g) noexcept
+{
+    if (Gain == Aulib::MixGain::Unity) {
+        for (int pos = firstFrame * Channels; pos < endFrame * Channels; ++pos) {
+            dst[pos] += src[pos];
+        }
+        return;
+    }
+
+    float base[Channels];
+    float step[Channels];
+    for (int c = 0; c < Channels; ++c) {
+        base[c] = baseGain<Channels, Panned>(g, c);
+        step[c] = gainStep<Channels, Panned>(g, c);
+    }
+    for (int frame = firstFrame; frame < endFrame; ++frame) {
+        const auto index = static_cast<float>(frame);
+        float level = 1.f;
+        if (Gain == Aulib::MixGain::Fade) {
+            const float fade = g.fade + g.fadeStep * index;
+            level = fade * fade * fade;
+        }
+        for (int c = 0; c < Channels; ++c) {
+            float gain = base[c];
+            if (Gain == Aulib::MixGain::Ramp or Gain == Aulib::MixGain::Fade) {
+                gain += step[c] * index;
+            }
+            if (Gain == Aulib::MixGain::Fade) {
+                gain *= level;
+            }
+            dst[frame * Channels + c] += src[frame * Channels + c] * gain;
+        }
+    }
+}
+
+// Mixes a mono source into a stereo destination. The left and right gains apply to the two output
+// channels.
+template <Aulib::MixGain Gain>
+inline void upmixScalar(float dst[], const float src[], const int firstFrame, const int endFrame,
+                        const Aulib::MixGains& g) noexcept
+{
+    for (int frame = firstFrame; frame < endFrame; ++frame) {
+        const float sample = src[frame];
+        if (Gain == Aulib::MixGain::Unity) {
+            dst[frame * 2] += sample;
+            dst[frame * 2 + 1] += sample;
+            continue;
+        }
+        const auto index = static_cast<float>(frame);
+        float left = g.left;
+        float right = g.right;
+        if (Gain == Aulib::MixGain::Ramp or Gain == Aulib::MixGain::Fade) {
+            left += g.leftStep * index;
+            right += g.rightStep * index;
+        }
+        if (Gain == Aulib::MixGain::Fade) {
+            const float fade = g.fade + g.fadeStep * index;
+            const float level = fade * fade * fade;
+            left *= level;
+            right *= level;
+        }
+        dst[frame * 2] += sample * left;
+        dst[frame * 2 + 1] += sample * right;
+    }
+}
+
+/*
+ * 'Ops' wraps the vector type and intrinsics of an instruction set. Each vector holds 'Ops::width'
+ * floats.
+ *
+ * GainLanes computes the gain of each lane for consecutive vectors of interleaved frames. When the
+ * vectors don't hold a whole number of frames, the channel of each lane repeats every 'period'
+ * vectors, and each vector in the period gets its own set of lanes.
+ */
+template <typename Ops, int Channels, Aulib::MixGain Gain, bool Panned>
+struct GainLanes final
+{
+    using Vec = typename Ops::Vec;
+    static constexpr int width = Ops::width;
+    static constexpr int period = lcmOf(width, Channels) / width;
+
+    // Gain of the first frame in each lane.
+    Vec base[period];
+    Vec step[period];
+    Vec fade;
+    Vec fadeStep;
+    Vec indexStep;
+    // Frame index of each lane in the next vector.
+    Vec index[period];
+
+    explicit GainLanes(const Aulib::MixGains& g) noexcept
+    {
+        for (int p = 0; p < period; ++p) {
+            alignas(32) float baseArr[width];
+            alignas(32) float stepArr[width];
+            alignas(32) float indexArr[width];
+            for (int j = 0; j < width; ++j) {
+                const int lane = p * width + j;
+                baseArr[j] = baseGain<Channels, Panned>(g, lane % Channels);
+                stepArr[j] = gainStep<Channels, Panned>(g, lane % Channels);
+                indexArr[j] = static_cast<float>(lane / Channels);
+            }
+            base[p] = Ops::load(baseArr);
+            step[p] = Ops::load(stepArr);
+            index[p] = Ops::load(indexArr);
+        }
+        fade = Ops::set1(g.fade);
+        fadeStep = Ops::set1(g.fadeStep);
+        indexStep = Ops::set1(static_cast<float>(period * width / Channels));
+    }
+
+    // Gain of the next vector at position 'p' of the period. Only for ramped and fading kernels.
+    auto next(const int p) noexcept -> Vec
+    {
+        Vec gain = Ops::add(base[p], Ops::mul(step[p], index[p]));
+        if (Gain == Aulib::MixGain::Fade) {
+            const Vec f = Ops::add(fade, Ops::mul(fadeStep, index[p]));
+            gain = Ops::mul(gain, Ops::mul(f, Ops::mul(f, f)));
+        }
+        index[p] = Ops::add(index[p], indexStep);
+        return gain;
+    }
+};
+
+// The loop handles a whole period of vectors at a time, and at least two.
+template <typename Ops, int Channels, Aulib::MixGain Gain, bool Panned>
+inline void mixSimd(float dst[], const float src[], const int frames,
+                    const Aulib::MixGains& g) noexcept
+{
+    using Vec = typename Ops::Vec;
+    using Lanes = GainLanes<Ops, Channels, Gain, Panned>;
+    constexpr int width = Ops::width;
+    constexpr int unroll = Lanes::period == 1 ? 2 : Lanes::period;
+
+    const int samples = frames * Channels;
+    const int vecEnd = samples - samples % (width * unroll);
+    Lanes lanes(g);
+
+    for (int i = 0; i < vecEnd; i += width * unroll) {
+        Vec s[unroll];
+        Vec d[unroll];
+        for (int k = 0; k < unroll; ++k) {
+            s[k] = Ops::load(src + i + k * width);
+            d[k] = Ops::load(dst + i + k * width);
+        }
+
+        for (int k = 0; k < unroll; ++k) {
+            const int p = k % Lanes::period;
+            if (Gain == Aulib::MixGain::Unity) {
+                d[k] = Ops::add(d[k], s[k]);
+            } else if (Gain == Aulib::MixGain::Constant) {
+                d[k] = Ops::add(d[k], Ops::mul(s[k], lanes.base[p]));
+            } else {
+                d[k] = Ops::add(d[k], Ops::mul(s[k], lanes.next(p)));
+            }
+        }
+
+        for (int k = 0; k < unroll; ++k) {
+            Ops::store(dst + i + k * width, d[k]);
+        }
+    }
+
+    mixScalar<Channels, Gain, Panned>(dst, src, vecEnd / Channels, frames, g);
+}
+
+// Each vector of mono samples is duplicated into two vectors of stereo frames.
+template <typename Ops, Aulib::MixGain Gain>
+inline void upmixSimd(float dst[], const float src[], const int frames,
+                      const Aulib::MixGains& g) noexcept
+{
+    using Vec = typename Ops::Vec;
+    constexpr int width = Ops::width;
+
+    const int vecEnd = frames - frames % width;
+    GainLanes<Ops, 2, Gain, true> lanes(g);
+
+    for (int i = 0; i < vecEnd; i += width) {
+        Vec s0;
+        Vec s1;
+        Ops::duplicate(Ops::load(src + i), s0, s1);
+        Vec d0 = Ops::load(dst + i * 2);
+        Vec d1 = Ops::load(dst + i * 2 + width);
+
+        if (Gain == Aulib::MixGain::Unity) {
+            d0 = Ops::add(d0, s0);
+            d1 = Ops::add(d1, s1);
+        } else if (Gain == Aulib::MixGain::Constant) {
+            d0 = Ops::add(d0, Ops::mul(s0, lanes.base[0]));
+            d1 = Ops::add(d1, Ops::mul(s1, lanes.base[0]));
+        } else {
+            const Vec g0 = lanes.next(0);
+            const Vec g1 = lanes.next(0);
+            d0 = Ops::add(d0, Ops::mul(s0, g0));
+            d1 = Ops::add(d1, Ops::mul(s1, g1));
+        }
+
+        Ops::store(dst + i * 2, d0);
+        Ops::store(dst + i * 2 + width, d1);
+    }
+
+    upmixScalar<Gain>(dst, src, vecEnd, frames, g);
+}
+
+inline void layoutScalar(float dst[], const float src[], const int firstFrame, const int endFrame,
+                         const Aulib::LayoutMatrix& m) noexcept
+{
+    const int inChannels = m.inChannels;
+    const int outChannels = m.outChannels;
+    for (int frame = firstFrame; frame < endFrame; ++frame) {
+        const float* in = src + frame * inChannels;
+        float* out = dst + frame * outChannels;
+        for (int o = 0; o < outChannels; ++o) {
+            float acc = in[0] * m.columns[0][o];
+            for (int i = 1; i < inChannels; ++i) {
+                acc += in[i] * m.columns[i][o];
+            }
+            out[o] = acc;
+        }
+    }
+}
+
+/*
+ * Each output frame is the sum of the matrix columns, scaled by the input samples. Output frames
+ * are stored as whole vectors, which spill over into the next frame. That gets overwritten right
+ * after, except at the end, where the last few frames are done by the scalar loop instead.
+ *
+ * 'Vecs' is the amount of vectors per output frame.
+ */
+template <typename Ops, int Vecs>
+inline void layoutVecs(float dst[], const float src[], const int frames,
+                       const Aulib::LayoutMatrix& m) noexcept
+{
+    using Vec = typename Ops::Vec;
+    constexpr int width = Ops::width;
+
+    for (int frame = 0; frame < frames; ++frame) {
+        const float* in = src + frame * m.inChannels;
+        float* out = dst + frame * m.outChannels;
+        Vec acc[Vecs];
+        const Vec s0 = Ops::set1(in[0]);
+        for (int v = 0; v < Vecs; ++v) {
+            acc[v] = Ops::mul(s0, Ops::load(m.columns[0] + v * width));
+        }
+        for (int i = 1; i < m.inChannels; ++i) {
+            const Vec si = Ops::set1(in[i]);
+            for (int v = 0; v < Vecs; ++v) {
+                acc[v] = Ops::add(acc[v], Ops::mul(si, Ops::load(m.columns[i] + v * width)));
+            }
+        }
+        for (int v = 0; v < Vecs; ++v) {
+            Ops::store(out + v * width, acc[v]);
+        }
+    }
+}
+
+template <typename Ops>
+inline void layoutSimd(float dst[], const float src[], const int frames,
+                       const Aulib::LayoutMatrix& m) noexcept
+{
+    constexpr int width = Ops::width;
+    static_assert(Aulib::MAX_CHANNELS % width == 0, "matrix columns must hold whole vectors");
+
+    const int outChannels = m.outChannels;
+    const int vecs = (outChannels + width - 1) / width;
+    const int spill = vecs * width - outChannels;
+    const int vecFrames = maxOf(frames - (spill + outChannels - 1) / outChannels, 0);
+
+    if (vecs == 1) {
+        layoutVecs<Ops, 1>(dst, src, vecFrames, m);
+    } else if constexpr (Aulib::MAX_CHANNELS / width >= 2) {
+        layoutVecs<Ops, 2>(dst, src, vecFrames, m);
+    }
+    layoutScalar(dst, src, vecFrames, frames, m);
+}
+
+template <typename Ops, int Channels, Aulib::MixGain Gain, bool Panned>
+void mixKernel(float dst[], const float src[], const int frames, const Aulib::MixGains& g)
+{
+    if constexpr (std::is_same<Ops, ScalarOps>::value) {
+        mixScalar<Channels, Gain, Panned>(dst, src, 0, frames, g);
+    } else {
+        mixSimd<Ops, Channels, Gain, Panned>(dst, src, frames, g);
+    }
+}
+
+template <typename Ops, Aulib::MixGain Gain>
+void upmixKernel(float dst[], const float src[], const int frames, const Aulib::MixGains& g)
+{
+    if constexpr (std::is_same<Ops, ScalarOps>::value) {
+        upmixScalar<Gain>(dst, src, 0, frames, g);
+    } else {
+        upmixSimd<Ops, Gain>(dst, src, frames, g);
+    }
+}
+
+template <typename Ops>
+void layoutKernel(float dst[], const float src[], const int frames, const Aulib::LayoutMatrix& m)
+{
+    if constexpr (std::is_same<Ops, ScalarOps>::value) {
+        layoutScalar(dst, src, 0, frames, m);
+    } else {
+        layoutSimd<Ops>(dst, src, frames, m);
+    }
+}
+
+template <typename Ops, int Channels>
+auto selectKernel(const Aulib::MixGain gain, const bool panned) noexcept -> Aulib::MixFunc
+{
+    using Aulib::MixGain;
+
+    // Panning doesn't apply to mono, and unity gain is never panned.
+    const bool usePan = panned and Channels > 1;
+    switch (gain) {
+    case MixGain::Unity:
+        return mixKernel<Ops, Channels, MixGain::Unity, false>;
+    case MixGain::Constant:
+        return usePan ? mixKernel<Ops, Channels, MixGain::Constant, true>
+                      : mixKernel<Ops, Channels, MixGain::Constant, false>;
+    case MixGain::Ramp:
+        return usePan ? mixKernel<Ops, Channels, MixGain::Ramp, true>
+                      : mixKernel<Ops, Channels, MixGain::Ramp, false>;
+    case MixGain::Fade:
+        return usePan ? mixKernel<Ops, Channels, MixGain::Fade, true>
+                      : mixKernel<Ops, Channels, MixGain::Fade, false>;
+    }
+    return nullptr;
+}
+
+template <typename Ops>
+auto selectKernel(const int channels, const Aulib::MixGain gain, const bool panned) noexcept
+    -> Aulib::MixFunc
+{
+    switch (channels) {
+    case 1:
+        return selectKernel<Ops, 1>(gain, panned);
+    case 2:
+        return selectKernel<Ops, 2>(gain, panned);
+    case 3:
+        return selectKernel<Ops, 3>(gain, panned);
+    case 4:
+        return selectKernel<Ops, 4>(gain, panned);
+    case 5:
+        return selectKernel<Ops, 5>(gain, panned);
+    case 6:
+        return selectKernel<Ops, 6>(gain, panned);
+    case 7:
+        return selectKernel<Ops, 7>(gain, panned);
+    case 8:
+        return selectKernel<Ops, 8>(gain, panned);
+    default:
+        return nullptr;
+    }
+}
+
+template <typename Ops>
+auto selectUpmixKernel(const Aulib::MixGain gain) noexcept -> Aulib::MixFunc
+{
+    using Aulib::MixGain;
+
+    switch (gain) {
+    case MixGain::Unity:
+        return upmixKernel<Ops, MixGain::Unity>;
+    case MixGain::Constant:
+        return upmixKernel<Ops, MixGain::Constant>;
+    case MixGain::Ramp:
+        return upmixKernel<Ops, MixGain::Ramp>;
+    case MixGain::Fade:
+        return upmixKernel<Ops, MixGain::Fade>;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
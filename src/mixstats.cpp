@@ -0,0 +1,341 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "Aulib/MixerStats.h"
+
+#include "mixstats.h"
+#include "stream_p.h"
+#if ENABLE_MIXER_STATS
+#    include <algorithm>
+#    include <array>
+#    include <cmath>
+#    include <cstdlib>
+#    if defined(__GNUG__)
+#        include <cxxabi.h>
+#    endif
+#endif
+
+namespace chrono = std::chrono;
+
+#if ENABLE_MIXER_STATS
+namespace {
+
+/*
+ * Callback durations are put into buckets of microseconds. Durations below 4us get a bucket each.
+ * Above that, each power of two is split into four buckets. The last bucket starts at about 1.8s
+ * and also holds anything longer.
+ */
+constexpr int HISTOGRAM_BUCKETS = 80;
+
+auto bucketOf(const Uint64 us) noexcept -> int
+{
+    if (us < 4) {
+        return static_cast<int>(us);
+    }
+    int octave = 2;
+    while ((us >> (octave + 1)) != 0) {
+        ++octave;
+    }
+    const int sub = static_cast<int>((us >> (octave - 2)) & 3);
+    return std::min(4 * (octave - 1) + sub, HISTOGRAM_BUCKETS - 1);
+}
+
+auto bucketStart(const int bucket) noexcept -> Uint64
+{
+    if (bucket < 4) {
+        return bucket;
+    }
+    const int octave = bucket / 4 + 1;
+    return static_cast<Uint64>(4 + bucket % 4) << (octave - 2);
+}
+
+constexpr int MAX_DECODER_TYPES = 32;
+
+struct DecoderSlot final
+{
+    std::atomic<const std::type_info*> type{nullptr};
+    std::atomic<Uint64> ns{0};
+    std::atomic<Uint64> calls{0};
+};
+
+std::atomic<Uint64> gCallbacks{0};
+std::atomic<Uint64> gOverruns{0};
+std::atomic<Uint64> gLateCallbacks{0};
+std::atomic<Uint64> gPeriodNs{0};
+std::atomic<Uint64> gLastNs{0};
+std::atomic<Uint64> gTotalNs{0};
+std::atomic<Uint64> gTotalPeriodNs{0};
+std::atomic<Uint64> gMaxNs{0};
+// In millionths.
+std::atomic<Uint64> gPeakLoad{0};
+std::array<std::atomic<Uint64>, HISTOGRAM_BUCKETS> gHistogram{};
+std::array<DecoderSlot, MAX_DECODER_TYPES> gDecoders{};
+
+// Only used by the audio callback thread.
+Uint64 gPrevStart = 0;
+Uint64 gPrevPeriod = 0;
+
+thread_local Aulib::MixStats::StreamCounters* gCurrentStream = nullptr;
+// Total time of the stages that finished on this thread. Lets an enclosing stage find out how much
+// of its time went to the stages nested in it.
+thread_local Uint64 gNestedNs = 0;
+
+auto nowNs() noexcept -> Uint64
+{
+    return chrono::duration_cast<chrono::nanoseconds>(
+               chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Only the audio callback thread writes these, so there's no need for a compare-exchange loop.
+void storeMax(std::atomic<Uint64>& max, const Uint64 value) noexcept
+{
+    if (value > max.load(std::memory_order_relaxed)) {
+        max.store(value, std::memory_order_relaxed);
+    }
+}
+
+void add(std::atomic<Uint64>& counter, const Uint64 value) noexcept
+{
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+auto demangled(const char* name) -> std::string
+{
+#    if defined(__GNUG__)
+    int status = -1;
+    char* buf = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0) {
+        std::string ret = buf;
+        std::free(buf);
+        return ret;
+    }
+#    endif
+    return name;
+}
+
+} // namespace
+
+void Aulib::MixStats::StreamCounters::reset() noexcept
+{
+    decodeNs.store(0, std::memory_order_relaxed);
+    resampleNs.store(0, std::memory_order_relaxed);
+    processorNs.store(0, std::memory_order_relaxed);
+}
+
+Aulib::MixStats::Callback::Callback(const int frames, const int rate) noexcept
+    : fStart(nowNs())
+    , fPeriod(rate > 0 ? static_cast<Uint64>(frames) * 1000000000 / rate : 0)
+{
+    if (gPrevStart != 0 and fStart - gPrevStart > gPrevPeriod + gPrevPeriod / 2) {
+        add(gLateCallbacks, 1);
+    }
+    gPrevStart = fStart;
+    gPrevPeriod = fPeriod;
+}
+
+Aulib::MixStats::Callback::~Callback()
+{
+    const Uint64 elapsed = nowNs() - fStart;
+
+    gLastNs.store(elapsed, std::memory_order_relaxed);
+    gPeriodNs.store(fPeriod, std::memory_order_relaxed);
+    add(gTotalNs, elapsed);
+    add(gTotalPeriodNs, fPeriod);
+    storeMax(gMaxNs, elapsed);
+    if (fPeriod > 0) {
+        storeMax(gPeakLoad, elapsed * 1000000 / fPeriod);
+    }
+    if (elapsed > fPeriod) {
+        add(gOverruns, 1);
+    }
+    add(gHistogram[bucketOf(elapsed / 1000)], 1);
+    // Last, so that readers never see more callbacks than were accounted for.
+    gCallbacks.fetch_add(1, std::memory_order_release);
+}
+
+Aulib::MixStats::StreamScope::StreamScope(StreamCounters& counters) noexcept
+    : fPrev(gCurrentStream)
+{
+    gCurrentStream = &counters;
+}
+
+Aulib::MixStats::StreamScope::~StreamScope()
+{
+    gCurrentStream = fPrev;
+}
+
+Aulib::MixStats::Timer::Timer(const Stage stage) noexcept
+    : fCounters(gCurrentStream)
+    , fStage(stage)
+{
+    if (fCounters) {
+        fPrevNested = gNestedNs;
+        fStart = nowNs();
+    }
+}
+
+Aulib::MixStats::Timer::~Timer()
+{
+    if (not fCounters) {
+        return;
+    }
+    const Uint64 elapsed = nowNs() - fStart;
+    const Uint64 own = elapsed - std::min(elapsed, gNestedNs - fPrevNested);
+    gNestedNs = fPrevNested + elapsed;
+
+    switch (fStage) {
+    case Stage::Decode:
+        add(fCounters->decodeNs, own);
+        if (fCounters->decoderType >= 0) {
+            add(gDecoders[fCounters->decoderType].ns, own);
+            add(gDecoders[fCounters->decoderType].calls, 1);
+        }
+        break;
+    case Stage::Resample:
+        add(fCounters->resampleNs, own);
+        break;
+    case Stage::Processor:
+        add(fCounters->processorNs, own);
+        break;
+    }
+}
+
+auto Aulib::MixStats::decoderTypeSlot(const std::type_info& type) noexcept -> int
+{
+    for (int i = 0; i < MAX_DECODER_TYPES; ++i) {
+        const std::type_info* slotType = nullptr;
+        if (gDecoders[i].type.compare_exchange_strong(slotType, &type)) {
+            return i;
+        }
+        // The same type can have more than one type_info object when shared libraries are
+        // involved, so compare the types and not the pointers.
+        if (*slotType == type) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void Aulib::MixStats::restart() noexcept
+{
+    gPrevStart = 0;
+}
+#endif
+
+auto Aulib::mixerStats() -> MixerStats
+{
+    MixerStats stats;
+#if ENABLE_MIXER_STATS
+    const auto load = [](const Uint64 ns, const Uint64 periodNs) {
+        return periodNs > 0 ? static_cast<float>(static_cast<double>(ns) / periodNs) : 0.f;
+    };
+
+    stats.enabled = true;
+    stats.callbacks = gCallbacks.load(std::memory_order_acquire);
+    stats.overruns = gOverruns.load(std::memory_order_relaxed);
+    stats.lateCallbacks = gLateCallbacks.load(std::memory_order_relaxed);
+    const Uint64 periodNs = gPeriodNs.load(std::memory_order_relaxed);
+    const Uint64 lastNs = gLastNs.load(std::memory_order_relaxed);
+    const Uint64 totalNs = gTotalNs.load(std::memory_order_relaxed);
+    stats.period = chrono::nanoseconds(periodNs);
+    stats.lastDuration = chrono::nanoseconds(lastNs);
+    stats.maxDuration = chrono::nanoseconds(gMaxNs.load(std::memory_order_relaxed));
+    if (stats.callbacks > 0) {
+        stats.meanDuration = chrono::nanoseconds(totalNs / stats.callbacks);
+    }
+    stats.lastLoad = load(lastNs, periodNs);
+    stats.meanLoad = load(totalNs, gTotalPeriodNs.load(std::memory_order_relaxed));
+    stats.peakLoad = gPeakLoad.load(std::memory_order_relaxed) / 1000000.f;
+
+    std::array<Uint64, HISTOGRAM_BUCKETS> counts;
+    Uint64 total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        counts[i] = gHistogram[i].load(std::memory_order_relaxed);
+        total += counts[i];
+        if (counts[i] > 0) {
+            stats.histogram.push_back({chrono::microseconds(bucketStart(i)),
+                                       chrono::microseconds(bucketStart(i + 1)), counts[i]});
+        }
+    }
+
+    // Interpolates linearly inside the bucket the percentile falls into.
+    const auto percentile = [&](const double fraction) {
+        if (total == 0) {
+            return chrono::nanoseconds{};
+        }
+        const auto rank = static_cast<Uint64>(std::ceil(fraction * total));
+        Uint64 below = 0;
+        for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            if (below + counts[i] >= rank) {
+                const double start = bucketStart(i) * 1000.;
+                const double width = (bucketStart(i + 1) - bucketStart(i)) * 1000.;
+                return chrono::nanoseconds(
+                    static_cast<Sint64>(start + width * (rank - below) / counts[i]));
+            }
+            below += counts[i];
+        }
+        return chrono::nanoseconds{};
+    };
+    // The interpolation can overshoot the longest callback we actually saw.
+    stats.p50 = std::min(percentile(0.5), stats.maxDuration);
+    stats.p90 = std::min(percentile(0.9), stats.maxDuration);
+    stats.p99 = std::min(percentile(0.99), stats.maxDuration);
+    stats.p999 = std::min(percentile(0.999), stats.maxDuration);
+#endif
+    return stats;
+}
+
+auto Aulib::decoderStats() -> std::vector<DecoderStats>
+{
+    std::vector<DecoderStats> stats;
+#if ENABLE_MIXER_STATS
+    for (const auto& slot : gDecoders) {
+        const std::type_info* type = slot.type.load();
+        if (not type) {
+            break;
+        }
+        stats.push_back({demangled(type->name()),
+                         chrono::nanoseconds(slot.ns.load(std::memory_order_relaxed)),
+                         slot.calls.load(std::memory_order_relaxed)});
+    }
+#endif
+    return stats;
+}
+
+void Aulib::resetMixerStats()
+{
+#if ENABLE_MIXER_STATS
+    for (auto* counter : {&gCallbacks, &gOverruns, &gLateCallbacks, &gPeriodNs, &gLastNs,
+                          &gTotalNs, &gTotalPeriodNs, &gMaxNs, &gPeakLoad}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    for (auto& bucket : gHistogram) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    for (auto& slot : gDecoders) {
+        slot.ns.store(0, std::memory_order_relaxed);
+        slot.calls.store(0, std::memory_order_relaxed);
+    }
+
+    Stream_priv::fResetStats();
+#endif
+}
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,129 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_config.h"
+
+/*
+ * Timing measurements of the mixer, see Aulib/MixerStats.h. Only compiled in when the library is
+ * built with ENABLE_MIXER_STATS. Otherwise, the macros below expand to nothing.
+ *
+ * AM_statsCallback() measures the audio callback until the end of the enclosing block.
+ * AM_statsStream() makes the given stream counters the ones that AM_statsTime() on the calling
+ * thread is charged to, until the end of the enclosing block. AM_statsTime() measures a stage of
+ * that stream until the end of the enclosing block. Stages can nest; the time of the inner stage
+ * is then not charged to the outer one. Without a stream, AM_statsTime() doesn't measure anything.
+ *
+ * Everything is updated with relaxed atomics, so readers never need to lock.
+ */
+#if ENABLE_MIXER_STATS
+#    include "aulib_global.h"
+#    include <SDL_stdinc.h>
+#    include <atomic>
+#    include <typeinfo>
+
+namespace Aulib {
+namespace MixStats {
+
+enum class Stage
+{
+    Decode,
+    Resample,
+    Processor,
+};
+
+// Per-stream totals, in nanoseconds.
+struct StreamCounters final
+{
+    std::atomic<Uint64> decodeNs{0};
+    std::atomic<Uint64> resampleNs{0};
+    std::atomic<Uint64> processorNs{0};
+    // Slot of the stream's decoder type in the decoder table, or -1 if the table is full.
+    int decoderType = -1;
+
+    void reset() noexcept;
+};
+
+class AULIB_NO_EXPORT Callback final
+{
+public:
+    Callback(int frames, int rate) noexcept;
+    ~Callback();
+
+    Callback(const Callback&) = delete;
+    auto operator=(const Callback&) -> Callback& = delete;
+
+private:
+    Uint64 fStart;
+    Uint64 fPeriod;
+};
+
+class AULIB_NO_EXPORT StreamScope final
+{
+public:
+    explicit StreamScope(StreamCounters& counters) noexcept;
+    ~StreamScope();
+
+    StreamScope(const StreamScope&) = delete;
+    auto operator=(const StreamScope&) -> StreamScope& = delete;
+
+private:
+    StreamCounters* fPrev;
+};
+
+class AULIB_NO_EXPORT Timer final
+{
+public:
+    explicit Timer(Stage stage) noexcept;
+    ~Timer();
+
+    Timer(const Timer&) = delete;
+    auto operator=(const Timer&) -> Timer& = delete;
+
+private:
+    StreamCounters* fCounters;
+    Stage fStage;
+    Uint64 fStart = 0;
+    Uint64 fPrevNested = 0;
+};
+
+// Returns the decoder table slot for a decoder type, adding it if needed. Never blocks.
+AULIB_NO_EXPORT auto decoderTypeSlot(const std::type_info& type) noexcept -> int;
+
+// Forgets the previous callback, so that the gap until the next one isn't counted as late. Call
+// when (re)starting the audio device.
+AULIB_NO_EXPORT void restart() noexcept;
+
+} // namespace MixStats
+} // namespace Aulib
+
+#    define AM_statsCallback(frames, rate) \
+        const Aulib::MixStats::Callback am_statsCallback((frames), (rate))
+#    define AM_statsStream(counters) const Aulib::MixStats::StreamScope am_statsStream(counters)
+#    define AM_statsTime(stage) \
+        const Aulib::MixStats::Timer am_statsTimer(Aulib::MixStats::Stage::stage)
+#else
+#    define AM_statsCallback(frames, rate)
+#    define AM_statsStream(counters)
+#    define AM_statsTime(stage)
+#endif
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
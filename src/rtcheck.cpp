@@ -0,0 +1,238 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "rtcheck.h"
+
+#include "aulib_log.h"
+#include "missing.h"
+#include <SDL_stdinc.h>
+#include <SDL_version.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#if defined(__GNUG__)
+#    include <cxxabi.h>
+#endif
+
+// Only trivially initialized thread-locals here, since they're used from operator new.
+static thread_local int gDepth = 0;
+static thread_local int gSuspended = 0;
+static thread_local bool gReported = false;
+static thread_local const char* gKind = nullptr;
+static thread_local const char* gName = nullptr;
+
+Aulib::RtCheck::Scope::Scope() noexcept
+{
+    if (gDepth++ == 0) {
+        gReported = false;
+    }
+}
+
+Aulib::RtCheck::Scope::~Scope()
+{
+    --gDepth;
+}
+
+Aulib::RtCheck::Context::Context(const char* const kind, const char* const name) noexcept
+    : fPrevKind(gKind)
+    , fPrevName(gName)
+{
+    gKind = kind;
+    gName = name;
+}
+
+Aulib::RtCheck::Context::~Context()
+{
+    gKind = fPrevKind;
+    gName = fPrevName;
+}
+
+void Aulib::RtCheck::violation(const char* const what) noexcept
+{
+    if (gDepth == 0 or gSuspended > 0 or gReported) {
+        return;
+    }
+    gReported = true;
+
+    // Reporting allocates.
+    ++gSuspended;
+    if (not gKind) {
+        aulib::log::warnLn("Real-time violation in audio callback: {}.", what);
+    } else if (not gName) {
+        aulib::log::warnLn("Real-time violation in audio callback: {} in {}.", what, gKind);
+    } else {
+        const char* name = gName;
+#if defined(__GNUG__)
+        int status = -1;
+        char* demangled = abi::__cxa_demangle(gName, nullptr, nullptr, &status);
+        if (status == 0) {
+            name = demangled;
+        }
+#endif
+        aulib::log::warnLn("Real-time violation in audio callback: {} in {} {}.", what, gKind,
+                           name);
+#if defined(__GNUG__)
+        std::free(demangled);
+#endif
+    }
+    --gSuspended;
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 7)
+static SDL_malloc_func gSdlMalloc = nullptr;
+static SDL_calloc_func gSdlCalloc = nullptr;
+static SDL_realloc_func gSdlRealloc = nullptr;
+static SDL_free_func gSdlFree = nullptr;
+
+extern "C" {
+static auto checkedSdlMalloc(size_t size) -> void*
+{
+    Aulib::RtCheck::violation("SDL_malloc()");
+    return gSdlMalloc(size);
+}
+
+static auto checkedSdlCalloc(size_t nmemb, size_t size) -> void*
+{
+    Aulib::RtCheck::violation("SDL_calloc()");
+    return gSdlCalloc(nmemb, size);
+}
+
+static auto checkedSdlRealloc(void* mem, size_t size) -> void*
+{
+    Aulib::RtCheck::violation("SDL_realloc()");
+    return gSdlRealloc(mem, size);
+}
+
+static void checkedSdlFree(void* mem)
+{
+    if (mem) {
+        Aulib::RtCheck::violation("SDL_free()");
+    }
+    gSdlFree(mem);
+}
+}
+#endif
+
+void Aulib::RtCheck::install()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 7)
+    if (gSdlMalloc) {
+        return;
+    }
+    // The original functions keep being used underneath, so memory allocated before this point can
+    // still be freed. Only allocations that go through SDL are seen this way. Libraries that call
+    // malloc() and free() themselves, like most decoder libraries, are not checked.
+    SDL_GetMemoryFunctions(&gSdlMalloc, &gSdlCalloc, &gSdlRealloc, &gSdlFree);
+    SDL_SetMemoryFunctions(checkedSdlMalloc, checkedSdlCalloc, checkedSdlRealloc, checkedSdlFree);
+#endif
+}
+
+/*
+ * Replacements for the global allocation functions. The sized and nothrow variants end up calling
+ * these. The aligned variants don't, since standard libraries implement them with their own aligned
+ * allocation function, so they are replaced further below.
+ */
+auto operator new(const std::size_t size) -> void*
+{
+    Aulib::RtCheck::violation("memory allocation");
+    if (void* const mem = std::malloc(size > 0 ? size : 1)) {
+        return mem;
+    }
+    Aulib::priv::throw_(std::bad_alloc());
+}
+
+auto operator new[](const std::size_t size) -> void*
+{
+    return operator new(size);
+}
+
+void operator delete(void* const mem) noexcept
+{
+    if (mem) {
+        Aulib::RtCheck::violation("memory deallocation");
+    }
+    std::free(mem);
+}
+
+void operator delete[](void* const mem) noexcept
+{
+    operator delete(mem);
+}
+
+void operator delete(void* const mem, std::size_t /*size*/) noexcept
+{
+    operator delete(mem);
+}
+
+void operator delete[](void* const mem, std::size_t /*size*/) noexcept
+{
+    operator delete(mem);
+}
+
+// Over-aligned allocations keep the pointer malloc() returned right before the aligned block, since
+// there's no portable aligned allocation function that is freed with free().
+auto operator new(const std::size_t size, const std::align_val_t align) -> void*
+{
+    Aulib::RtCheck::violation("memory allocation");
+    const auto alignment = std::max(static_cast<std::size_t>(align), alignof(void*));
+    const std::size_t overhead = alignment - 1 + sizeof(void*);
+    if (size <= std::numeric_limits<std::size_t>::max() - overhead) {
+        if (void* const raw = std::malloc(size + overhead)) {
+            const auto addr = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+            const auto mem = reinterpret_cast<void**>((addr + alignment - 1) & ~(alignment - 1));
+            mem[-1] = raw;
+            return mem;
+        }
+    }
+    Aulib::priv::throw_(std::bad_alloc());
+}
+
+auto operator new[](const std::size_t size, const std::align_val_t align) -> void*
+{
+    return operator new(size, align);
+}
+
+void operator delete(void* const mem, std::align_val_t /*align*/) noexcept
+{
+    if (not mem) {
+        return;
+    }
+    Aulib::RtCheck::violation("memory deallocation");
+    std::free(static_cast<void**>(mem)[-1]);
+}
+
+void operator delete[](void* const mem, const std::align_val_t align) noexcept
+{
+    operator delete(mem, align);
+}
+
+void operator delete(void* const mem, std::size_t /*size*/, const std::align_val_t align) noexcept
+{
+    operator delete(mem, align);
+}
+
+void operator delete[](void* const mem, std::size_t /*size*/, const std::align_val_t align) noexcept
+{
+    operator delete(mem, align);
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,88 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_config.h"
+
+/*
+ * Real-time safety checks for the audio callback. Only compiled in when the library is built with
+ * ENABLE_RT_CHECKS. Otherwise, the macros below expand to nothing.
+ *
+ * AM_rtScope() marks the calling thread as doing work for the audio callback until the end of the
+ * enclosing block. Memory allocations, deallocations and mutex locks on such a thread are reported
+ * as warnings, along with what was running at the time, as set by AM_rtContext(). Only the first
+ * violation of each callback is reported.
+ *
+ * Allocations are seen when they go through operator new or SDL's memory functions. Libraries that
+ * call malloc() directly are not checked.
+ */
+#if ENABLE_RT_CHECKS
+#    include "aulib_global.h"
+#    include <typeinfo>
+
+namespace Aulib {
+namespace RtCheck {
+
+class AULIB_NO_EXPORT Scope final
+{
+public:
+    Scope() noexcept;
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    auto operator=(const Scope&) -> Scope& = delete;
+};
+
+class AULIB_NO_EXPORT Context final
+{
+public:
+    // 'kind' and 'name' must outlive the context. 'name' is a type name as returned by
+    // std::type_info::name(), or null.
+    Context(const char* kind, const char* name) noexcept;
+    ~Context();
+
+    Context(const Context&) = delete;
+    auto operator=(const Context&) -> Context& = delete;
+
+private:
+    const char* fPrevKind;
+    const char* fPrevName;
+};
+
+// Reports a violation if the calling thread is inside a scope.
+AULIB_NO_EXPORT void violation(const char* what) noexcept;
+
+// Routes SDL's memory functions through the checks.
+AULIB_NO_EXPORT void install();
+
+} // namespace RtCheck
+} // namespace Aulib
+
+#    define AM_rtScope() const Aulib::RtCheck::Scope am_rtScope
+#    define AM_rtContext(kind, name) const Aulib::RtCheck::Context am_rtContext((kind), (name))
+#    define AM_rtViolation(what) Aulib::RtCheck::violation(what)
+#else
+#    define AM_rtScope()
+#    define AM_rtContext(kind, name)
+#    define AM_rtViolation(what)
+#endif
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -1,11 +1,15 @@
 // This is copyrighted software. More information is at the end of this file.
 #include "sampleconv.h"
 
-#include "Buffer.h"
 #include "missing.h"
+#include "simd.h"
+#include <SDL_cpuinfo.h>
 #include <SDL_endian.h>
 #include <SDL_version.h>
+#include <algorithm>
+#include <array>
 #include <limits>
+#include <type_traits>
 
 /* Convert and clip a float sample to an integer sample. This works for
  * all supported integer sample types (8-bit, 16-bit, 32-bit, signed or
@@ -20,18 +24,23 @@ static constexpr auto floatSampleToInt(const float src) noexcept -> T
     if (src < -1.f) {
         return std::numeric_limits<T>::min();
     }
-    return src * static_cast<float>(1UL << (sizeof(T) * 8 - 1))
-           + (static_cast<float>(1UL << (sizeof(T) * 8 - 1))
-              + static_cast<float>(std::numeric_limits<T>::min()));
+    const float sample = src * static_cast<float>(1UL << (sizeof(T) * 8 - 1))
+                         + (static_cast<float>(1UL << (sizeof(T) * 8 - 1))
+                            + static_cast<float>(std::numeric_limits<T>::min()));
+    // For unsigned types, values just below 1.0 can round up to max + 1.
+    if (sample > static_cast<float>(std::numeric_limits<T>::max())) {
+        return std::numeric_limits<T>::max();
+    }
+    return static_cast<T>(sample);
 }
 
 /* Convert float samples into integer samples.
  */
 template <typename T>
-static void floatToInt(Uint8 dst[], const Buffer<float>& src) noexcept
+static void floatToInt(Uint8 dst[], const float src[], const int len) noexcept
 {
-    for (auto i : src) {
-        auto sample = floatSampleToInt<T>(i);
+    for (int i = 0; i < len; ++i) {
+        auto sample = floatSampleToInt<T>(src[i]);
         memcpy(dst, &sample, sizeof(sample));
         dst += sizeof(sample);
     }
@@ -40,103 +49,643 @@ static void floatToInt(Uint8 dst[], const Buffer<float>& src) noexcept
 /* Convert float samples to endian-swapped integer samples.
  */
 template <typename T>
-static void floatToSwappedInt(Uint8 dst[], const Buffer<float>& src) noexcept
+static void floatToSwappedInt(Uint8 dst[], const float src[], const int len) noexcept
 {
     static_assert(sizeof(T) == 2 or sizeof(T) == 4, "");
 
-    for (const auto i : src) {
-        const T sample = sizeof(sample) == 2 ? SDL_Swap16(floatSampleToInt<T>(i))
-                                             : SDL_Swap32(floatSampleToInt<T>(i));
+    for (int i = 0; i < len; ++i) {
+        const T sample = sizeof(sample) == 2 ? SDL_Swap16(floatSampleToInt<T>(src[i]))
+                                             : SDL_Swap32(floatSampleToInt<T>(src[i]));
         memcpy(dst, &sample, sizeof(sample));
         dst += sizeof(sample);
     }
 }
 
 template <typename T>
-static void floatToLsbInt(Uint8 dst[], const Buffer<float>& src) noexcept
+static void floatToLsbInt(Uint8 dst[], const float src[], const int len) noexcept
 {
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
-    floatToInt<T>(dst, src);
+    floatToInt<T>(dst, src, len);
 #else
-    floatToSwappedInt<T>(dst, src);
+    floatToSwappedInt<T>(dst, src, len);
 #endif
 }
 
 template <typename T>
-static void floatToMsbInt(Uint8 dst[], const Buffer<float>& src) noexcept
+static void floatToMsbInt(Uint8 dst[], const float src[], const int len) noexcept
 {
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
-    floatToInt<T>(dst, src);
+    floatToInt<T>(dst, src, len);
 #else
-    floatToSwappedInt<T>(dst, src);
+    floatToSwappedInt<T>(dst, src, len);
 #endif
 }
 
-void Aulib::floatToS8(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToS8(Uint8 dst[], const float src[], const int len) noexcept
 {
-    floatToInt<Sint8>(dst, src);
+    floatToInt<Sint8>(dst, src, len);
 }
 
-void Aulib::floatToU8(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToU8(Uint8 dst[], const float src[], const int len) noexcept
 {
-    floatToInt<Uint8>(dst, src);
+    floatToInt<Uint8>(dst, src, len);
 }
 
-void Aulib::floatToS16LSB(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToS16LSB(Uint8 dst[], const float src[], const int len) noexcept
 {
-    floatToLsbInt<Sint16>(dst, src);
+    floatToLsbInt<Sint16>(dst, src, len);
 }
 
-void Aulib::floatToU16LSB(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToU16LSB(Uint8 dst[], const float src[], const int len) noexcept
 {
-    floatToLsbInt<Uint16>(dst, src);
+    floatToLsbInt<Uint16>(dst, src, len);
 }
 
-void Aulib::floatToS16MSB(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToS16MSB(Uint8 dst[], const float src[], const int len) noexcept
 {
-    floatToMsbInt<Sint16>(dst, src);
+    floatToMsbInt<Sint16>(dst, src, len);
 }
 
-void Aulib::floatToU16MSB(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToU16MSB(Uint8 dst[], const float src[], const int len) noexcept
 {
-    floatToMsbInt<Uint16>(dst, src);
+    floatToMsbInt<Uint16>(dst, src, len);
 }
 
-void Aulib::floatToS32LSB(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToS32LSB(Uint8 dst[], const float src[], const int len) noexcept
 {
-    floatToLsbInt<Sint32>(dst, src);
+    floatToLsbInt<Sint32>(dst, src, len);
 }
 
-void Aulib::floatToS32MSB(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToS32MSB(Uint8 dst[], const float src[], const int len) noexcept
 {
-    floatToMsbInt<Sint32>(dst, src);
+    floatToMsbInt<Sint32>(dst, src, len);
 }
 
-static void floatToSwappedFloat(Uint8 dst[], const Buffer<float>& src) noexcept
+static void floatToSwappedFloat(Uint8 dst[], const float src[], const int len) noexcept
 {
-    for (const auto i : src) {
-        const auto swapped = SDL_SwapFloat(i);
+    for (int i = 0; i < len; ++i) {
+        const auto swapped = SDL_SwapFloat(src[i]);
         memcpy(dst, &swapped, sizeof(swapped));
         dst += sizeof(swapped);
     }
 }
 
-void Aulib::floatToFloatLSB(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToFloatLSB(Uint8 dst[], const float src[], const int len) noexcept
 {
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
-    memcpy(dst, src.get(), src.usize() * sizeof(*src.get()));
+    memcpy(dst, src, static_cast<size_t>(len) * sizeof(*src));
 #else
-    floatToSwappedFloat(dst, src);
+    floatToSwappedFloat(dst, src, len);
 #endif
 }
 
-void Aulib::floatToFloatMSB(Uint8 dst[], const Buffer<float>& src) noexcept
+void Aulib::floatToFloatMSB(Uint8 dst[], const float src[], const int len) noexcept
 {
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
-    memcpy(dst, src.get(), src.size() * sizeof(*src.get()));
+    memcpy(dst, src, static_cast<size_t>(len) * sizeof(*src));
 #else
-    floatToSwappedFloat(dst, src);
+    floatToSwappedFloat(dst, src, len);
+#endif
+}
+
+/*
+ * Vectorized converters. These produce exactly the same output as the scalar converters above: the
+ * scaling is done with the same float operations, the float to int conversion truncates just like
+ * the implicit conversion does, and clipping uses the same comparisons. Samples that don't fill a
+ * whole vector are converted with the scalar code.
+ */
+
+template <typename T, bool Swap>
+static void convertTail(Uint8 dst[], const float src[], const int begin, const int end) noexcept
+{
+    for (int i = begin; i < end; ++i) {
+        T sample = floatSampleToInt<T>(src[i]);
+        if (Swap and sizeof(T) == 2) {
+            sample = SDL_Swap16(sample);
+        } else if (Swap and sizeof(T) == 4) {
+            sample = SDL_Swap32(sample);
+        }
+        memcpy(dst + i * sizeof(T), &sample, sizeof(sample));
+    }
+}
+
+template <typename T>
+static constexpr auto intScale() noexcept -> float
+{
+    return static_cast<float>(1UL << (sizeof(T) * 8 - 1));
+}
+
+template <typename T>
+static constexpr auto intOffset() noexcept -> float
+{
+    return static_cast<float>(1UL << (sizeof(T) * 8 - 1))
+           + static_cast<float>(std::numeric_limits<T>::min());
+}
+
+#if AULIB_HAVE_SSE2
+namespace {
+
+struct Sse2Converter final
+{
+    // Converts 4 floats to 32-bit integers in the range of T.
+    template <typename T>
+    static auto toInt32(const __m128 x) noexcept -> __m128i
+    {
+        const __m128 scaled =
+            _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(intScale<T>())), _mm_set1_ps(intOffset<T>()));
+        const __m128i conv = _mm_cvttps_epi32(scaled);
+        const __m128i high = _mm_castps_si128(_mm_cmpge_ps(x, _mm_set1_ps(1.f)));
+        const __m128i low = _mm_castps_si128(_mm_cmplt_ps(x, _mm_set1_ps(-1.f)));
+        const __m128i maxVal = _mm_set1_epi32(std::numeric_limits<T>::max());
+        const __m128i minVal = _mm_set1_epi32(std::numeric_limits<T>::min());
+        __m128i res = _mm_or_si128(_mm_and_si128(high, maxVal), _mm_andnot_si128(high, conv));
+        res = _mm_or_si128(_mm_and_si128(low, minVal), _mm_andnot_si128(low, res));
+        return res;
+    }
+
+    static auto swap16(const __m128i v) noexcept -> __m128i
+    {
+        return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    }
+
+    static auto swap32(const __m128i v) noexcept -> __m128i
+    {
+        // Swap the 16-bit halves, then the bytes within them.
+        const __m128i halves = _mm_shufflehi_epi16(
+            _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        return swap16(halves);
+    }
+
+    // Converts and stores 16 samples.
+    template <typename T, bool Swap>
+    static void convert16(Uint8 dst[], const float src[]) noexcept
+    {
+        const __m128i a = toInt32<T>(_mm_loadu_ps(src));
+        const __m128i b = toInt32<T>(_mm_loadu_ps(src + 4));
+        const __m128i c = toInt32<T>(_mm_loadu_ps(src + 8));
+        const __m128i d = toInt32<T>(_mm_loadu_ps(src + 12));
+        auto* out = reinterpret_cast<__m128i*>(dst);
+
+        if constexpr (std::is_same<T, Sint8>::value) {
+            _mm_storeu_si128(out, _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+        } else if constexpr (std::is_same<T, Uint8>::value) {
+            _mm_storeu_si128(out, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+        } else if constexpr (sizeof(T) == 2) {
+            __m128i lo;
+            __m128i hi;
+            if constexpr (std::is_signed<T>::value) {
+                lo = _mm_packs_epi32(a, b);
+                hi = _mm_packs_epi32(c, d);
+            } else {
+                // There's no unsigned 32 to 16 bit pack in SSE2. Shift into the signed range, pack,
+                // and shift back.
+                const __m128i bias32 = _mm_set1_epi32(0x8000);
+                const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+                lo = _mm_xor_si128(
+                    _mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32)), bias16);
+                hi = _mm_xor_si128(
+                    _mm_packs_epi32(_mm_sub_epi32(c, bias32), _mm_sub_epi32(d, bias32)), bias16);
+            }
+            if (Swap) {
+                lo = swap16(lo);
+                hi = swap16(hi);
+            }
+            _mm_storeu_si128(out, lo);
+            _mm_storeu_si128(out + 1, hi);
+        } else {
+            const __m128i v[]{a, b, c, d};
+            for (int i = 0; i < 4; ++i) {
+                _mm_storeu_si128(out + i, Swap ? swap32(v[i]) : v[i]);
+            }
+        }
+    }
+
+    static void swapFloat4(Uint8 dst[], const float src[]) noexcept
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                         swap32(_mm_castps_si128(_mm_loadu_ps(src))));
+    }
+
+    // Converts 8 integer samples to float.
+    static void toFloat8(float dst[], const Sint16 src[], const float scale) noexcept
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        // Sign-extend to 32 bits by moving each sample to the upper half and shifting it back.
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(lo), _mm_set1_ps(scale)));
+        _mm_storeu_ps(dst + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), _mm_set1_ps(scale)));
+    }
+
+    static void toFloat8(float dst[], const Sint32 src[], const float scale) noexcept
+    {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4));
+        _mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(lo), _mm_set1_ps(scale)));
+        _mm_storeu_ps(dst + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), _mm_set1_ps(scale)));
+    }
+
+    // Interleaves or splits 4 stereo frames.
+    static void interleave4(float dst[], const float left[], const float right[]) noexcept
+    {
+        const __m128 l = _mm_loadu_ps(left);
+        const __m128 r = _mm_loadu_ps(right);
+        _mm_storeu_ps(dst, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(dst + 4, _mm_unpackhi_ps(l, r));
+    }
+
+    static void deinterleave4(float left[], float right[], const float src[]) noexcept
+    {
+        const __m128 a = _mm_loadu_ps(src);
+        const __m128 b = _mm_loadu_ps(src + 4);
+        _mm_storeu_ps(left, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+};
+
+} // namespace
+#endif
+
+#if AULIB_HAVE_NEON
+namespace {
+
+struct NeonConverter final
+{
+    template <typename T>
+    static auto toInt32(const float32x4_t x) noexcept -> int32x4_t
+    {
+        const float32x4_t scaled =
+            vaddq_f32(vmulq_f32(x, vdupq_n_f32(intScale<T>())), vdupq_n_f32(intOffset<T>()));
+        const int32x4_t conv = vcvtq_s32_f32(scaled);
+        const uint32x4_t high = vcgeq_f32(x, vdupq_n_f32(1.f));
+        const uint32x4_t low = vcltq_f32(x, vdupq_n_f32(-1.f));
+        int32x4_t res = vbslq_s32(high, vdupq_n_s32(std::numeric_limits<T>::max()), conv);
+        res = vbslq_s32(low, vdupq_n_s32(std::numeric_limits<T>::min()), res);
+        return res;
+    }
+
+    template <typename T, bool Swap>
+    static void convert16(Uint8 dst[], const float src[]) noexcept
+    {
+        const int32x4_t a = toInt32<T>(vld1q_f32(src));
+        const int32x4_t b = toInt32<T>(vld1q_f32(src + 4));
+        const int32x4_t c = toInt32<T>(vld1q_f32(src + 8));
+        const int32x4_t d = toInt32<T>(vld1q_f32(src + 12));
+
+        if constexpr (std::is_same<T, Sint8>::value) {
+            const int16x8_t lo = vcombine_s16(vqmovn_s32(a), vqmovn_s32(b));
+            const int16x8_t hi = vcombine_s16(vqmovn_s32(c), vqmovn_s32(d));
+            vst1q_s8(reinterpret_cast<int8_t*>(dst), vcombine_s8(vqmovn_s16(lo), vqmovn_s16(hi)));
+        } else if constexpr (std::is_same<T, Uint8>::value) {
+            const int16x8_t lo = vcombine_s16(vqmovn_s32(a), vqmovn_s32(b));
+            const int16x8_t hi = vcombine_s16(vqmovn_s32(c), vqmovn_s32(d));
+            vst1q_u8(dst, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+        } else if constexpr (sizeof(T) == 2) {
+            uint8x16_t lo;
+            uint8x16_t hi;
+            if constexpr (std::is_signed<T>::value) {
+                lo = vreinterpretq_u8_s16(vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+                hi = vreinterpretq_u8_s16(vcombine_s16(vqmovn_s32(c), vqmovn_s32(d)));
+            } else {
+                lo = vreinterpretq_u8_u16(vcombine_u16(vqmovun_s32(a), vqmovun_s32(b)));
+                hi = vreinterpretq_u8_u16(vcombine_u16(vqmovun_s32(c), vqmovun_s32(d)));
+            }
+            if (Swap) {
+                lo = vrev16q_u8(lo);
+                hi = vrev16q_u8(hi);
+            }
+            vst1q_u8(dst, lo);
+            vst1q_u8(dst + 16, hi);
+        } else {
+            const int32x4_t v[]{a, b, c, d};
+            for (int i = 0; i < 4; ++i) {
+                uint8x16_t bytes = vreinterpretq_u8_s32(v[i]);
+                if (Swap) {
+                    bytes = vrev32q_u8(bytes);
+                }
+                vst1q_u8(dst + i * 16, bytes);
+            }
+        }
+    }
+
+    static void swapFloat4(Uint8 dst[], const float src[]) noexcept
+    {
+        vst1q_u8(dst, vrev32q_u8(vreinterpretq_u8_f32(vld1q_f32(src))));
+    }
+
+    static void toFloat8(float dst[], const Sint16 src[], const float scale) noexcept
+    {
+        const int16x8_t x = vld1q_s16(src);
+        vst1q_f32(dst, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+        vst1q_f32(dst + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+    }
+
+    static void toFloat8(float dst[], const Sint32 src[], const float scale) noexcept
+    {
+        vst1q_f32(dst, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src)), scale));
+        vst1q_f32(dst + 4, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src + 4)), scale));
+    }
+
+    static void interleave4(float dst[], const float left[], const float right[]) noexcept
+    {
+        vst2q_f32(dst, float32x4x2_t{{vld1q_f32(left), vld1q_f32(right)}});
+    }
+
+    static void deinterleave4(float left[], float right[], const float src[]) noexcept
+    {
+        const float32x4x2_t v = vld2q_f32(src);
+        vst1q_f32(left, v.val[0]);
+        vst1q_f32(right, v.val[1]);
+    }
+};
+
+} // namespace
+#endif
+
+template <typename Impl, typename T, bool Swap>
+static void floatToIntSimd(Uint8 dst[], const float src[], const int len) noexcept
+{
+    const float* const in = src;
+    const int vecEnd = len - len % 16;
+
+    for (int i = 0; i < vecEnd; i += 16) {
+        Impl::template convert16<T, Swap>(dst + i * sizeof(T), in + i);
+    }
+    convertTail<T, Swap>(dst, in, vecEnd, len);
+}
+
+template <typename Impl>
+static void floatToSwappedFloatSimd(Uint8 dst[], const float src[], const int len) noexcept
+{
+    const float* const in = src;
+    const int vecEnd = len - len % 4;
+
+    for (int i = 0; i < vecEnd; i += 4) {
+        Impl::swapFloat4(dst + i * sizeof(float), in + i);
+    }
+    for (int i = vecEnd; i < len; ++i) {
+        const auto swapped = SDL_SwapFloat(in[i]);
+        memcpy(dst + i * sizeof(swapped), &swapped, sizeof(swapped));
+    }
+}
+
+template <typename Impl>
+static auto simdConverterFor(const Aulib::AudioFormat format) noexcept -> Aulib::SampleConverter
+{
+    constexpr bool swapLsb = SDL_BYTEORDER == SDL_BIG_ENDIAN;
+    constexpr bool swapMsb = not swapLsb;
+
+    switch (format) {
+    case AUDIO_S8:
+        return floatToIntSimd<Impl, Sint8, false>;
+    case AUDIO_U8:
+        return floatToIntSimd<Impl, Uint8, false>;
+    case AUDIO_S16LSB:
+        return floatToIntSimd<Impl, Sint16, swapLsb>;
+    case AUDIO_U16LSB:
+        return floatToIntSimd<Impl, Uint16, swapLsb>;
+    case AUDIO_S16MSB:
+        return floatToIntSimd<Impl, Sint16, swapMsb>;
+    case AUDIO_U16MSB:
+        return floatToIntSimd<Impl, Uint16, swapMsb>;
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+    case AUDIO_S32LSB:
+        return floatToIntSimd<Impl, Sint32, swapLsb>;
+    case AUDIO_S32MSB:
+        return floatToIntSimd<Impl, Sint32, swapMsb>;
+    // Native float output is a plain memcpy, which can't be beaten.
+    case AUDIO_F32LSB:
+        return swapLsb ? floatToSwappedFloatSimd<Impl> : nullptr;
+    case AUDIO_F32MSB:
+        return swapMsb ? floatToSwappedFloatSimd<Impl> : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+auto Aulib::simdSampleConverterFor(const AudioFormat format) noexcept -> SampleConverter
+{
+#if AULIB_HAVE_SSE2
+    if (SDL_HasSSE2()) {
+        return simdConverterFor<Sse2Converter>(format);
+    }
+#endif
+#if AULIB_HAVE_NEON and SDL_VERSION_ATLEAST(2, 0, 6)
+    if (SDL_HasNEON()) {
+        return simdConverterFor<NeonConverter>(format);
+    }
+#endif
+    static_cast<void>(format);
+    return nullptr;
+}
+
+/*
+ * Kernels for decoders: integer to float conversion and (de)interleaving. Converting to float
+ * rounds the same way in the scalar and vector code, and the scale is a power of two, so the
+ * results match exactly.
+ */
+
+template <typename T>
+static constexpr auto intToFloatScale() noexcept -> float
+{
+    return 1.f / intScale<T>();
+}
+
+template <typename T>
+static void intToFloatTail(float dst[], const T src[], const int begin, const int end,
+                           const float scale) noexcept
+{
+    for (int i = begin; i < end; ++i) {
+        dst[i] = static_cast<float>(src[i]) * scale;
+    }
+}
+
+template <typename T>
+static void intToFloat(float dst[], const T src[], const int len, const float scale) noexcept
+{
+    intToFloatTail(dst, src, 0, len, scale);
+}
+
+static void interleaveStereo(float dst[], const float left[], const float right[], const int begin,
+                             const int end) noexcept
+{
+    for (int i = begin; i < end; ++i) {
+        dst[i * 2] = left[i];
+        dst[i * 2 + 1] = right[i];
+    }
+}
+
+static void deinterleaveStereo(float left[], float right[], const float src[], const int begin,
+                               const int end) noexcept
+{
+    for (int i = begin; i < end; ++i) {
+        left[i] = src[i * 2];
+        right[i] = src[i * 2 + 1];
+    }
+}
+
+static void interleaveStereo(float dst[], const float left[], const float right[],
+                             const int frames) noexcept
+{
+    interleaveStereo(dst, left, right, 0, frames);
+}
+
+static void deinterleaveStereo(float left[], float right[], const float src[],
+                               const int frames) noexcept
+{
+    deinterleaveStereo(left, right, src, 0, frames);
+}
+
+#if AULIB_HAVE_SSE2 or AULIB_HAVE_NEON
+template <typename Impl, typename T>
+static void intToFloatSimd(float dst[], const T src[], const int len, const float scale) noexcept
+{
+    const int vecEnd = len - len % 8;
+
+    for (int i = 0; i < vecEnd; i += 8) {
+        Impl::toFloat8(dst + i, src + i, scale);
+    }
+    intToFloatTail(dst, src, vecEnd, len, scale);
+}
+
+template <typename Impl>
+static void interleaveStereoSimd(float dst[], const float left[], const float right[],
+                                 const int frames) noexcept
+{
+    const int vecEnd = frames - frames % 4;
+
+    for (int i = 0; i < vecEnd; i += 4) {
+        Impl::interleave4(dst + i * 2, left + i, right + i);
+    }
+    interleaveStereo(dst, left, right, vecEnd, frames);
+}
+
+template <typename Impl>
+static void deinterleaveStereoSimd(float left[], float right[], const float src[],
+                                   const int frames) noexcept
+{
+    const int vecEnd = frames - frames % 4;
+
+    for (int i = 0; i < vecEnd; i += 4) {
+        Impl::deinterleave4(left + i, right + i, src + i * 2);
+    }
+    deinterleaveStereo(left, right, src, vecEnd, frames);
+}
 #endif
+
+namespace {
+
+// The decoder kernels for the CPU we're running on.
+struct DecoderKernels final
+{
+    void (*s16ToFloat)(float[], const Sint16[], int, float) = intToFloat<Sint16>;
+    void (*s32ToFloat)(float[], const Sint32[], int, float) = intToFloat<Sint32>;
+    void (*interleaveStereo)(float[], const float[], const float[], int) = ::interleaveStereo;
+    void (*deinterleaveStereo)(float[], float[], const float[], int) = ::deinterleaveStereo;
+
+    DecoderKernels() noexcept
+    {
+#if AULIB_HAVE_SSE2
+        if (SDL_HasSSE2()) {
+            set<Sse2Converter>();
+            return;
+        }
+#endif
+#if AULIB_HAVE_NEON and SDL_VERSION_ATLEAST(2, 0, 6)
+        if (SDL_HasNEON()) {
+            set<NeonConverter>();
+        }
+#endif
+    }
+
+    template <typename Impl>
+    void set() noexcept
+    {
+        s16ToFloat = intToFloatSimd<Impl, Sint16>;
+        s32ToFloat = intToFloatSimd<Impl, Sint32>;
+        interleaveStereo = interleaveStereoSimd<Impl>;
+        deinterleaveStereo = deinterleaveStereoSimd<Impl>;
+    }
+};
+
+auto decoderKernels() noexcept -> const DecoderKernels&
+{
+    static const DecoderKernels kernels;
+    return kernels;
+}
+
+} // namespace
+
+void Aulib::s16ToFloat(float dst[], const Sint16 src[], const int len) noexcept
+{
+    decoderKernels().s16ToFloat(dst, src, len, intToFloatScale<Sint16>());
+}
+
+void Aulib::s24ToFloat(float dst[], const Uint8 src[], const int len) noexcept
+{
+    // Put each sample into the upper 24 bits of a 32-bit integer and convert that. The low byte is
+    // zero, so this gives the same result as scaling the 24-bit value.
+    constexpr int CHUNK = 64;
+    std::array<Sint32, CHUNK> tmp;
+
+    for (int done = 0; done < len; done += CHUNK) {
+        const int count = std::min(CHUNK, len - done);
+        const Uint8* in = src + done * 3;
+        for (int i = 0; i < count; ++i, in += 3) {
+            tmp[i] = static_cast<Sint32>(static_cast<Uint32>(in[0]) << 8
+                                         | static_cast<Uint32>(in[1]) << 16
+                                         | static_cast<Uint32>(in[2]) << 24);
+        }
+        s32ToFloat(dst + done, tmp.data(), count);
+    }
+}
+
+void Aulib::s32ToFloat(float dst[], const Sint32 src[], const int len) noexcept
+{
+    decoderKernels().s32ToFloat(dst, src, len, intToFloatScale<Sint32>());
+}
+
+void Aulib::s32ToFloat(float dst[], const Sint32 src[], const int len, const int bits) noexcept
+{
+    const float scale = 1.f / static_cast<float>(1UL << (bits - 1));
+    decoderKernels().s32ToFloat(dst, src, len, scale);
+}
+
+void Aulib::interleave(float dst[], const float* const planes[], const int channels,
+                       const int frames) noexcept
+{
+    if (channels == 1) {
+        memcpy(dst, planes[0], static_cast<size_t>(frames) * sizeof(*dst));
+        return;
+    }
+    if (channels == 2) {
+        decoderKernels().interleaveStereo(dst, planes[0], planes[1], frames);
+        return;
+    }
+    for (int i = 0; i < frames; ++i) {
+        for (int chan = 0; chan < channels; ++chan) {
+            *dst++ = planes[chan][i];
+        }
+    }
+}
+
+void Aulib::deinterleave(float* const planes[], const float src[], const int channels,
+                         const int frames) noexcept
+{
+    if (channels == 1) {
+        memcpy(planes[0], src, static_cast<size_t>(frames) * sizeof(*src));
+        return;
+    }
+    if (channels == 2) {
+        decoderKernels().deinterleaveStereo(planes[0], planes[1], src, frames);
+        return;
+    }
+    for (int i = 0; i < frames; ++i) {
+        for (int chan = 0; chan < channels; ++chan) {
+            planes[chan][i] = *src++;
+        }
+    }
 }
 
 /*
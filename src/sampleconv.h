@@ -1,24 +1,44 @@
 // This is copyrighted software. More information is at the end of this file.
 #pragma once
 
+#include "aulib.h"
 #include "aulib_global.h"
 #include <SDL_stdinc.h>
 
-template <typename T>
-class Buffer;
-
 namespace Aulib {
 
-AULIB_NO_EXPORT void floatToS8(Uint8 dst[], const Buffer<float>& src) noexcept;
-AULIB_NO_EXPORT void floatToU8(Uint8 dst[], const Buffer<float>& src) noexcept;
-AULIB_NO_EXPORT void floatToS16LSB(Uint8 dst[], const Buffer<float>& src) noexcept;
-AULIB_NO_EXPORT void floatToU16LSB(Uint8 dst[], const Buffer<float>& src) noexcept;
-AULIB_NO_EXPORT void floatToS16MSB(Uint8 dst[], const Buffer<float>& src) noexcept;
-AULIB_NO_EXPORT void floatToU16MSB(Uint8 dst[], const Buffer<float>& src) noexcept;
-AULIB_NO_EXPORT void floatToS32LSB(Uint8 dst[], const Buffer<float>& src) noexcept;
-AULIB_NO_EXPORT void floatToS32MSB(Uint8 dst[], const Buffer<float>& src) noexcept;
-AULIB_NO_EXPORT void floatToFloatLSB(Uint8 dst[], const Buffer<float>& src) noexcept;
-AULIB_NO_EXPORT void floatToFloatMSB(Uint8 dst[], const Buffer<float>& src) noexcept;
+using SampleConverter = void (*)(Uint8 dst[], const float src[], int len);
+
+AULIB_NO_EXPORT void floatToS8(Uint8 dst[], const float src[], int len) noexcept;
+AULIB_NO_EXPORT void floatToU8(Uint8 dst[], const float src[], int len) noexcept;
+AULIB_NO_EXPORT void floatToS16LSB(Uint8 dst[], const float src[], int len) noexcept;
+AULIB_NO_EXPORT void floatToU16LSB(Uint8 dst[], const float src[], int len) noexcept;
+AULIB_NO_EXPORT void floatToS16MSB(Uint8 dst[], const float src[], int len) noexcept;
+AULIB_NO_EXPORT void floatToU16MSB(Uint8 dst[], const float src[], int len) noexcept;
+AULIB_NO_EXPORT void floatToS32LSB(Uint8 dst[], const float src[], int len) noexcept;
+AULIB_NO_EXPORT void floatToS32MSB(Uint8 dst[], const float src[], int len) noexcept;
+AULIB_NO_EXPORT void floatToFloatLSB(Uint8 dst[], const float src[], int len) noexcept;
+AULIB_NO_EXPORT void floatToFloatMSB(Uint8 dst[], const float src[], int len) noexcept;
+
+// Returns a vectorized converter for the given format, if there is one for it that the CPU
+// supports. Its output is identical to that of the scalar converter for the same format.
+AULIB_NO_EXPORT auto simdSampleConverterFor(AudioFormat format) noexcept -> SampleConverter;
+
+// Converters for integer samples produced by decoders. Samples are scaled by 1/2^(bits - 1), so
+// the most negative integer becomes -1.0. Vectorized when the CPU allows it. The output is the same
+// either way, and identical to dividing by 2^(bits - 1).
+AULIB_NO_EXPORT void s16ToFloat(float dst[], const Sint16 src[], int len) noexcept;
+// Packed 24-bit little endian samples, 3 bytes each.
+AULIB_NO_EXPORT void s24ToFloat(float dst[], const Uint8 src[], int len) noexcept;
+AULIB_NO_EXPORT void s32ToFloat(float dst[], const Sint32 src[], int len) noexcept;
+// 32-bit integers that hold 'bits' bit samples, like the output of libFLAC.
+AULIB_NO_EXPORT void s32ToFloat(float dst[], const Sint32 src[], int len, int bits) noexcept;
+
+// Convert between interleaved samples and one buffer per channel. Stereo is vectorized.
+AULIB_NO_EXPORT void interleave(float dst[], const float* const planes[], int channels,
+                                int frames) noexcept;
+AULIB_NO_EXPORT void deinterleave(float* const planes[], const float src[], int channels,
+                                  int frames) noexcept;
 
 } // namespace Aulib
 
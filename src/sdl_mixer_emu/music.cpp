@@ -30,8 +30,11 @@ auto Mix_LoadMUS(const char* file) -> Mix_Music*
 {
     aulib::log::debugLn("{}", __func__);
 
-    auto strm = new Aulib::Stream(file, Aulib::Decoder::decoderFor(file),
-                                  std::make_unique<Aulib::ResamplerSpeex>());
+    auto probed = Aulib::Decoder::probe(file);
+    if (not probed) {
+        return nullptr;
+    }
+    auto strm = new Aulib::Stream(std::move(probed), std::make_unique<Aulib::ResamplerSpeex>());
     strm->open();
     return (Mix_Music*)strm;
 }
@@ -40,8 +43,11 @@ auto Mix_LoadMUS_RW(SDL_RWops* rw) -> Mix_Music*
 {
     aulib::log::debugLn("{}", __func__);
 
-    auto strm = new Aulib::Stream(rw, Aulib::Decoder::decoderFor(rw),
-                                  std::make_unique<Aulib::ResamplerSpeex>(), false);
+    auto probed = Aulib::Decoder::probe(rw, false);
+    if (not probed) {
+        return nullptr;
+    }
+    auto strm = new Aulib::Stream(std::move(probed), std::make_unique<Aulib::ResamplerSpeex>());
     strm->open();
     return (Mix_Music*)strm;
 }
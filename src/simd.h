@@ -0,0 +1,39 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+/*
+ * Detects which SIMD instruction sets we can generate code for without special compiler flags, and
+ * includes their intrinsics headers. Whether the CPU we end up running on actually supports them
+ * still needs to be checked at runtime.
+ */
+
+#if defined(__SSE2__) or defined(_M_X64) or (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+#    define AULIB_HAVE_SSE2 1
+#    include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) or defined(__ARM_NEON__) or defined(_M_ARM64)
+#    define AULIB_HAVE_NEON 1
+#    include <arm_neon.h>
+#endif
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
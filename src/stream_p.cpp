@@ -4,25 +4,46 @@
 #include "Aulib/Decoder.h"
 #include "Aulib/Resampler.h"
 #include "Aulib/Stream.h"
+#include "DecodePool.h"
+#include "DecoderPcm.h"
+#include "MixPool.h"
+#include "SdlAudioLocker.h"
+#include "mixkernels.h"
 #include "aulib_debug.h"
+#include "bus_p.h"
 #include "aulib_log.h"
 #include "missing.h"
+#include "missing/algorithm.h"
+#include "rtcheck.h"
+#include "trace.h"
 #include <SDL_timer.h>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <limits>
 #include <mutex>
-#include <type_traits>
 
-void (*Aulib::Stream_priv::fSampleConverter)(Uint8[], const Buffer<float>& src) = nullptr;
+void (*Aulib::Stream_priv::fSampleConverter)(Uint8[], const float[], int) = nullptr;
 SDL_AudioSpec Aulib::Stream_priv::fAudioSpec;
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 SDL_AudioDeviceID Aulib::Stream_priv::fDeviceId;
 #endif
-std::vector<Aulib::Stream*> Aulib::Stream_priv::fStreamList;
-SdlMutex Aulib::Stream_priv::fStreamListMutex;
-Buffer<float> Aulib::Stream_priv::fFinalMixBuf{0};
-Buffer<float> Aulib::Stream_priv::fStrmBuf{0};
-Buffer<float> Aulib::Stream_priv::fProcessorBuf{0};
+Aulib::VoiceTable Aulib::Stream_priv::fVoices;
+std::vector<std::unique_ptr<Aulib::Stream_priv::MixLane>> Aulib::Stream_priv::fMixLanes;
+bool Aulib::Stream_priv::fMixing = false;
+std::atomic<int> Aulib::Stream_priv::fNextMixStream{0};
+int Aulib::Stream_priv::fMixLenSamples = 0;
+Uint64 Aulib::Stream_priv::fMixedFrames = 0;
+Uint64 Aulib::Stream_priv::fLastCallbackTime = 0;
+std::atomic<int> Aulib::Stream_priv::fMaxRealVoices{0};
+std::vector<int> Aulib::Stream_priv::fVoiceRank;
+bool Aulib::Stream_priv::fOffline = false;
+SdlMutex Aulib::Stream_priv::fRenderMutex;
+MpscQueue<Aulib::Stream_priv::Command> Aulib::Stream_priv::fCommands{8192};
+
+// Commands of the batch the current thread has open, if any.
+static thread_local std::vector<Aulib::Stream_priv::Command> gBatch;
+static thread_local int gBatchDepth = 0;
 
 Aulib::Stream_priv::Stream_priv(Stream* pub, std::unique_ptr<Decoder> decoder,
                                 std::unique_ptr<Resampler> resampler, SDL_RWops* rwops,
@@ -36,192 +57,938 @@ Aulib::Stream_priv::Stream_priv(Stream* pub, std::unique_ptr<Decoder> decoder,
     if (fResampler) {
         fResampler->setDecoder(fDecoder);
     }
+#if ENABLE_MIXER_STATS
+    if (fDecoder) {
+        fStats.decoderType = MixStats::decoderTypeSlot(typeid(*fDecoder));
+    }
+#endif
+
+    SdlAudioLocker locker;
+
+    fSlot = fVoices.add(pub);
+    fGeneration = fVoices.generation[fSlot];
+    fReserveMixLists();
 }
 
 Aulib::Stream_priv::~Stream_priv()
 {
+    {
+        SdlAudioLocker locker;
+
+        fVoices.remove(fSlot);
+    }
     if (fCloseRw and fRWops) {
         SDL_RWclose(fRWops);
     }
 }
 
-auto Aulib::Stream_priv::fProcessFadeAndCheckIfFinished() -> bool
-{
-    static_assert(std::is_same<decltype(fFadeInDuration), std::chrono::milliseconds>::value, "");
-    static_assert(std::is_same<decltype(fFadeOutDuration), std::chrono::milliseconds>::value, "");
-
-    if (fFadingIn) {
-        Sint64 now = SDL_GetTicks();
-        Sint64 curPos = now - fFadeInStartTick;
-        if (curPos >= fFadeInDuration.count()) {
-            fInternalVolume = 1.f;
-            fFadingIn = false;
-            return false;
-        }
-        fInternalVolume =
-            std::pow(static_cast<float>(now - fFadeInStartTick) / fFadeInDuration.count(), 3.f);
-    } else if (fFadingOut) {
-        Sint64 now = SDL_GetTicks();
-        Sint64 curPos = now - fFadeOutStartTick;
-        if (curPos >= fFadeOutDuration.count()) {
-            fInternalVolume = 0.f;
-            fFadingIn = false;
-            if (fStopAfterFade) {
-                fStopAfterFade = false;
-                fStop();
-                return true;
-            }
-            fIsPaused = true;
-            return false;
+void Aulib::Stream_priv::fStartFade(const bool fadeIn, const std::chrono::microseconds duration)
+{
+    const Sint64 frames = duration.count() * fAudioSpec.freq / 1000000;
+    fFadeFrames = static_cast<int>(
+        Aulib::priv::clamp<Sint64>(frames, 1, std::numeric_limits<int>::max()));
+    // Start from the current level, so that reversing a fade midway doesn't jump.
+    const float level = std::cbrt(fInternalVolume);
+    fFadePos = static_cast<int>((fadeIn ? level : 1.f - level) * static_cast<float>(fFadeFrames));
+    fFadingIn = fadeIn;
+    fFadingOut = not fadeIn;
+}
+
+/* Advances the current fade by 'frames' output frames. The fade level is the cube of a linear
+ * curve; its value at the first frame and its per-frame step are stored in 'curvePos' and
+ * 'curveStep'. 'fadeFrames' receives how many of the frames are still inside the fade. Returns
+ * true if the fade ended.
+ */
+auto Aulib::Stream_priv::fAdvanceFade(const int frames, int& fadeFrames, float& curvePos,
+                                      float& curveStep) -> bool
+{
+    const float invLength = 1.f / static_cast<float>(fFadeFrames);
+    curvePos = static_cast<float>(fFadePos) * invLength;
+    curveStep = invLength;
+    if (fFadingOut) {
+        curvePos = 1.f - curvePos;
+        curveStep = -curveStep;
+    }
+
+    const int remaining = fFadeFrames - fFadePos;
+    if (remaining > frames) {
+        fFadePos += frames;
+        fadeFrames = frames;
+        const float end = curvePos + curveStep * static_cast<float>(frames);
+        fInternalVolume = end * end * end;
+        return false;
+    }
+    fadeFrames = std::max(0, remaining);
+    fInternalVolume = fFadingIn ? 1.f : 0.f;
+    fFadingIn = false;
+    fFadingOut = false;
+    return true;
+}
+
+void Aulib::Stream_priv::fSetPaused(const bool paused)
+{
+    fIsPaused = paused;
+    fVoices.paused[fSlot] = paused;
+}
+
+void Aulib::Stream_priv::fStop()
+{
+    // When stopped by the mixer, the callback takes the stream off the active list after mixing.
+    if (not fMixing) {
+        fVoices.deactivate(fSlot);
+    }
+    if (fVoices.decodeAhead[fSlot]) {
+        // A worker might be using the decoder right now, so rewind it before it's used again.
+        fProducerActive = false;
+        fResetPending = true;
+    } else if (fDecoder) {
+        // Can be null if the stream was created from a failed probe.
+        fDecoder->rewind();
+    }
+    fPosFrames = 0;
+    fNeedsSeek = false;
+    fIsPlaying = false;
+}
+
+auto Aulib::Stream_priv::fAudibility() const -> float
+{
+    if (fVoices.muted[fSlot]) {
+        return 0.f;
+    }
+    // A stream that fades in is going to be audible, even if it's silent right now.
+    const float level = fFadingIn ? 1.f : fInternalVolume;
+    const int bus = fVoices.bus[fSlot];
+    const float busGain = bus >= 0 ? Bus_priv::fBuses[bus]->fAudibleGain : 1.f;
+    return fVoices.volume[fSlot] * level * busGain;
+}
+
+/* Moves a virtual stream forward by 'frames' output frames without decoding anything. Returns true
+ * if the stream finished.
+ */
+auto Aulib::Stream_priv::fAdvanceVirtual(const int frames, bool& hasLooped) -> bool
+{
+    fNeedsSeek = true;
+    fPosFrames += frames;
+    while (fPosFrames >= fDurationFrames) {
+        fPosFrames -= fDurationFrames;
+        if (fFinishIteration(hasLooped)) {
+            fDecoder->rewind();
+            fPosFrames = 0;
+            fNeedsSeek = false;
+            return true;
         }
-        fInternalVolume = std::pow(
-            -static_cast<float>(now - fFadeOutStartTick) / fFadeOutDuration.count() + 1.f, 3.f);
     }
     return false;
 }
 
-void Aulib::Stream_priv::fStop()
+void Aulib::Stream_priv::fCatchUpWithVirtualPos()
 {
-    {
-        std::lock_guard<SdlMutex> lock(fStreamListMutex);
-        fStreamList.erase(std::remove(fStreamList.begin(), fStreamList.end(), this->q),
-                          fStreamList.end());
+    AM_traceScope("seek", typeid(*fDecoder).name());
+    fNeedsSeek = false;
+    const auto pos = std::chrono::microseconds(fPosFrames * 1000000 / fAudioSpec.freq);
+    // If the decoder can't seek, it just continues from where it was when it became virtual.
+    if (fDecoder->seekToTime(pos) and fResampler) {
+        fResampler->discardPendingSamples();
     }
-    fDecoder->rewind();
+}
+
+void Aulib::Stream_priv::fPostCommand(const Command::Type type, const float value)
+{
+    fPostCommand(Command{fSlot, fGeneration, type, {value}, 1});
+}
+
+void Aulib::Stream_priv::fPostCommand(const Command::Type type, const int value)
+{
+    Command cmd{fSlot, fGeneration, type, {}, 1};
+    cmd.intValue = value;
+    fPostCommand(cmd);
+}
+
+void Aulib::Stream_priv::fPostCommand(const Command::Type type, const Command::BusRef bus)
+{
+    Command cmd{fSlot, fGeneration, type, {}, 1};
+    cmd.bus = bus;
+    fPostCommand(cmd);
+}
+
+void Aulib::Stream_priv::fPostCommand(const Command& cmd)
+{
+    if (gBatchDepth > 0) {
+        gBatch.push_back(cmd);
+        return;
+    }
+    Command single = cmd;
+    fPostCommands(&single, 1);
+}
+
+void Aulib::Stream_priv::fDiscardBatchedCommands()
+{
+    gBatch.erase(std::remove_if(gBatch.begin(), gBatch.end(),
+                                [this](const Command& cmd) { return cmd.slot == fSlot; }),
+                 gBatch.end());
+}
+
+void Aulib::Stream_priv::fApplyCommand(const Command& cmd)
+{
+    if (cmd.generation != fVoices.generation[cmd.slot]) {
+        // The stream was deleted.
+        return;
+    }
+    const int slot = cmd.slot;
+    switch (cmd.type) {
+    case Command::Type::Volume:
+        fVoices.volume[slot] = cmd.value;
+        break;
+    case Command::Type::StereoPos:
+        fVoices.stereoPos[slot] = cmd.value;
+        break;
+    case Command::Type::Mute:
+        fVoices.muted[slot] = cmd.value != 0.f;
+        break;
+    case Command::Type::Priority:
+        fVoices.priority[slot] = cmd.intValue;
+        break;
+    case Command::Type::Bus: {
+        // The bus might have been deleted in the meantime, and its slot taken by another bus.
+        const auto& bus = cmd.bus;
+        const bool exists = bus.slot >= 0 and Bus_priv::fBuses[bus.slot]
+                            and Bus_priv::fGenerations[bus.slot] == bus.generation;
+        fVoices.bus[slot] = exists ? bus.slot : -1;
+        break;
+    }
+    }
+}
+
+void Aulib::Stream_priv::fPostCommands(Command cmds[], const int count)
+{
+    if (count <= 0) {
+        return;
+    }
+    cmds[0].batchSize = count;
+    if (fCommands.push(cmds, count)) {
+        return;
+    }
+
+    // The queue is full, or the batch doesn't fit in it. Apply the commands ourselves, after the
+    // ones that are already queued.
+    SdlAudioLocker locker;
+
+    fApplyCommands();
+    for (int i = 0; i < count; ++i) {
+        fApplyCommand(cmds[i]);
+    }
+}
+
+void Aulib::Stream_priv::fBeginBatch()
+{
+    ++gBatchDepth;
+}
+
+void Aulib::Stream_priv::fEndBatch()
+{
+    if (gBatchDepth == 0 or --gBatchDepth > 0) {
+        return;
+    }
+    fPostCommands(gBatch.data(), static_cast<int>(gBatch.size()));
+    gBatch.clear();
+}
+
+void Aulib::Stream_priv::fApplyCommands()
+{
+    for (;;) {
+        const Command* const first = fCommands.peek(0);
+        if (not first) {
+            return;
+        }
+        // Leave batches that are still being pushed for the next block.
+        const int count = first->batchSize;
+        if (count > 1 and not fCommands.peek(count - 1)) {
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            const Command& cmd = *fCommands.peek(i);
+            fApplyCommand(cmd);
+        }
+        fCommands.pop(count);
+    }
+}
+
+auto Aulib::Stream_priv::fFinishIteration(bool& hasLooped) -> bool
+{
+    const int wanted = fVoices.wantedIterations[fSlot];
+    if (wanted == 0) {
+        return false;
+    }
+    if (++fVoices.iteration[fSlot] < wanted) {
+        hasLooped = true;
+        return false;
+    }
+    // This only happens while mixing. The callback takes the stream off the active list afterwards.
     fIsPlaying = false;
+    fProducerActive = false;
+    return true;
 }
 
-void Aulib::Stream_priv::fSdlCallbackImpl(void* /*unused*/, Uint8 out[], int outLen)
+void Aulib::Stream_priv::fStartDecodeAhead(const int iterations)
 {
-    AM_debugAssert(Stream_priv::fSampleConverter);
+    if (not fInDecodePool) {
+        DecodePool::add(this);
+        fInDecodePool = true;
+    }
 
-    const int out_len_samples = outLen / (SDL_AUDIO_BITSIZE(fAudioSpec.format) / 8);
-    const int out_len_frames = out_len_samples / fAudioSpec.channels;
+    std::lock_guard<SdlMutex> lock(fDecodeMutex);
+    if (fResetPending) {
+        fDecoder->rewind();
+        if (fResampler) {
+            fResampler->discardPendingSamples();
+        }
+        fResetPending = false;
+    }
 
-    if (fStrmBuf.size() != out_len_samples) {
-        fFinalMixBuf.reset(out_len_samples);
-        fStrmBuf.reset(out_len_samples);
-        fProcessorBuf.reset(out_len_samples);
+    // Never buffer less than two output buffers worth of audio.
+    const int capacity = std::max(fDecodeAheadFrames, fAudioSpec.samples * 2) * fChannels;
+    if (fRing.capacity() != capacity) {
+        fRing.reset(capacity);
+    } else {
+        fRing.clear();
     }
+    fLoopEnds.clear();
+    fLastLoopEnd = 0;
+    fProducerIterations = 0;
+    fProducerWantedIterations = iterations;
+    fProducerFinished = false;
+    fProducerActive = true;
 
-    // Fill with silence.
-    std::fill(fFinalMixBuf.begin(), fFinalMixBuf.end(), 0.f);
+    // Have something ready for the first callback, without waiting for a worker.
+    fFillDecodeAhead();
+}
 
-    // Iterate over a copy of the original stream list, since we might want to
-    // modify the original as we go, removing streams that have stopped.
-    const std::vector<Stream*> streamList = [] {
-        std::lock_guard<SdlMutex> lock(fStreamListMutex);
-        return fStreamList;
-    }();
+void Aulib::Stream_priv::fEndDecodeAhead()
+{
+    if (fInDecodePool) {
+        DecodePool::remove(this);
+        fInDecodePool = false;
+    }
+
+    // Wait for any worker that is still filling this stream.
+    std::lock_guard<SdlMutex> lock(fDecodeMutex);
+    fProducerActive = false;
+    if (fResetPending) {
+        fDecoder->rewind();
+        if (fResampler) {
+            fResampler->discardPendingSamples();
+        }
+        fResetPending = false;
+    }
+}
 
-    const int now_tick = SDL_GetTicks();
-    const int wanted_ticks = out_len_frames * 1000 / fAudioSpec.freq;
+void Aulib::Stream_priv::fFlushDecodeAhead()
+{
+    // Caller holds both the audio lock and fDecodeMutex, so nobody is using the rings.
+    if (fResampler) {
+        fResampler->discardPendingSamples();
+    }
+    fRing.clear();
+    fLoopEnds.clear();
+    fLastLoopEnd = 0;
+    fProducerIterations = fVoices.iteration[fSlot];
+    fProducerFinished = false;
+    fResetPending = false;
+}
 
-    for (const auto stream : streamList) {
-        if (stream->d->fWantedIterations != 0
-            and stream->d->fCurrentIteration >= stream->d->fWantedIterations) {
-            continue;
+auto Aulib::Stream_priv::fDecodeAheadStarvation() const -> int
+{
+    if (not fProducerActive.load(std::memory_order_acquire)
+        or fProducerFinished.load(std::memory_order_relaxed)) {
+        return -1;
+    }
+    // Don't bother with tiny refills.
+    const int chunk = std::min(fAudioSpec.samples * fChannels, fRing.capacity());
+    if (fRing.writeAvailable() < chunk) {
+        return -1;
+    }
+    return fRing.size() / fChannels;
+}
+
+void Aulib::Stream_priv::fFillDecodeAhead()
+{
+    if (not fProducerActive or fProducerFinished) {
+        return;
+    }
+
+    const int channels = fChannels;
+    int len = 0;
+    float* const dst = fRing.writeRegion(len);
+    len = std::min(len, fAudioSpec.samples * channels);
+    len -= len % channels;
+    if (len <= 0) {
+        return;
+    }
+
+    AM_statsStream(fStats);
+    AM_traceScope("decode ahead", nullptr);
+    int got = 0;
+    if (fResampler) {
+        AM_statsTime(Resample);
+        got = fResampler->resample(dst, len);
+    } else {
+        bool callAgain = false;
+        do {
+            callAgain = false;
+            got += fDecoder->decode(dst + got, len - got, callAgain);
+        } while (got < len and callAgain);
+    }
+    fRing.commitWrite(got);
+    if (got >= len) {
+        return;
+    }
+
+    // End of stream. Let the consumer know where this iteration ends. If it's too far behind to
+    // take another loop boundary, we'll just hit EOF again on the next fill and retry.
+    if (not fLoopEnds.push(fRing.writeCount())) {
+        return;
+    }
+    fDecoder->rewind();
+    const bool emptyIteration = fRing.writeCount() == fLastLoopEnd;
+    fLastLoopEnd = fRing.writeCount();
+    if (fProducerWantedIterations != 0) {
+        ++fProducerIterations;
+        if (fProducerIterations >= fProducerWantedIterations) {
+            fProducerFinished = true;
         }
-        if (stream->d->fIsPaused) {
+    }
+    if (emptyIteration) {
+        // The decoder doesn't give us anything. Don't spin on it forever.
+        fProducerFinished = true;
+    }
+}
+
+auto Aulib::Stream_priv::fReadDecodeAhead(float dst[], const int len, bool& hasFinished,
+                                          bool& hasLooped) -> int
+{
+    int pos = 0;
+
+    while (pos < len) {
+        if (not fLoopEnds.empty() and fRing.readCount() >= fLoopEnds.front()) {
+            fLoopEnds.pop();
+            if (fFinishIteration(hasLooped)) {
+                hasFinished = true;
+                break;
+            }
             continue;
         }
 
-        const int ticks_since_play_start = now_tick - stream->d->fPlaybackStartTick;
-        if (ticks_since_play_start <= 0) {
+        int wanted = len - pos;
+        if (not fLoopEnds.empty()) {
+            wanted = static_cast<int>(
+                std::min<Uint64>(wanted, fLoopEnds.front() - fRing.readCount()));
+        }
+        const int got = fRing.read(dst + pos, wanted);
+        if (got == 0) {
+            if (not fLoopEnds.empty()) {
+                // The producer reached the end of the stream in the meantime.
+                continue;
+            }
+            if (not fProducerFinished) {
+                ++fUnderruns;
+            }
+            break;
+        }
+        pos += got;
+    }
+    return pos;
+}
+
+void Aulib::Stream_priv::fSetMixLaneCount(const int count)
+{
+    // Existing lanes keep their buffers, and new ones get buffers of the same size, so that the
+    // audio callback doesn't need to allocate them.
+    const int samples = fMixLanes.empty() ? 0 : fMixLanes[0]->strmBuf.size();
+    fMixLanes.resize(std::max(1, count));
+    for (auto& lane : fMixLanes) {
+        if (not lane) {
+            lane = std::make_unique<MixLane>();
+        }
+    }
+    fReserveMixLists();
+    fGrowMixBuffers(samples);
+}
+
+void Aulib::Stream_priv::fReserveMixLists()
+{
+    const auto capacity = static_cast<size_t>(fVoices.capacity());
+    fVoiceRank.resize(capacity);
+    for (const auto& lane : fMixLanes) {
+        lane->finished.reserve(capacity);
+        lane->looped.reserve(capacity);
+        lane->paused.reserve(capacity);
+    }
+}
+
+void Aulib::Stream_priv::fReserveBusBuffers()
+{
+    const auto busCount = Bus_priv::fBuses.size();
+    for (const auto& lane : fMixLanes) {
+        lane->busUsed.resize(busCount, false);
+        const int size = lane->strmBuf.size() * static_cast<int>(busCount);
+        if (lane->busBuf.size() < size) {
+            lane->busBuf.reset(size);
+        }
+    }
+}
+
+void Aulib::Stream_priv::fUnrouteBus(const Bus_priv& bus)
+{
+    // Streams might have been routed to the bus with commands we haven't applied yet.
+    fApplyCommands();
+    for (int slot = 0; slot < fVoices.capacity(); ++slot) {
+        if (not fVoices.stream[slot]) {
             continue;
         }
+        if (fVoices.bus[slot] == bus.fSlot) {
+            fVoices.bus[slot] = -1;
+        }
+        Bus* expected = bus.q;
+        fVoices.stream[slot]->d->fTargetBus.compare_exchange_strong(expected, nullptr);
+    }
+}
+
+void Aulib::Stream_priv::fSelectRealVoices()
+{
+    Bus_priv::fUpdateAudibleGains();
+
+    // Inaudible streams are always virtual. Decode-ahead streams never are, since the decode
+    // threads would keep decoding them anyway.
+    int candidates = 0;
+    for (const int slot : fVoices.activeSlots()) {
+        const Stream_priv& strm = *fVoices.stream[slot]->d;
+        const float audibility = strm.fAudibility();
+        const bool canBeVirtual = not fVoices.decodeAhead[slot] and strm.fDurationFrames > 0;
+        fVoices.audibility[slot] = audibility;
+        fVoices.isVirtual[slot] = canBeVirtual and audibility <= 0.f;
+        if (canBeVirtual and audibility > 0.f) {
+            fVoiceRank[candidates++] = slot;
+        }
+    }
 
-        bool has_finished = false;
-        bool has_looped = false;
-        const int out_offset = [&] {
-            if (!stream->d->fStarting || ticks_since_play_start >= wanted_ticks) {
-                return 0;
+    // Streams that can't be virtual count against the limit too.
+    const int maxReal = fMaxRealVoices.load(std::memory_order_relaxed);
+    const int realLimit = maxReal - (static_cast<int>(fVoices.activeSlots().size()) - candidates);
+    if (maxReal > 0 and candidates > realLimit) {
+        const int keep = std::max(0, realLimit);
+        auto preferred = [](const int a, const int b) {
+            if (fVoices.priority[a] != fVoices.priority[b]) {
+                return fVoices.priority[a] > fVoices.priority[b];
             }
+            return fVoices.audibility[a] > fVoices.audibility[b];
+        };
+        std::nth_element(fVoiceRank.begin(), fVoiceRank.begin() + keep,
+                         fVoiceRank.begin() + candidates, preferred);
+        for (int i = keep; i < candidates; ++i) {
+            fVoices.isVirtual[fVoiceRank[i]] = true;
+        }
+    }
+
+    for (const int slot : fVoices.activeSlots()) {
+        fVoices.stream[slot]->d->fIsVirtual.store(fVoices.isVirtual[slot] != 0,
+                                                  std::memory_order_relaxed);
+    }
+}
+
+#if ENABLE_MIXER_STATS
+void Aulib::Stream_priv::fResetStats()
+{
+    SdlAudioLocker locker;
 
-            const int out_offset_ticks = wanted_ticks - ticks_since_play_start;
-            const int offset = out_offset_ticks * fAudioSpec.channels * fAudioSpec.freq / 1000;
-            return offset - (offset % fAudioSpec.channels);
-        }();
-        int cur_pos = out_offset;
-        stream->d->fStarting = false;
-
-        while (cur_pos < out_len_samples) {
-            if (stream->d->fResampler) {
-                cur_pos += stream->d->fResampler->resample(fStrmBuf.get() + cur_pos,
-                                                           out_len_samples - cur_pos);
+    for (int i = 0; i < fVoices.capacity(); ++i) {
+        if (fVoices.stream[i]) {
+            fVoices.stream[i]->d->fStats.reset();
+        }
+    }
+}
+#endif
+
+void Aulib::Stream_priv::fMixStream(const int slot, MixLane& lane)
+{
+    if (fVoices.wantedIterations[slot] != 0
+        and fVoices.iteration[slot] >= fVoices.wantedIterations[slot]) {
+        return;
+    }
+    if (fVoices.paused[slot]) {
+        return;
+    }
+
+    // The stream starts after this block.
+    if (fVoices.startFrame[slot] >= fMixedFrames) {
+        return;
+    }
+
+    bool has_finished = false;
+    bool has_looped = false;
+    const int channels = fAudioSpec.channels;
+    const int blockFrames = fMixLenSamples / channels;
+    // Frames of the block that pass before the stream starts.
+    const int firstFrame = [&] {
+        const Uint64 blockStart = fMixedFrames - blockFrames;
+        if (not fVoices.starting[slot] or fVoices.startFrame[slot] <= blockStart) {
+            return 0;
+        }
+        return static_cast<int>(fVoices.startFrame[slot] - blockStart);
+    }();
+    const int out_offset = firstFrame * channels;
+    fVoices.starting[slot] = false;
+
+    // Positions in strmBuf count samples of the stream, which can have less channels than the
+    // output.
+    const int strmChannels = fVoices.channels[slot];
+    const int strmLen = blockFrames * strmChannels;
+    int cur_pos = firstFrame * strmChannels;
+
+    Stream* const stream = fVoices.stream[slot];
+    Resampler* const resampler = fVoices.resampler[slot];
+    DecoderPcm* const pcmDecoder = fVoices.pcmDecoder[slot];
+    const bool isVirtual = fVoices.isVirtual[slot];
+    AM_statsStream(stream->d->fStats);
+    // Where the samples to mix come from, the stream position of the first one, and their
+    // channels.
+    const float* mixSrc = lane.strmBuf.get();
+    int mixSrcStart = 0;
+    int mixSrcChannels = strmChannels;
+
+    if (fVoices.decodeAhead[slot]) {
+        cur_pos += stream->d->fReadDecodeAhead(lane.strmBuf.get() + cur_pos, strmLen - cur_pos,
+                                               has_finished, has_looped);
+    } else if (isVirtual) {
+        // Nothing gets decoded. We only keep track of where the stream would be.
+        has_finished = stream->d->fAdvanceVirtual(blockFrames - firstFrame, has_looped);
+        cur_pos = strmLen;
+    } else {
+        if (stream->d->fNeedsSeek) {
+            stream->d->fCatchUpWithVirtualPos();
+        }
+        int iterationStart = cur_pos;
+        // Decoded sounds in the output format are mixed straight out of their buffer when the rest
+        // of the block is in one piece.
+        if (pcmDecoder and not resampler and pcmDecoder->getChannels() == strmChannels
+            and stream->d->processors.empty())
+        {
+            if (const float* pcm = pcmDecoder->take(strmLen - cur_pos)) {
+                mixSrc = pcm;
+                mixSrcStart = cur_pos;
+                cur_pos = strmLen;
+            }
+        }
+        while (cur_pos < strmLen) {
+            if (resampler) {
+                AM_statsTime(Resample);
+                cur_pos += resampler->resample(lane.strmBuf.get() + cur_pos, strmLen - cur_pos);
             } else {
                 bool callAgain = false;
                 do {
                     callAgain = false;
-                    cur_pos += stream->d->fDecoder->decode(fStrmBuf.get() + cur_pos,
-                                                           out_len_samples - cur_pos, callAgain);
-                } while (cur_pos < out_len_samples and callAgain);
+                    cur_pos += stream->d->fDecoder->decode(lane.strmBuf.get() + cur_pos,
+                                                           strmLen - cur_pos, callAgain);
+                } while (cur_pos < strmLen and callAgain);
             }
-            for (const auto& proc : stream->d->processors) {
-                const int len = cur_pos - out_offset;
-                proc->process(fProcessorBuf.get() + out_offset, fStrmBuf.get() + out_offset, len);
-                std::memcpy(fStrmBuf.get() + out_offset, fProcessorBuf.get() + out_offset,
-                            len * sizeof(*fStrmBuf.get()));
-            }
-            if (cur_pos < out_len_samples) {
+            if (cur_pos < strmLen) {
                 stream->d->fDecoder->rewind();
-                if (stream->d->fWantedIterations != 0) {
-                    ++stream->d->fCurrentIteration;
-                    if (stream->d->fCurrentIteration >= stream->d->fWantedIterations) {
-                        stream->d->fIsPlaying = false;
-                        {
-                            std::lock_guard<SdlMutex> lock(fStreamListMutex);
-                            fStreamList.erase(
-                                std::remove(fStreamList.begin(), fStreamList.end(), stream),
-                                fStreamList.end());
-                        }
-                        has_finished = true;
-                        break;
-                    }
-                    has_looped = true;
+                stream->d->fPosFrames = 0;
+                iterationStart = cur_pos;
+                if (stream->d->fFinishIteration(has_looped)) {
+                    has_finished = true;
+                    break;
                 }
             }
         }
+        stream->d->fPosFrames += (cur_pos - iterationStart) / strmChannels;
+    }
 
-        has_finished |= stream->d->fProcessFadeAndCheckIfFinished();
+    const int frames = cur_pos / strmChannels - firstFrame;
 
-        float volumeLeft = stream->d->fVolume * stream->d->fInternalVolume;
-        float volumeRight = stream->d->fVolume * stream->d->fInternalVolume;
+    // Mono on a stereo device is mixed as is. Other layouts are converted first, and so is mono if
+    // there are processors, since those work on the output format.
+    float* procSrc = lane.strmBuf.get();
+    if (not isVirtual and frames > 0 and strmChannels != channels
+        and (strmChannels != 1 or channels != 2 or not stream->d->processors.empty()))
+    {
+        procSrc = lane.layoutBuf.get();
+        layoutKernelFor()(procSrc + out_offset, mixSrc + firstFrame * strmChannels - mixSrcStart,
+                          frames, stream->d->fLayout);
+        mixSrc = procSrc;
+        mixSrcStart = 0;
+        mixSrcChannels = channels;
+    }
 
-        if (fAudioSpec.channels > 1) {
-            if (stream->d->fStereoPos < 0.f) {
-                volumeRight *= 1.f + stream->d->fStereoPos;
-            } else if (stream->d->fStereoPos > 0.f) {
-                volumeLeft *= 1.f - stream->d->fStereoPos;
-            }
+    if (not isVirtual and frames > 0 and not stream->d->processors.empty()) {
+        const int len = frames * channels;
+        for (const auto& proc : stream->d->processors) {
+            AM_rtContext("processor", typeid(*proc).name());
+            AM_statsTime(Processor);
+            AM_traceScope("process", typeid(*proc).name());
+            proc->process(lane.procBuf.get() + out_offset, procSrc + out_offset, len);
+            std::memcpy(procSrc + out_offset, lane.procBuf.get() + out_offset,
+                        len * sizeof(*procSrc));
+        }
+    }
+
+    // The fade clock counts output frames, starting at this stream's first frame in the block. It
+    // keeps running even if the stream ran out of samples.
+    MixGains gains{};
+    int fadeFrames = 0;
+    bool fadeOutEnded = false;
+    if (stream->d->fFadingIn or stream->d->fFadingOut) {
+        const bool fadingOut = stream->d->fFadingOut;
+        fadeOutEnded = stream->d->fAdvanceFade(blockFrames - firstFrame, fadeFrames, gains.fade,
+                                               gains.fadeStep)
+                       and fadingOut;
+    }
+
+    float* mixBuf = lane.mixBuf.get();
+    if (const int bus = fVoices.bus[slot]; bus >= 0) {
+        mixBuf = lane.busBuffer(bus);
+        if (not lane.busUsed[bus]) {
+            std::fill(mixBuf, mixBuf + fMixLenSamples, 0.f);
+            lane.busUsed[bus] = true;
         }
+    }
+    float volumeLeft = fVoices.volume[slot];
+    float volumeRight = fVoices.volume[slot];
 
+    if (channels > 1) {
+        const float stereoPos = fVoices.stereoPos[slot];
+        if (stereoPos < 0.f) {
+            volumeRight *= 1.f + stereoPos;
+        } else if (stereoPos > 0.f) {
+            volumeLeft *= 1.f - stereoPos;
+        }
+    }
+    if (fVoices.muted[slot]) {
+        volumeLeft = volumeRight = 0.f;
+    }
+
+    // Ramp from the gain we used on the previous block, so that volume and pan changes don't click.
+    gains.left = volumeLeft;
+    gains.right = volumeRight;
+    if (fVoices.lastGainLeft[slot] >= 0.f) {
+        gains.left = fVoices.lastGainLeft[slot];
+        gains.right = fVoices.lastGainRight[slot];
+    }
+    // A virtual stream resumes somewhere in the middle of its sound once it becomes real again, so
+    // it fades in from silence rather than starting at full gain.
+    fVoices.lastGainLeft[slot] = isVirtual ? 0.f : volumeLeft;
+    fVoices.lastGainRight[slot] = isVirtual ? 0.f : volumeRight;
+    if (frames > 0) {
+        gains.leftStep = (volumeLeft - gains.left) / static_cast<float>(frames);
+        gains.rightStep = (volumeRight - gains.right) / static_cast<float>(frames);
+    }
+
+    // Mixes frames [first, end) of the block.
+    auto mixFrames = [&](const int first, const int end, MixGain gainType, MixGains g) {
+        if (first >= end or isVirtual) {
+            return;
+        }
+        const auto offset = static_cast<float>(first);
+        g.left += g.leftStep * offset;
+        g.right += g.rightStep * offset;
+        g.fade += g.fadeStep * offset;
+        const float lastLeft = g.left + g.leftStep * static_cast<float>(end - first);
+        const float lastRight = g.right + g.rightStep * static_cast<float>(end - first);
         // Avoid mixing on zero volume.
-        if (not stream->d->fIsMuted and (volumeLeft > 0.f or volumeRight > 0.f)) {
-            // Avoid scaling operation when volume is 1.
-            if (fAudioSpec.channels > 1 and (volumeLeft != 1.f or volumeRight != 1.f)) {
-                for (int i = out_offset; i < cur_pos; i += 2) {
-                    fFinalMixBuf[i] += fStrmBuf[i] * volumeLeft;
-                    fFinalMixBuf[i + 1] += fStrmBuf[i + 1] * volumeRight;
-                }
-            } else if (volumeLeft != 1.f) {
-                for (int i = out_offset; i < cur_pos; ++i) {
-                    fFinalMixBuf[i] += fStrmBuf[i] * volumeLeft;
-                }
-            } else {
-                for (int i = out_offset; i < cur_pos; ++i) {
-                    fFinalMixBuf[i] += fStrmBuf[i];
-                }
+        if (g.left <= 0.f and g.right <= 0.f and lastLeft <= 0.f and lastRight <= 0.f) {
+            return;
+        }
+        if (gainType != MixGain::Fade) {
+            if (g.leftStep != 0.f or g.rightStep != 0.f) {
+                gainType = MixGain::Ramp;
+            } else if (g.left == 1.f and g.right == 1.f) {
+                // Avoid scaling operation when volume is 1.
+                gainType = MixGain::Unity;
             }
         }
+        const int pos = out_offset + first * channels;
+        const int srcPos = (firstFrame + first) * mixSrcChannels - mixSrcStart;
+        if (mixSrcChannels != channels) {
+            upmixKernelFor(gainType)(mixBuf + pos, mixSrc + srcPos, end - first, g);
+            return;
+        }
+        const bool panned = channels > 1 and (g.left != g.right or g.leftStep != g.rightStep);
+        mixKernelFor(channels, gainType, panned)(mixBuf + pos, mixSrc + srcPos, end - first, g);
+    };
+
+    // Whatever comes after the end of a fade-out is silent.
+    const int fadeEnd = std::min(fadeFrames, frames);
+    mixFrames(0, fadeEnd, MixGain::Fade, gains);
+    if (not fadeOutEnded) {
+        // Outside of fades, the internal volume is always 0 or 1.
+        const float level = stream->d->fInternalVolume;
+        MixGains steady = gains;
+        steady.left *= level;
+        steady.right *= level;
+        steady.leftStep *= level;
+        steady.rightStep *= level;
+        mixFrames(fadeEnd, frames, MixGain::Constant, steady);
+    } else if (stream->d->fStopAfterFade) {
+        stream->d->fStopAfterFade = false;
+        stream->d->fStop();
+        has_finished = true;
+    } else {
+        stream->d->fSetPaused(true);
+        lane.paused.push_back(stream);
+    }
 
-        if (has_finished) {
+    // Callbacks are invoked by the audio callback thread once all lanes are done.
+    if (has_finished) {
+        lane.finished.push_back(stream);
+    } else if (has_looped) {
+        lane.looped.push_back(stream);
+    }
+}
+
+void Aulib::Stream_priv::fMixLane(const int laneIndex)
+{
+    MixLane& lane = *fMixLanes[laneIndex];
+    AM_rtScope();
+    AM_traceScope("mix lane", nullptr);
+
+    // Fill with silence.
+    std::fill(lane.mixBuf.begin(), lane.mixBuf.begin() + fMixLenSamples, 0.f);
+    std::fill(lane.busUsed.begin(), lane.busUsed.end(), false);
+
+    // Lanes grab streams one at a time, so that a few expensive streams don't hold up the rest.
+    const auto& active = fVoices.activeSlots();
+    const int streamCount = static_cast<int>(active.size());
+    for (int i = fNextMixStream++; i < streamCount; i = fNextMixStream++) {
+        fMixStream(active[i], lane);
+    }
+}
+
+auto Aulib::Stream_priv::fNowFrame() -> Uint64
+{
+    if (fOffline or fMixedFrames == 0) {
+        return fMixedFrames;
+    }
+    // Never go past the end of the next block, in case the callback is late.
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+    const Uint64 perSecond = SDL_GetPerformanceFrequency();
+    const Uint64 elapsed = std::min(SDL_GetPerformanceCounter() - fLastCallbackTime, perSecond);
+#else
+    const Uint64 perSecond = 1000;
+    const Uint64 elapsed = std::min<Uint64>(SDL_GetTicks() - fLastCallbackTime, perSecond);
+#endif
+    const Uint64 frames = elapsed * static_cast<Uint64>(fAudioSpec.freq) / perSecond;
+    return fMixedFrames + std::min<Uint64>(frames, fAudioSpec.samples);
+}
+
+void Aulib::Stream_priv::fGrowMixBuffers(const int samples)
+{
+    // The buffers only ever grow, so that a device that varies the block size doesn't make us
+    // allocate again and again.
+    for (const auto& lane : fMixLanes) {
+        if (lane->strmBuf.size() < samples) {
+            lane->mixBuf.reset(samples);
+            lane->strmBuf.reset(samples);
+            lane->procBuf.reset(samples);
+            lane->layoutBuf.reset(samples);
+        }
+    }
+    fReserveBusBuffers();
+}
+
+void Aulib::Stream_priv::fMix(const int samples)
+{
+    AM_debugAssert(not fMixLanes.empty());
+
+    const int frames = samples / fAudioSpec.channels;
+
+    fApplyCommands();
+    fSelectRealVoices();
+
+    fMixLenSamples = samples;
+    // The block we're mixing ends at the current time.
+    fMixedFrames += frames;
+    fNextMixStream = 0;
+
+    // Only fork if there's enough streams to go around.
+    int laneCount = 1;
+    fMixing = true;
+    if (fMixLanes.size() > 1 and fVoices.activeSlots().size() > 1) {
+        laneCount = static_cast<int>(fMixLanes.size());
+        MixPool::run(fMixLane);
+    } else {
+        fMixLane(0);
+    }
+    fMixing = false;
+
+    // Take streams that stopped or paused off the active list before invoking any callbacks, since
+    // those might start them again.
+    for (int i = 0; i < laneCount; ++i) {
+        auto& lane = *fMixLanes[i];
+        for (const auto stream : lane.finished) {
+            fVoices.deactivate(stream->d->fSlot);
+        }
+        for (const auto stream : lane.paused) {
+            fVoices.deactivate(stream->d->fSlot);
+        }
+        lane.paused.clear();
+    }
+
+    // Sum the partial mixes pairwise into lane 0.
+    for (int stride = 1; stride < laneCount; stride *= 2) {
+        for (int i = 0; i + stride < laneCount; i += stride * 2) {
+            float* const dst = fMixLanes[i]->mixBuf.get();
+            const float* const src = fMixLanes[i + stride]->mixBuf.get();
+            for (int j = 0; j < samples; ++j) {
+                dst[j] += src[j];
+            }
+        }
+    }
+    Bus_priv::fMixBuses(laneCount, samples);
+
+    for (int i = 0; i < laneCount; ++i) {
+        auto& lane = *fMixLanes[i];
+        AM_rtContext("finish or loop callback", nullptr);
+        for (const auto stream : lane.finished) {
             stream->invokeFinishCallback();
-        } else if (has_looped) {
+        }
+        for (const auto stream : lane.looped) {
             stream->invokeLoopCallback();
         }
+        lane.finished.clear();
+        lane.looped.clear();
     }
-    Stream_priv::fSampleConverter(out, fFinalMixBuf);
+}
+
+void Aulib::Stream_priv::fSdlCallbackImpl(void* /*unused*/, Uint8 out[], int outLen)
+{
+    AM_debugAssert(Stream_priv::fSampleConverter);
+
+    const int out_len_samples = outLen / (SDL_AUDIO_BITSIZE(fAudioSpec.format) / 8);
+    AM_statsCallback(out_len_samples / fAudioSpec.channels, fAudioSpec.freq);
+    AM_traceThreadName("audio callback");
+    AM_traceScope("callback", nullptr);
+    fGrowMixBuffers(out_len_samples);
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+    fLastCallbackTime = SDL_GetPerformanceCounter();
+#else
+    fLastCallbackTime = SDL_GetTicks();
+#endif
+
+    AM_rtScope();
+
+    fMix(out_len_samples);
+    Stream_priv::fSampleConverter(out, fMixLanes[0]->mixBuf.get(), out_len_samples);
+
+    // Let the decode workers refill what we just consumed.
+    DecodePool::wake();
+}
+
+void Aulib::Stream_priv::fRender(float out[], const int frames)
+{
+    AM_traceScope("render", nullptr);
+    const int samples = frames * fAudioSpec.channels;
+    fGrowMixBuffers(samples);
+    fMix(samples);
+    std::memcpy(out, fMixLanes[0]->mixBuf.get(), samples * sizeof(*out));
 }
 
 /*
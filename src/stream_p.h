@@ -4,9 +4,15 @@
 #include "Aulib/Processor.h"
 #include "Aulib/Stream.h"
 #include "Buffer.h"
+#include "MpscQueue.h"
 #include "SdlMutex.h"
+#include "SpscRing.h"
+#include "VoiceTable.h"
 #include "aulib.h"
+#include "chanlayout.h"
+#include "mixstats.h"
 #include <SDL_audio.h>
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <vector>
@@ -14,7 +20,9 @@
 namespace Aulib {
 
 class Decoder;
+class DecoderPcm;
 class Resampler;
+struct Bus_priv;
 
 struct Stream_priv final
 {
@@ -30,46 +38,221 @@ struct Stream_priv final
     // Resamplers hold a reference to decoders, so we store it as a shared_ptr.
     std::shared_ptr<Decoder> fDecoder;
     std::unique_ptr<Resampler> fResampler;
-    bool fIsPlaying = false;
-    bool fIsPaused = false;
-    float fVolume = 1.f;
-    float fStereoPos = 0.f;
+    // Set when playing a PcmBuffer. Points to fDecoder.
+    DecoderPcm* fPcmDecoder = nullptr;
+    // Channels of the samples we decode. Sources with fewer channels than the device stay that way
+    // and are only converted to the device's layout when mixed. Mono on a stereo device is
+    // expanded by the mix kernel itself, which also applies the stereo position.
+    int fChannels = 0;
+    // Converts fChannels to the device's layout.
+    LayoutMatrix fLayout;
+    // Written with the audio device locked, read without locking by the getters. The mixer uses
+    // fVoices.paused instead.
+    std::atomic<bool> fIsPlaying{false};
+    std::atomic<bool> fIsPaused{false};
+    // Our slot in fVoices, which holds the volume, stereo position and mute state as applied by
+    // the audio callback, as well as the playback state the mixer checks on every block.
+    int fSlot;
+    // Generation of our slot. It only changes when the slot is freed, so it is read once on
+    // construction, and commands can be built without touching fVoices.
+    Uint32 fGeneration;
     float fInternalVolume = 1.f;
-    int fCurrentIteration = 0;
-    int fWantedIterations = 0;
-    int fPlaybackStartTick = 0;
-    int fFadeInStartTick = 0;
-    int fFadeOutStartTick = 0;
-    bool fStarting = false;
     bool fFadingIn = false;
     bool fFadingOut = false;
     bool fStopAfterFade = false;
-    std::chrono::milliseconds fFadeInDuration{};
-    std::chrono::milliseconds fFadeOutDuration{};
+    // Length of the current fade and how far into it we are, in output frames.
+    int fFadeFrames = 0;
+    int fFadePos = 0;
+    // Playback position within the current iteration and length of the stream, in output frames.
+    // Streams with an unknown length are never made virtual, since we couldn't tell when they end.
+    // Not tracked with decode-ahead.
+    Sint64 fPosFrames = 0;
+    Sint64 fDurationFrames = 0;
+    // The stream was virtual, so the decoder needs to catch up with fPosFrames.
+    bool fNeedsSeek = false;
     std::vector<std::shared_ptr<Processor>> processors;
-    bool fIsMuted = false;
+#if ENABLE_MIXER_STATS
+    MixStats::StreamCounters fStats;
+#endif
+    // Values as last set through the public API. These might not have been applied yet.
+    std::atomic<float> fTargetVolume{1.f};
+    std::atomic<float> fTargetStereoPos{0.f};
+    std::atomic<bool> fTargetMuted{false};
+    std::atomic<int> fTargetPriority{0};
+    std::atomic<Bus*> fTargetBus{nullptr};
+    // Mirrors fVoices.isVirtual for the getter. Updated at the start of every block.
+    std::atomic<bool> fIsVirtual{false};
     Stream::Callback fFinishCallback;
     Stream::Callback fLoopCallback;
 
+    /*
+     * Decode-ahead. When enabled, the decoder and resampler run in the DecodePool worker threads
+     * and the audio callback only copies already resampled samples out of fRing. Everything the
+     * workers touch is protected by fDecodeMutex rather than the SDL audio lock.
+     */
+    int fDecodeAheadFrames = 0;
+    bool fInDecodePool = false;
+    SpscRing<float> fRing{0};
+    // Ring positions (in samples) at which the decoder reached the end of the stream.
+    SpscRing<Uint64> fLoopEnds{16};
+    SdlMutex fDecodeMutex;
+    std::atomic<bool> fProducerActive{false};
+    std::atomic<bool> fProducerFinished{false};
+    // Set by the worker that is currently filling this stream.
+    std::atomic<bool> fBusy{false};
+    std::atomic<int> fUnderruns{0};
+    // The producer's own view of the iteration counts in fVoices.
+    int fProducerIterations = 0;
+    int fProducerWantedIterations = 0;
+    Uint64 fLastLoopEnd = 0;
+    // The decoder needs to be rewound before it's used again. Set when stopping from the audio
+    // thread, where we can't touch the decoder while a worker might be using it.
+    bool fResetPending = false;
+
     static ::SDL_AudioSpec fAudioSpec;
 #if SDL_VERSION_ATLEAST(2, 0, 0)
     static SDL_AudioDeviceID fDeviceId;
 #endif
-    static std::vector<Stream*> fStreamList;
-    static SdlMutex fStreamListMutex;
+    static VoiceTable fVoices;
+
+    /*
+     * Parameter changes are queued here instead of locking the audio device, and are applied by
+     * the audio callback at the start of each block. A command with a batchSize larger than 1 is
+     * followed by the rest of its batch, which is only applied once it has been pushed completely.
+     */
+    struct Command final
+    {
+        enum class Type
+        {
+            Volume,
+            StereoPos,
+            Mute,
+            Priority,
+            Bus,
+        };
+
+        // The stream is identified by its slot in fVoices. Commands for a stream that has been
+        // deleted since are recognized by the slot's generation and skipped.
+        int slot;
+        Uint32 generation;
+        Type type;
+        // A bus is identified the same way, by its slot in Bus_priv::fBuses and that slot's
+        // generation. A slot of -1 means the master output.
+        struct BusRef final
+        {
+            int slot;
+            Uint32 generation;
+        };
+
+        // Priority uses intValue, Bus uses bus, everything else value.
+        union
+        {
+            float value;
+            int intValue;
+            BusRef bus;
+        };
+        int batchSize;
+    };
+    static MpscQueue<Command> fCommands;
 
     // This points to an appropriate converter for the current audio format.
-    static void (*fSampleConverter)(Uint8[], const Buffer<float>& src);
+    static void (*fSampleConverter)(Uint8[], const float[], int);
+
+    // Sample buffers we use during decoding and mixing. Each mixing thread has its own lane. Lane 0
+    // is used by the audio callback thread itself and receives the final mix.
+    struct MixLane final
+    {
+        Buffer<float> mixBuf{0};
+        Buffer<float> strmBuf{0};
+        Buffer<float> procBuf{0};
+        // Streams whose channels differ from the output are converted into this before mixing.
+        Buffer<float> layoutBuf{0};
+        // One buffer per bus slot, each as large as strmBuf. A lane only clears the buffer of a
+        // bus once it mixes a stream into it, and marks it as used.
+        Buffer<float> busBuf{0};
+        std::vector<Uint8> busUsed;
+
+        auto busBuffer(const int busSlot) noexcept -> float*
+        {
+            return busBuf.get() + busSlot * strmBuf.size();
+        }
 
-    // Sample buffers we use during decoding and mixing.
-    static Buffer<float> fFinalMixBuf;
-    static Buffer<float> fStrmBuf;
-    static Buffer<float> fProcessorBuf;
+        // Streams that finished, looped or got paused while mixing this lane. These are reserved
+        // to the capacity of fVoices, so they never allocate.
+        std::vector<Stream*> finished;
+        std::vector<Stream*> looped;
+        std::vector<Stream*> paused;
+    };
+    static std::vector<std::unique_ptr<MixLane>> fMixLanes;
 
-    auto fProcessFadeAndCheckIfFinished() -> bool;
+    // State of the block currently being mixed. While fMixing is set, streams are not removed from
+    // the active voice list, since other lanes might be iterating over it.
+    static bool fMixing;
+    static std::atomic<int> fNextMixStream;
+    static int fMixLenSamples;
+
+    // The sample clock. Counts the frames mixed so far, with the block being mixed ending at the
+    // current time. Between blocks, the clock is interpolated from the wall clock time of the last
+    // audio callback, except when rendering offline.
+    static Uint64 fMixedFrames;
+    static Uint64 fLastCallbackTime;
+
+    // Maximum amount of streams that are decoded and mixed. 0 means no limit.
+    static std::atomic<int> fMaxRealVoices;
+    // Scratch space for picking the real voices, as large as fVoices.
+    static std::vector<int> fVoiceRank;
+
+    // Set when initialized without output, in which case the application pulls the mix through
+    // renderMix(). Time then advances with the amount of rendered frames rather than the wall
+    // clock, and fRenderMutex stands in for the audio device lock.
+    static bool fOffline;
+    static SdlMutex fRenderMutex;
+
+    void fStartFade(bool fadeIn, std::chrono::microseconds duration);
+    auto fAdvanceFade(int frames, int& fadeFrames, float& curvePos, float& curveStep) -> bool;
+    void fSetPaused(bool paused);
     void fStop();
+    auto fFinishIteration(bool& hasLooped) -> bool;
+    auto fAudibility() const -> float;
+    auto fAdvanceVirtual(int frames, bool& hasLooped) -> bool;
+    void fCatchUpWithVirtualPos();
 
+    void fStartDecodeAhead(int iterations);
+    void fEndDecodeAhead();
+    void fFlushDecodeAhead();
+    auto fDecodeAheadStarvation() const -> int;
+    void fFillDecodeAhead();
+    auto fReadDecodeAhead(float dst[], int len, bool& hasFinished, bool& hasLooped) -> int;
+
+    void fPostCommand(Command::Type type, float value);
+    void fPostCommand(Command::Type type, int value);
+    void fPostCommand(Command::Type type, Command::BusRef bus);
+    static void fPostCommand(const Command& cmd);
+    void fDiscardBatchedCommands();
+    static void fApplyCommand(const Command& cmd);
+    static void fPostCommands(Command cmds[], int count);
+    static void fBeginBatch();
+    static void fEndBatch();
+
+    // Must be called with the audio device locked.
+    static void fApplyCommands();
+    static void fSetMixLaneCount(int count);
+    static void fReserveMixLists();
+    static void fReserveBusBuffers();
+    // Routes everything that goes to 'bus' to the master output.
+    static void fUnrouteBus(const Bus_priv& bus);
+    static void fSelectRealVoices();
+#if ENABLE_MIXER_STATS
+    static void fResetStats();
+#endif
+    static void fMixStream(int slot, MixLane& lane);
+    static void fMixLane(int laneIndex);
+    static auto fNowFrame() -> Uint64;
+    static void fGrowMixBuffers(int samples);
+    // Mixes all active streams into the mix buffer of lane 0.
+    static void fMix(int samples);
     static void fSdlCallbackImpl(void* /*unused*/, Uint8 out[], int outLen);
+    static void fRender(float out[], int frames);
 };
 
 } // namespace Aulib
@@ -0,0 +1,239 @@
+// This is copyrighted software. More information is at the end of this file.
+#include "trace.h"
+
+#include "aulib.h"
+#include <SDL_error.h>
+#include <SDL_rwops.h>
+#if ENABLE_TRACING
+#    include <algorithm>
+#    include <atomic>
+#    include <chrono>
+#    include <cstdlib>
+#    include <fmt/core.h>
+#    include <vector>
+#    if defined(__GNUG__)
+#        include <cxxabi.h>
+#    endif
+#endif
+
+#if ENABLE_TRACING
+namespace {
+
+constexpr int MAX_THREADS = 32;
+constexpr int EVENTS_PER_THREAD = 8192;
+
+struct Event final
+{
+    Uint64 start;
+    Uint64 end;
+    const char* name;
+    const char* detail;
+};
+
+/*
+ * Only the owning thread writes events. It fills in the next event and then bumps the count, so a
+ * reader knows which events are complete. A reader can still race with the owner overwriting the
+ * oldest events while it copies them; it checks the count again afterwards and drops those.
+ */
+struct ThreadBuffer final
+{
+    std::atomic<bool> owned{false};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<Uint64> count{0};
+    Event events[EVENTS_PER_THREAD];
+};
+
+// Static, so that there's nothing to allocate. The pages are only touched by threads that record.
+ThreadBuffer gThreads[MAX_THREADS];
+
+// Gives the thread's buffer back when it exits. Its events are kept until the next thread that
+// gets the buffer overwrites them.
+struct Owner final
+{
+    ThreadBuffer* buffer = nullptr;
+    bool noneLeft = false;
+
+    ~Owner()
+    {
+        if (buffer) {
+            buffer->owned.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local Owner tOwner;
+
+auto bufferOfThisThread() noexcept -> ThreadBuffer*
+{
+    if (tOwner.buffer or tOwner.noneLeft) {
+        return tOwner.buffer;
+    }
+    for (auto& buf : gThreads) {
+        if (not buf.owned.exchange(true, std::memory_order_acquire)) {
+            buf.name.store(nullptr, std::memory_order_relaxed);
+            tOwner.buffer = &buf;
+            return tOwner.buffer;
+        }
+    }
+    tOwner.noneLeft = true;
+    return nullptr;
+}
+
+auto nowNs() noexcept -> Uint64
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+auto demangled(const char* name) -> std::string
+{
+#    if defined(__GNUG__)
+    int status = -1;
+    char* buf = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0) {
+        std::string ret = buf;
+        std::free(buf);
+        return ret;
+    }
+#    endif
+    return name;
+}
+
+auto jsonEscaped(const std::string& str) -> std::string
+{
+    std::string ret;
+    for (const char c : str) {
+        if (c == '"' or c == '\\') {
+            ret += '\\';
+        }
+        ret += c;
+    }
+    return ret;
+}
+
+} // namespace
+
+Aulib::Trace::Scope::Scope(const char* const name, const char* const detail) noexcept
+    : fName(name)
+    , fDetail(detail)
+    , fStart(nowNs())
+{}
+
+Aulib::Trace::Scope::~Scope()
+{
+    ThreadBuffer* const buf = bufferOfThisThread();
+    if (not buf) {
+        return;
+    }
+    const Uint64 n = buf->count.load(std::memory_order_relaxed);
+    buf->events[n % EVENTS_PER_THREAD] = {fStart, nowNs(), fName, fDetail};
+    buf->count.store(n + 1, std::memory_order_release);
+}
+
+void Aulib::Trace::setThreadName(const char* const name) noexcept
+{
+    if (ThreadBuffer* const buf = bufferOfThisThread()) {
+        buf->name.store(name, std::memory_order_relaxed);
+    }
+}
+#endif
+
+auto Aulib::writeTrace([[maybe_unused]] const std::string& filename) -> bool
+{
+#if ENABLE_TRACING
+    struct ThreadEvents final
+    {
+        int tid;
+        const char* name;
+        std::vector<Event> events;
+    };
+
+    std::vector<ThreadEvents> threads;
+    Uint64 firstStart = ~Uint64{0};
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        ThreadBuffer& buf = gThreads[i];
+        const Uint64 end = buf.count.load(std::memory_order_acquire);
+        if (end == 0) {
+            continue;
+        }
+        const Uint64 begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+        ThreadEvents thread{i + 1, buf.name.load(std::memory_order_relaxed), {}};
+        thread.events.reserve(end - begin);
+        for (Uint64 n = begin; n < end; ++n) {
+            thread.events.push_back(buf.events[n % EVENTS_PER_THREAD]);
+        }
+        // Drop what the owner overwrote while we were copying.
+        const Uint64 newEnd = buf.count.load(std::memory_order_acquire);
+        if (newEnd > EVENTS_PER_THREAD and newEnd - EVENTS_PER_THREAD > begin) {
+            const Uint64 lost = std::min(newEnd - EVENTS_PER_THREAD - begin, end - begin);
+            thread.events.erase(thread.events.begin(), thread.events.begin() + lost);
+        }
+        for (const auto& event : thread.events) {
+            firstStart = std::min(firstStart, event.start);
+        }
+        threads.push_back(std::move(thread));
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    const auto append = [&](const std::string& line) {
+        if (not first) {
+            json += ",\n";
+        }
+        first = false;
+        json += line;
+    };
+    for (const auto& thread : threads) {
+        const std::string threadName = thread.name ? thread.name
+                                                   : fmt::format("thread {}", thread.tid);
+        append(fmt::format(
+            R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})",
+            thread.tid, jsonEscaped(threadName)));
+        for (const auto& event : thread.events) {
+            const std::string name = event.detail ? demangled(event.detail) : event.name;
+            append(fmt::format(R"({{"name":"{}","cat":"{}","ph":"X","pid":1,"tid":{},)"
+                               R"("ts":{:.3f},"dur":{:.3f}}})",
+                               jsonEscaped(name), event.name, thread.tid,
+                               (event.start - firstStart) / 1000.,
+                               (event.end - event.start) / 1000.));
+        }
+    }
+    json += "\n]}\n";
+
+    SDL_RWops* rwops = SDL_RWFromFile(filename.c_str(), "wb");
+    if (not rwops) {
+        return false;
+    }
+    const bool ok = SDL_RWwrite(rwops, json.data(), 1, json.size()) == json.size();
+    if (SDL_RWclose(rwops) != 0 or not ok) {
+        SDL_SetError("Failed to write trace to \"%s\".", filename.c_str());
+        return false;
+    }
+    return true;
+#else
+    SDL_SetError("SDL_audiolib was built without ENABLE_TRACING.");
+    return false;
+#endif
+}
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/
@@ -0,0 +1,71 @@
+// This is copyrighted software. More information is at the end of this file.
+#pragma once
+
+#include "aulib_config.h"
+
+/*
+ * Trace points for the audio pipeline, written out with Aulib::writeTrace(). Only compiled in when
+ * the library is built with ENABLE_TRACING. Otherwise, the macros below expand to nothing.
+ *
+ * AM_traceScope() records an event covering the rest of the enclosing block. 'name' must be a
+ * string literal. 'detail' is a type name as returned by std::type_info::name(), or null.
+ * AM_traceThreadName() names the calling thread in the trace. 'name' must be a string literal.
+ *
+ * Each thread records into its own ring buffer that only holds the most recent events, so
+ * recording never allocates, locks or waits for anything.
+ */
+#if ENABLE_TRACING
+#    include "aulib_global.h"
+#    include <SDL_stdinc.h>
+#    include <typeinfo>
+
+namespace Aulib {
+namespace Trace {
+
+class AULIB_NO_EXPORT Scope final
+{
+public:
+    Scope(const char* name, const char* detail) noexcept;
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    auto operator=(const Scope&) -> Scope& = delete;
+
+private:
+    const char* fName;
+    const char* fDetail;
+    Uint64 fStart;
+};
+
+AULIB_NO_EXPORT void setThreadName(const char* name) noexcept;
+
+} // namespace Trace
+} // namespace Aulib
+
+#    define AM_traceScope(name, detail) const Aulib::Trace::Scope am_traceScope((name), (detail))
+#    define AM_traceThreadName(name) Aulib::Trace::setThreadName(name)
+#else
+#    define AM_traceScope(name, detail)
+#    define AM_traceThreadName(name)
+#endif
+
+/*
+
+Copyright (C) 2026 Nikos Chantziaras.
+
+This file is part of SDL_audiolib.
+
+SDL_audiolib is free software: you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the Free
+Software Foundation, either version 3 of the License, or (at your option) any
+later version.
+
+SDL_audiolib is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with SDL_audiolib. If not, see <http://www.gnu.org/licenses/>.
+
+*/